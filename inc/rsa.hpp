@@ -12,13 +12,38 @@
 #pragma once
 
 #include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <vector>
 
 #include "big_int.hpp"
 
+class rsa_thread_pool;
+
+enum class rsa_keygen_status {
+
+    RSA_KEYGEN_OK,
+    RSA_KEYGEN_TIMED_OUT,
+    RSA_KEYGEN_CANCELLED,
+    RSA_KEYGEN_ERROR
+
+};
+
 class rsa {
 
+    friend class rsa_batch;
+
 private:
+
+    /* Montgomery contexts from bi::big_int_montgomery_cache, the prime ones only for private keys. */
+    struct rsa_montgomery_ctxs {
+        std::shared_ptr<const bi::big_int_montgomery_ctx>   modulus_ctx;
+        std::shared_ptr<const bi::big_int_montgomery_ctx>   p_ctx;
+        std::shared_ptr<const bi::big_int_montgomery_ctx>   q_ctx;
+    };
+
     size_t          bit_size;
+    bool            has_private_key;
     bi::big_int     p;
     bi::big_int     q;
     bi::big_int     p_minus_1;
@@ -27,8 +52,46 @@ private:
     bi::big_int     p_minus_1q_minus_1;
     bi::big_int     e;
     bi::big_int     d;
-    bi::big_int     smaller_prime;
-    bi::big_int     reduced_d;
+    bi::big_int     d_mod_p_minus_1;
+    bi::big_int     d_mod_q_minus_1;
+    bi::big_int     q_inverse_mod_p;
+
+    /* Set when a key with a private part is built, imported public keys look their contexts up
+       on first use so keys that are never used cost nothing. Read and published through
+       std::atomic_load / std::atomic_compare_exchange_strong, copies take a consistent snapshot. */
+    struct rsa_montgomery_slot {
+        mutable std::shared_ptr<const rsa_montgomery_ctxs>  ctxs;
+
+        rsa_montgomery_slot() = default;
+        rsa_montgomery_slot(const rsa_montgomery_slot &other) : ctxs{std::atomic_load(&other.ctxs)} {}
+        rsa_montgomery_slot& operator=(const rsa_montgomery_slot &other) {
+            std::atomic_store(&ctxs, std::atomic_load(&other.ctxs));
+            return *this;
+        }
+    };
+
+    rsa_montgomery_slot montgomery_ctxs;
+
+    rsa();
+    int             _rsa_generate_keys(size_t bit_size_arg, int miller_rabin_rounds, int max_number_of_threads_for_miller_rabin, \
+        const bi::big_int_cancel_token &cancel_token, bi::big_int_random_source &random_source);
+    int             _rsa_init_from_primes(const bi::big_int &p_arg, const bi::big_int &q_arg, const bi::big_int &e_arg);
+    int             _rsa_init_crt_params();
+    std::shared_ptr<const rsa_montgomery_ctxs> _rsa_build_montgomery_ctxs() const;
+    void            _rsa_init_montgomery_ctxs();
+    const rsa_montgomery_ctxs& _rsa_get_montgomery_ctxs() const;
+    int             _rsa_encrypt(const bi::big_int &plain, bi::big_int &cipher, const rsa_montgomery_ctxs &ctxs) const;
+    int             _rsa_decrypt(const bi::big_int &cipher, bi::big_int &decipher, const rsa_montgomery_ctxs &ctxs) const;
+    /* result = base ^ x mod pq for the x with x = exponent_mod_p_minus_1 mod (p - 1) and 
+       x = exponent_mod_q_minus_1 mod (q - 1), two half size exponentiations and Garner's recombination. */
+    int             _rsa_crt_exponentiation(const bi::big_int &base, const bi::big_int &exponent_mod_p_minus_1, \
+        const bi::big_int &exponent_mod_q_minus_1, bi::big_int &result, const rsa_montgomery_ctxs &ctxs) const;
+    /* result = m2 + (q^-1 * (m1 - m2) mod p) * q for the halves m1 mod p and m2 mod q. */
+    int             _rsa_crt_recombine(const bi::big_int &m1, const bi::big_int &m2, bi::big_int &result) const;
+    static int      _rsa_factor_modulus(const bi::big_int &n, const bi::big_int &e_arg, const bi::big_int &d_arg, \
+        bi::big_int &op_p, bi::big_int &op_q);
+    /* Throws std::invalid_argument unless n is odd and positive and 1 < e < n. */
+    static void     _rsa_validate_public_key(const bi::big_int &modulus, const bi::big_int &public_key);
 
 public:
 
@@ -41,12 +104,91 @@ public:
     */
     rsa(size_t bit_size, int miller_rabin_rounds = 20, int max_number_of_threads_for_miller_rabin = -1);
 
-    int             rsa_encrypt(bi::big_int &plain, bi::big_int &cipher);
-    int             rsa_decrypt_textbook_method(bi::big_int &cipher, bi::big_int &decipher);
-    int             rsa_decrypt(bi::big_int &cipher, bi::big_int &decipher);
-    bi::big_int     get_public_key(); 
-    bi::big_int     get_private_key(); 
-    bi::big_int     get_modulus();
+    /*  random_source                           ==> source of the prime candidates, a bi::big_int_seeded_drbg
+                                                    reproduces the same key for the same seed at any thread count 
+                                                    (benchmarking only). */
+    rsa(size_t bit_size, bi::big_int_random_source &random_source, int miller_rabin_rounds = 20, \
+        int max_number_of_threads_for_miller_rabin = -1);
+
+    /*  Key generation that gives up instead of blocking indefinitely. On RSA_KEYGEN_OK op_rsa holds 
+        the new key, otherwise it is left empty. time_budget is measured from the call, cancel_token
+        lets another thread abort the generation (its deadline, if any, also applies). */
+    static rsa_keygen_status rsa_generate(std::unique_ptr<rsa> &op_rsa, size_t bit_size, std::chrono::milliseconds time_budget, \
+        int miller_rabin_rounds = 20, int max_number_of_threads_for_miller_rabin = -1);
+    static rsa_keygen_status rsa_generate(std::unique_ptr<rsa> &op_rsa, size_t bit_size, const bi::big_int_cancel_token &cancel_token, \
+        int miller_rabin_rounds = 20, int max_number_of_threads_for_miller_rabin = -1);
+    static rsa_keygen_status rsa_generate(std::unique_ptr<rsa> &op_rsa, size_t bit_size, const bi::big_int_cancel_token &cancel_token, \
+        bi::big_int_random_source &random_source, int miller_rabin_rounds = 20, int max_number_of_threads_for_miller_rabin = -1);
+
+    /*  Key import without any prime search, all of them throw std::invalid_argument on inconsistent input.
+        
+        rsa_import_public_key               ==> public key only, rsa_encrypt works, the decrypt and 
+                                                get_private_key calls throw std::logic_error
+        rsa_import_private_key_from_primes  ==> full key pair from the primes p, q and public key e
+        rsa_import_private_key              ==> full key pair from modulus n and exponents e, d, 
+                                                n is factored using e * d - 1
+    */
+    static std::unique_ptr<rsa> rsa_import_public_key(const bi::big_int &modulus, const bi::big_int &public_key);
+    static std::unique_ptr<rsa> rsa_import_private_key_from_primes(const bi::big_int &prime_p, const bi::big_int &prime_q, \
+        const bi::big_int &public_key);
+    static std::unique_ptr<rsa> rsa_import_private_key(const bi::big_int &modulus, const bi::big_int &public_key, \
+        const bi::big_int &private_key);
+
+    bool            rsa_has_private_key() const;
+
+    /*  Versioned binary key blob (little endian), holds the raw limbs of n, e and for private keys 
+        p, q, d, the CRT values and the Montgomery constants of n, p and q, so loading a key
+        skips the prime and Montgomery setup, only the consistency checks are redone. rsa_deserialize
+        throws std::invalid_argument on a malformed or unsupported blob, or if the values do not
+        belong to one key. */
+    int             rsa_serialize(std::vector<uint8_t> &op_blob) const;
+    static std::unique_ptr<rsa> rsa_deserialize(const uint8_t *blob, size_t blob_size);
+
+    /*  Thread safety: every const member is reentrant, one key can serve any number of threads
+        without locking. The Montgomery contexts are looked up at most once per key and then only
+        read, keys with the same modulus share them. The exponentiation scratch is per thread and
+        everything else lives on the caller's stack.
+        Only construction, assignment and destruction need exclusive access. */
+    int             rsa_encrypt(const bi::big_int &plain, bi::big_int &cipher) const;
+    int             rsa_decrypt_textbook_method(const bi::big_int &cipher, bi::big_int &decipher) const;
+    int             rsa_decrypt(const bi::big_int &cipher, bi::big_int &decipher) const;
+
+    /*  Latency mode of rsa_decrypt for idle cores: the two half size CRT exponentiations (mod p and
+        mod q) run concurrently, one on pool (rsa_thread_pool::rsa_thread_pool_default() if nullptr)
+        and one on the calling thread, which also takes both if the pool is busy. Keys with a modulus 
+        shorter than min_parallel_bits decrypt sequentially, below that the hand off costs more
+        than it saves. Results and errors are those of rsa_decrypt. */
+    static constexpr size_t RSA_PARALLEL_CRT_DEFAULT_MIN_BITS = 2048;
+    int             rsa_decrypt_parallel_crt(const bi::big_int &cipher, bi::big_int &decipher, rsa_thread_pool *pool = nullptr, \
+        size_t min_parallel_bits = RSA_PARALLEL_CRT_DEFAULT_MIN_BITS) const;
+
+    /*  Byte oriented variants, input and output are unsigned big endian numbers. The output is always 
+        written as exactly rsa_get_modulus_bytes() bytes (zero padded on the left), op_size must be at least
+        that. Returns -1 if the output buffer is too small, throws like the big_int variants otherwise. */
+    int             rsa_encrypt(const uint8_t *plain, size_t plain_size, uint8_t *op_cipher, size_t op_size) const;
+    int             rsa_decrypt(const uint8_t *cipher, size_t cipher_size, uint8_t *op_decipher, size_t op_size) const;
+    size_t          rsa_get_modulus_bytes() const;
+
+    /*  Batch variants, message i of the input gives entry i of the output. The batch is split into
+        ranges run on pool (rsa_thread_pool::rsa_thread_pool_default() if nullptr) and on the calling
+        thread; the Montgomery contexts of the key are shared and every thread reuses its own 
+        exponentiation scratch. Returns -1 if any message failed, invalid input throws like the 
+        single message calls (after the ranges already running have finished).
+        
+        Byte batches hold count messages back to back, in_stride bytes per input message and 
+        rsa_get_modulus_bytes() bytes per output message. */
+    int             rsa_encrypt_batch(const bi::big_int *plain, bi::big_int *op_cipher, size_t count, \
+        rsa_thread_pool *pool = nullptr) const;
+    int             rsa_decrypt_batch(const bi::big_int *cipher, bi::big_int *op_decipher, size_t count, \
+        rsa_thread_pool *pool = nullptr) const;
+    int             rsa_encrypt_batch(const uint8_t *plain, size_t in_stride, uint8_t *op_cipher, size_t count, \
+        rsa_thread_pool *pool = nullptr) const;
+    int             rsa_decrypt_batch(const uint8_t *cipher, size_t in_stride, uint8_t *op_decipher, size_t count, \
+        rsa_thread_pool *pool = nullptr) const;
+
+    bi::big_int     get_public_key() const; 
+    bi::big_int     get_private_key() const; 
+    bi::big_int     get_modulus() const;
 
 };
 
@@ -0,0 +1,116 @@
+/**
+ *  @file   rsa_async.hpp
+ *  @brief  Header file for the asynchronous RSA calls
+ *
+ *  Non blocking key generation, prime generation, encryption and decryption
+ *  run on an rsa_thread_pool, completed through a callback or a future.
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "rsa.hpp"
+#include "rsa_thread_pool.hpp"
+
+/*  Outcome of an asynchronous call.
+
+    status  ==> 0 on success, BI_STATUS_CANCELLED / BI_STATUS_TIMED_OUT if it was cancelled
+                before or while running, otherwise what the synchronous call returned
+                (-1 if it threw)
+    value   ==> the key, prime, cipher or decipher, valid only if status is 0
+    error   ==> the exception the synchronous call threw, if any
+*/
+template <typename T>
+struct rsa_async_result {
+
+    int                     status;
+    T                       value;
+    std::exception_ptr      error;
+
+};
+
+/* Cancels one asynchronous call, copies refer to the same call. */
+class rsa_async_handle {
+
+    friend class rsa_async;
+
+private:
+
+    std::shared_ptr<bi::big_int_cancel_token>   cancel_token;
+
+    explicit rsa_async_handle(std::shared_ptr<bi::big_int_cancel_token> token);
+
+public:
+
+    /*  A call still queued completes with BI_STATUS_CANCELLED without running, a running one
+        stops at its next cancellation point. The completion is delivered either way. */
+    void            rsa_async_cancel() const;
+    bool            rsa_async_cancelled() const;
+
+};
+
+template <typename T>
+struct rsa_async_future {
+
+    std::future<rsa_async_result<T>>    result;
+    rsa_async_handle                    handle;
+
+};
+
+/*  Asynchronous versions of the long running rsa calls for event loops that must not block.
+
+    Each call copies its input, queues the work on pool (rsa_thread_pool::rsa_thread_pool_default()
+    if nullptr) and returns straight away. The callback flavour runs on_done on the worker thread
+    that finished the call, it must not throw and should only hand the result back to its own loop
+    (or resume the coroutine waiting for it). The future flavour makes the result ready instead.
+    Keys are shared with the running call through the shared_ptr, the synchronous API is untouched.
+    C++17 has no coroutines, an awaiter for a C++20 caller is a thin wrapper resuming its
+    coroutine_handle from on_done. */
+class rsa_async {
+
+public:
+
+    template <typename T>
+    using completion = std::function<void(rsa_async_result<T> &&result)>;
+
+    /* See rsa::rsa_generate, the key comes back in value. */
+    static rsa_async_handle rsa_async_generate(size_t bit_size, completion<std::unique_ptr<rsa>> on_done, \
+        rsa_thread_pool *pool = nullptr, int miller_rabin_rounds = 20, int max_number_of_threads_for_miller_rabin = -1);
+    static rsa_async_future<std::unique_ptr<rsa>> rsa_async_generate(size_t bit_size, rsa_thread_pool *pool = nullptr, \
+        int miller_rabin_rounds = 20, int max_number_of_threads_for_miller_rabin = -1);
+
+    /* See bi::big_int::big_int_get_random_unsigned_prime_rabin_miller_threaded. */
+    static rsa_async_handle rsa_async_generate_prime(int bits, completion<bi::big_int> on_done, rsa_thread_pool *pool = nullptr, \
+        int miller_rabin_rounds = 20, int no_of_threads = 1);
+    static rsa_async_future<bi::big_int> rsa_async_generate_prime(int bits, rsa_thread_pool *pool = nullptr, \
+        int miller_rabin_rounds = 20, int no_of_threads = 1);
+
+    /* See rsa::rsa_encrypt and rsa::rsa_decrypt. */
+    static rsa_async_handle rsa_async_encrypt(std::shared_ptr<const rsa> key, const bi::big_int &plain, \
+        completion<bi::big_int> on_done, rsa_thread_pool *pool = nullptr);
+    static rsa_async_future<bi::big_int> rsa_async_encrypt(std::shared_ptr<const rsa> key, const bi::big_int &plain, \
+        rsa_thread_pool *pool = nullptr);
+    static rsa_async_handle rsa_async_decrypt(std::shared_ptr<const rsa> key, const bi::big_int &cipher, \
+        completion<bi::big_int> on_done, rsa_thread_pool *pool = nullptr);
+    static rsa_async_future<bi::big_int> rsa_async_decrypt(std::shared_ptr<const rsa> key, const bi::big_int &cipher, \
+        rsa_thread_pool *pool = nullptr);
+
+private:
+
+    /* op(value, token) does the work with token installed on the worker, returns its status. */
+    template <typename T>
+    static rsa_async_handle _rsa_async_post(rsa_thread_pool *pool, \
+        std::function<int(T &value, const bi::big_int_cancel_token &token)> op, completion<T> on_done);
+    template <typename T>
+    static rsa_async_future<T> _rsa_async_to_future(const std::function<rsa_async_handle(completion<T>)> &start);
+
+};
@@ -0,0 +1,90 @@
+/**
+ *  @file   rsa_batch.hpp
+ *  @brief  Header file for Fiat batch RSA decryption
+ *
+ *  One modulus, a distinct small public exponent per batch slot, and a
+ *  product tree that turns a whole batch of decryptions into a single
+ *  full size private exponentiation.
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "rsa.hpp"
+
+/*  Fiat batch RSA [A. Fiat, Batch RSA, Crypto '89]
+
+    Slot i of the batch has the public key (n, e_i), the e_i being distinct small odd primes
+    coprime to (p - 1)(q - 1), so E = e_1 * ... * e_b is invertible mod (p - 1)(q - 1).
+
+    For ciphers c_i = m_i ^ e_i mod n:
+        up the tree     ==> v = c_1 ^ (E / e_1) * ... * c_b ^ (E / e_b) mod n, every internal node
+                            combining its children as v_L ^ E_R * v_R ^ E_L
+        root            ==> X = v ^ (1 / E) = m_1 * ... * m_b mod n, the one full size (CRT) private
+                            exponentiation of the batch
+        down the tree   ==> split X = x_L * x_R with t = 0 mod E_L, t = 1 mod E_R:
+                            X ^ t = v_L ^ (t / E_L) * v_R ^ ((t - 1) / E_R) * x_R, costing small
+                            exponentiations and one modular inverse per tree level
+
+    Senders must encrypt for slot i with rsa_batch_get_public_key(i), the batch key is only
+    meant for this scheme. Not for padding free use in production: like textbook RSA the
+    messages need a proper padding scheme on top. */
+class rsa_batch {
+
+private:
+
+    /* Node of the split tree over slots [lo, hi), children are the halves. */
+    struct batch_node {
+        size_t          lo;
+        size_t          hi;
+        size_t          left;
+        size_t          right;
+        bi::big_int     exponent;           /* Product of the e_i under this node. */
+        bi::big_int     u;                  /* E_L ^ -1 mod E_R, the split exponent is t = E_L * u */
+        bi::big_int     w;                  /* (t - 1) / E_R */
+        bi::big_int     t_minus_1;
+    };
+
+    rsa                             key;
+    std::vector<bi::big_int>        public_exponents;
+    std::vector<bi::big_int>        slot_d_mod_p_minus_1;
+    std::vector<bi::big_int>        slot_d_mod_q_minus_1;
+    std::vector<batch_node>         nodes;
+    bi::big_int                     root_d_mod_p_minus_1;
+    bi::big_int                     root_d_mod_q_minus_1;
+
+    size_t          _rsa_batch_build_tree(size_t lo, size_t hi);
+    int             _rsa_batch_up(size_t node_idx, const bi::big_int *ciphers, std::vector<bi::big_int> &node_values, \
+        const bi::big_int_montgomery_ctx &modulus_ctx) const;
+    int             _rsa_batch_down(const bi::big_int &root_x, const std::vector<bi::big_int> &node_values, \
+        bi::big_int *op_plains, const bi::big_int_montgomery_ctx &modulus_ctx) const;
+    int             _rsa_batch_decrypt_slot(size_t slot, const bi::big_int &cipher, bi::big_int &op_plain) const;
+
+public:
+
+    /*  private_key     ==> full key pair, only its primes are used (copied)
+        batch_size      ==> number of slots, 2 to RSA_BATCH_MAX_SIZE
+        Throws std::logic_error for a public only key, std::invalid_argument for a batch size out of range. */
+    rsa_batch(const rsa &private_key, size_t batch_size);
+
+    static constexpr size_t     RSA_BATCH_MAX_SIZE      = 64;
+
+    size_t              rsa_batch_size() const;
+    /* e_i of slot, senders encrypt for that slot with (modulus, e_i). */
+    const bi::big_int&  rsa_batch_get_public_key(size_t slot) const;
+    bi::big_int         rsa_batch_get_modulus() const;
+    int                 rsa_batch_encrypt(size_t slot, const bi::big_int &plain, bi::big_int &op_cipher) const;
+
+    /*  op_plains[i] = decryption of ciphers[i] encrypted for slot i. A full batch (count equal to
+        rsa_batch_size()) takes the product tree path, a partial batch decrypts slot by slot.
+        A cipher sharing a factor with n also falls back to slot by slot decryption.
+        Throws std::invalid_argument if count is larger than the batch or a cipher is not below n. */
+    int                 rsa_batch_decrypt(const bi::big_int *ciphers, bi::big_int *op_plains, size_t count) const;
+
+};
@@ -0,0 +1,102 @@
+/**
+ *  @file   rsa_key_pool.hpp
+ *  @brief  Header file for the RSA key pool
+ *
+ *  Keeps ready to use RSA key pairs per bit size, generated ahead of time by
+ *  low priority background threads.
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rsa.hpp"
+
+/*  bit_size        ==> RSA bitsize of the keys kept in this pool
+    low_watermark   ==> refill starts once the number of ready keys drops below this
+    high_watermark  ==> refill stops once this many keys are ready (pool capacity)
+*/
+struct rsa_key_pool_config {
+
+    size_t          bit_size;
+    size_t          low_watermark;
+    size_t          high_watermark;
+
+};
+
+struct rsa_key_pool_stats {
+
+    size_t          bit_size;
+    size_t          depth;                  /* Keys ready to hand out. */
+    size_t          in_flight;              /* Keys being generated right now. */
+    bool            refilling;
+    uint64_t        total_generated;
+    uint64_t        total_acquired;
+    uint64_t        acquire_misses;         /* Acquire calls that found the pool empty. */
+    double          refill_rate;            /* Keys generated per second of generation time. */
+
+};
+
+class rsa_key_pool {
+
+private:
+
+    struct pool_entry {
+        rsa_key_pool_config                 config;
+        std::deque<std::unique_ptr<rsa>>    keys;
+        size_t                              in_flight;
+        bool                                refilling;
+        uint64_t                            total_generated;
+        uint64_t                            total_acquired;
+        uint64_t                            acquire_misses;
+        double                              generation_seconds;
+    };
+
+    int                                 miller_rabin_rounds;
+    int                                 max_number_of_threads_for_miller_rabin;
+    std::deque<pool_entry>              entries;
+    mutable std::mutex                  pool_mutex;
+    std::condition_variable             refill_cv;
+    std::condition_variable             key_ready_cv;
+    bool                                stop_workers;
+    bi::big_int_cancel_token            stop_token;
+    std::vector<std::thread>            workers;
+
+    pool_entry&         _rsa_key_pool_get_entry(size_t bit_size);
+    pool_entry*         _rsa_key_pool_next_refill();
+    std::unique_ptr<rsa> _rsa_key_pool_pop(pool_entry &entry);
+    void                _rsa_key_pool_worker();
+
+public:
+
+    /*  configs                                 ==> one entry per bit size to keep ready
+        no_of_worker_threads                    ==> background threads generating keys, run at the lowest
+                                                    scheduling priority where the platform allows it
+        miller_rabin_rounds,
+        max_number_of_threads_for_miller_rabin  ==> passed on to the rsa key generation for each key
+    */
+    rsa_key_pool(const std::vector<rsa_key_pool_config> &configs, int no_of_worker_threads = 1, \
+        int miller_rabin_rounds = 20, int max_number_of_threads_for_miller_rabin = 1);
+    ~rsa_key_pool();
+
+    rsa_key_pool(const rsa_key_pool &) = delete;
+    rsa_key_pool& operator=(const rsa_key_pool &) = delete;
+
+    /* Returns a ready key pair, or nullptr straight away if the pool for bit_size is empty. */
+    std::unique_ptr<rsa>                rsa_key_pool_try_acquire(size_t bit_size);
+    /* Waits up to timeout for a key pair, returns nullptr if none became ready in time. */
+    std::unique_ptr<rsa>                rsa_key_pool_acquire(size_t bit_size, std::chrono::milliseconds timeout);
+    std::vector<rsa_key_pool_stats>     rsa_key_pool_get_stats() const;
+
+};
@@ -0,0 +1,65 @@
+/**
+ *  @file   rsa_key_store.hpp
+ *  @brief  Header file for the RSA key store
+ *
+ *  File holding many serialized RSA keys behind a sorted key id index. The 
+ *  file is memory mapped and keys are deserialized on first use, so opening
+ *  a store with thousands of keys only touches the pages of the keys used.
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rsa.hpp"
+
+struct rsa_key_store_entry {
+
+    uint64_t        key_id;
+    const rsa       *key;
+
+};
+
+class rsa_key_store {
+
+private:
+
+    const uint8_t                                   *file_data;
+    size_t                                          file_size;
+    uint64_t                                        key_count;
+    bool                                            file_mapped;
+    std::vector<uint8_t>                            file_copy;      /* Used where mmap is not available. */
+    mutable std::mutex                              cache_mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<rsa>>  loaded_keys;
+
+    void            _rsa_key_store_unmap();
+    bool            _rsa_key_store_find(uint64_t key_id, uint64_t &op_offset, uint64_t &op_length) const;
+
+public:
+
+    /* Maps the store file, throws std::runtime_error if it cannot be read and 
+       std::invalid_argument if it is not a key store. */
+    explicit rsa_key_store(const std::string &path);
+    ~rsa_key_store();
+
+    rsa_key_store(const rsa_key_store &) = delete;
+    rsa_key_store& operator=(const rsa_key_store &) = delete;
+
+    /* Writes keys to path (replacing it atomically), key ids must be unique. Returns -1 on failure. */
+    static int              rsa_key_store_write(const std::string &path, const std::vector<rsa_key_store_entry> &keys);
+
+    /* Loads the key on first request, later calls return the same object. nullptr if key_id is not in the store. */
+    std::shared_ptr<rsa>    rsa_key_store_get(uint64_t key_id);
+    bool                    rsa_key_store_contains(uint64_t key_id) const;
+    size_t                  rsa_key_store_size() const;
+
+};
@@ -0,0 +1,59 @@
+/**
+ *  @file   rsa_thread_pool.hpp
+ *  @brief  Header file for the RSA worker thread pool
+ *
+ *  Fixed set of worker threads fed from one task queue, used to spread
+ *  batches of RSA operations across cores.
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class rsa_thread_pool {
+
+private:
+
+    std::deque<std::function<void()>>   tasks;
+    std::mutex                          pool_mutex;
+    std::condition_variable             task_cv;
+    bool                                stop_workers;
+    std::vector<std::thread>            workers;
+
+    void                _rsa_thread_pool_worker();
+
+public:
+
+    /*  no_of_threads   ==> worker threads to start, 0 means std::thread::hardware_concurrency() */
+    explicit rsa_thread_pool(size_t no_of_threads = 0);
+    /* Runs the tasks still queued, then joins the workers. */
+    ~rsa_thread_pool();
+
+    rsa_thread_pool(const rsa_thread_pool &) = delete;
+    rsa_thread_pool& operator=(const rsa_thread_pool &) = delete;
+
+    size_t              rsa_thread_pool_size() const;
+    /* Queues task to run on one of the workers. */
+    void                rsa_thread_pool_post(std::function<void()> task);
+
+    /*  Calls fn(begin, end) over consecutive ranges covering [0, count), ranges of at most
+        grain items are handed out to the workers and to the calling thread as they become free,
+        so uneven work still balances. Returns once every range is done; the first exception
+        thrown by fn is rethrown here (ranges not yet started are then skipped). */
+    void                rsa_thread_pool_parallel_for(size_t count, size_t grain, \
+        const std::function<void(size_t begin, size_t end)> &fn);
+
+    /* Process wide pool sized to the hardware, started on first use. */
+    static rsa_thread_pool& rsa_thread_pool_default();
+
+};
@@ -0,0 +1,318 @@
+/**
+ *  @file   big_int_bench.cc
+ *  @brief  Micro benchmarks of the big_int primitives across operand sizes
+ *
+ *  usage: big_int_bench [--json] [--min-time-ms=N] [--max-op-ms=N] [--max-bits=N] [--ops=add,mul,...]
+ *
+ *      --json              one JSON document on stdout instead of the table
+ *      --min-time-ms=N     time every op / size pair for at least N ms (default 200)
+ *      --max-op-ms=N       once a single call of an op takes longer than N ms its larger
+ *                          sizes are skipped (default 2000, 0 never skips)
+ *      --max-bits=N        largest operand size, sizes are powers of two from 64 (default 16384)
+ *      --ops=list          comma separated subset of add, sub, mul, square, div, mod, gcd,
+ *                          inverse, modexp, modexp_mont, mod_ws, modexp_ws, to_hex, from_hex, to_dec,
+ *                          from_dec (the _ws ops reuse one bi::big_int_workspace)
+ *
+ *  Reports ns/op and allocations/op (operator new calls), the operands are built
+ *  outside the timed loop so the allocations are the ones of the op itself.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "big_int.hpp"
+
+namespace {
+
+    std::atomic<uint64_t>   alloc_count{0};
+
+}
+
+/* Every operator new of the process ends up here, counted and forwarded to malloc. */
+void* operator new(size_t size) {
+
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    void *mem = malloc(size == 0 ? 1 : size);
+    if (mem == nullptr) {
+        throw std::bad_alloc();
+    }
+    return mem;
+
+}
+
+void* operator new[](size_t size) {
+
+    return operator new(size);
+
+}
+
+void operator delete(void *mem) noexcept {
+
+    free(mem);
+
+}
+
+void operator delete[](void *mem) noexcept {
+
+    free(mem);
+
+}
+
+void operator delete(void *mem, size_t) noexcept {
+
+    free(mem);
+
+}
+
+void operator delete[](void *mem, size_t) noexcept {
+
+    free(mem);
+
+}
+
+namespace {
+
+    struct bench_options {
+        bool                        json        = false;
+        double                      min_time_ms = 200;
+        double                      max_op_ms   = 2000;
+        int                         max_bits    = 16384;
+        std::vector<std::string>    ops;
+    };
+
+    struct bench_result {
+        std::string     op;
+        int             bits;
+        uint64_t        iterations;
+        double          ns_per_op;
+        double          allocs_per_op;
+    };
+
+    /* Operands for one size, all of about bits bits unless noted. */
+    struct bench_operands {
+        bi::big_int     a;
+        bi::big_int     b;
+        bi::big_int     wide;               /* 2 * bits, dividend of div and modulus */
+        bi::big_int     odd_modulus;
+        bi::big_int     invertible;         /* coprime to odd_modulus */
+        bi::big_int     exponent;
+        std::string     hex_str;
+        std::string     dec_str;
+    };
+
+    struct bench_op {
+        const char                      *name;
+        std::function<void()>           fn;
+    };
+
+    /* Random number of exactly bits bits. */
+    void random_full_width(bi::big_int &op, int bits) {
+
+        bi::big_int top_bit, bi_1;
+        bi_1.big_int_from_base_type(1, false);
+        bi_1.big_int_left_shift(bits - 1, top_bit);
+        op.big_int_get_random_unsigned(bits - 1);
+        op.big_int_unsigned_add(top_bit);
+
+    }
+
+    void make_operands(int bits, bench_operands &ops) {
+
+        bi::big_int bi_1, gcd;
+        bi_1.big_int_from_base_type(1, false);
+
+        random_full_width(ops.a, bits);
+        random_full_width(ops.b, bits);
+        random_full_width(ops.wide, 2 * bits);
+        random_full_width(ops.exponent, bits);
+        random_full_width(ops.odd_modulus, bits);
+        if (ops.odd_modulus.big_int_is_even()) {
+            ops.odd_modulus.big_int_unsigned_add(bi_1);
+        }
+        do {
+            ops.invertible.big_int_get_random_unsigned(bits - 1);
+            ops.invertible.big_int_gcd_euclidean_algorithm(ops.odd_modulus, gcd);
+        } while (gcd.big_int_compare(bi_1) != 0);
+
+        ops.hex_str = ops.a.big_int_to_string(bi::bi_base::BI_HEX);
+        ops.dec_str = ops.a.big_int_to_string(bi::bi_base::BI_DEC);
+
+    }
+
+    /*  Calls fn in growing rounds until a round lasts min_time_ms, reports the last round.
+        first_call_ms is the time of the untimed warm up call. */
+    bench_result run_timed(const bench_op &op, int bits, double min_time_ms, double &first_call_ms) {
+
+        using bench_clock = std::chrono::steady_clock;
+
+        auto warm_start = bench_clock::now();
+        op.fn();
+        first_call_ms = std::chrono::duration<double, std::milli>(bench_clock::now() - warm_start).count();
+
+        uint64_t iterations = 1;
+        for (;;) {
+            uint64_t allocs_start = alloc_count.load(std::memory_order_relaxed);
+            auto start = bench_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                op.fn();
+            }
+            double elapsed_ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+            uint64_t allocs = alloc_count.load(std::memory_order_relaxed) - allocs_start;
+
+            double min_ns = min_time_ms * 1e6;
+            if (elapsed_ns >= min_ns || iterations >= (1ULL << 32)) {
+                return bench_result{op.name, bits, iterations, elapsed_ns / static_cast<double>(iterations), \
+                    static_cast<double>(allocs) / static_cast<double>(iterations)};
+            }
+
+            /* Aim a bit past the target, at least doubling and at most 100x per round. */
+            double scale = (elapsed_ns > 0) ? (min_ns * 1.2 / elapsed_ns) : 100;
+            scale = std::min(100.0, std::max(2.0, scale));
+            iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+        }
+
+    }
+
+    bool parse_options(int argc, char *argv[], bench_options &options) {
+
+        for (int i = 1; i < argc; ++i) {
+            const char *arg = argv[i];
+            if (strcmp(arg, "--json") == 0) {
+                options.json = true;
+            } else if (strncmp(arg, "--min-time-ms=", 14) == 0) {
+                options.min_time_ms = atof(arg + 14);
+            } else if (strncmp(arg, "--max-op-ms=", 12) == 0) {
+                options.max_op_ms = atof(arg + 12);
+            } else if (strncmp(arg, "--max-bits=", 11) == 0) {
+                options.max_bits = atoi(arg + 11);
+            } else if (strncmp(arg, "--ops=", 6) == 0) {
+                std::string list(arg + 6);
+                size_t start = 0;
+                while (start <= list.size()) {
+                    size_t end = list.find(',', start);
+                    if (end == std::string::npos) {
+                        end = list.size();
+                    }
+                    if (end > start) {
+                        options.ops.push_back(list.substr(start, end - start));
+                    }
+                    start = end + 1;
+                }
+            } else {
+                std::cerr << "usage: big_int_bench [--json] [--min-time-ms=N] [--max-op-ms=N] [--max-bits=N] [--ops=add,mul,...]\n";
+                return false;
+            }
+        }
+        return true;
+
+    }
+
+    void print_json(const std::vector<bench_result> &results, const bench_options &options) {
+
+        std::cout << "{\n  \"benchmark\": \"big_int_bench\",\n  \"limb_bits\": " << BI_BASE_TYPE_TOTAL_BITS \
+            << ",\n  \"min_time_ms\": " << options.min_time_ms << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const bench_result &r = results[i];
+            std::cout << "    {\"op\": \"" << r.op << "\", \"bits\": " << r.bits << ", \"iterations\": " << r.iterations \
+                << ", \"ns_per_op\": " << r.ns_per_op << ", \"allocs_per_op\": " << r.allocs_per_op << "}" \
+                << ((i + 1 < results.size()) ? ",\n" : "\n");
+        }
+        std::cout << "  ]\n}\n";
+
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+
+    bench_options options;
+    if (parse_options(argc, argv, options) == false) {
+        return 1;
+    }
+
+    bench_operands operands;
+    bi::big_int res, quo, rem;
+    std::unique_ptr<bi::big_int_montgomery_ctx> mont_ctx;
+    bi::big_int_workspace workspace;
+    std::string str_out;
+
+    std::vector<bench_op> all_ops = {
+        {"add",             [&] { operands.a.big_int_unsigned_add(operands.b, res); }},
+        {"sub",             [&] { operands.a.big_int_signed_sub(operands.b, res); }},
+        {"mul",             [&] { operands.a.big_int_multiply(operands.b, res); }},
+        {"square",          [&] { operands.a.big_int_multiply(operands.a, res); }},
+        {"div",             [&] { operands.wide.big_int_div(operands.a, quo, rem); }},
+        {"mod",             [&] { operands.wide.big_int_modulus(operands.a, res); }},
+        {"gcd",             [&] { operands.a.big_int_gcd_euclidean_algorithm(operands.b, res); }},
+        {"inverse",         [&] { operands.invertible.big_int_modular_inverse_extended_euclidean_algorithm(operands.odd_modulus, res); }},
+        {"modexp",          [&] { operands.a.big_int_fast_modular_exponentiation(operands.exponent, operands.odd_modulus, res); }},
+        {"modexp_mont",     [&] { mont_ctx->big_int_montgomery_modular_exponentiation(operands.invertible, operands.exponent, res); }},
+        {"mod_ws",          [&] { operands.wide.big_int_modulus(operands.a, res, workspace); }},
+        {"modexp_ws",       [&] { operands.a.big_int_fast_modular_exponentiation(operands.exponent, operands.odd_modulus, res, workspace); }},
+        {"to_hex",          [&] { str_out = operands.a.big_int_to_string(bi::bi_base::BI_HEX); }},
+        {"from_hex",        [&] { res.big_int_from_string(operands.hex_str, bi::bi_base::BI_HEX); }},
+        {"to_dec",          [&] { str_out = operands.a.big_int_to_string(bi::bi_base::BI_DEC); }},
+        {"from_dec",        [&] { res.big_int_from_string(operands.dec_str, bi::bi_base::BI_DEC); }},
+    };
+
+    std::vector<bench_op> ops;
+    for (const auto &op : all_ops) {
+        if (options.ops.empty() || std::find(options.ops.begin(), options.ops.end(), op.name) != options.ops.end()) {
+            ops.push_back(op);
+        }
+    }
+
+    std::vector<bool> op_skipped(ops.size(), false);
+    std::vector<bench_result> results;
+    if (options.json == false) {
+        std::cout << "op              bits      iterations      ns/op             allocs/op\n";
+    }
+
+    for (int bits = 64; bits <= options.max_bits; bits *= 2) {
+        make_operands(bits, operands);
+        mont_ctx.reset(new bi::big_int_montgomery_ctx(operands.odd_modulus));
+
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (op_skipped[i]) {
+                continue;
+            }
+
+            double first_call_ms = 0;
+            bench_result result = run_timed(ops[i], bits, options.min_time_ms, first_call_ms);
+            results.push_back(result);
+            if (options.max_op_ms > 0 && first_call_ms > options.max_op_ms) {
+                op_skipped[i] = true;
+                std::cerr << ops[i].name << ": " << first_call_ms << " ms per call at " << bits \
+                    << " bits, larger sizes skipped\n";
+            }
+
+            if (options.json == false) {
+                printf("%-16s%-10d%-16llu%-18.1f%.2f\n", result.op.c_str(), result.bits, \
+                    static_cast<unsigned long long>(result.iterations), result.ns_per_op, result.allocs_per_op);
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (options.json) {
+        print_json(results, options);
+    }
+    return 0;
+
+}
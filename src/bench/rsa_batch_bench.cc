@@ -0,0 +1,137 @@
+/**
+ *  @file   rsa_batch_bench.cc
+ *  @brief  Benchmark of Fiat batch RSA decryption against per message CRT decryption
+ *
+ *  usage: rsa_batch_bench [key bits = 2048] [batches = 8]
+ *
+ *      key bits            even, 64 to 16384
+ *      batches             timed rounds per batch size, at least 1
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "rsa.hpp"
+#include "rsa_batch.hpp"
+
+namespace {
+
+    constexpr unsigned long BATCH_BENCH_MIN_KEY_BITS = 64;
+    constexpr unsigned long BATCH_BENCH_MAX_KEY_BITS = 16384;
+
+    void print_usage() {
+
+        std::cerr << "usage: rsa_batch_bench [key bits = 2048] [batches = 8]\n"
+            "    key bits    even, " << BATCH_BENCH_MIN_KEY_BITS << " to " << BATCH_BENCH_MAX_KEY_BITS << "\n"
+            "    batches     timed rounds per batch size, at least 1\n";
+
+    }
+
+    /* Whole decimal argument in [min_val, max_val], nothing else accepted. */
+    bool parse_ulong(const char *arg, unsigned long min_val, unsigned long max_val, unsigned long &op_val) {
+
+        char *end = nullptr;
+        errno = 0;
+        unsigned long val = strtoul(arg, &end, 10);
+        if (arg[0] < '0' || arg[0] > '9' || *end != '\0' || errno == ERANGE || val < min_val || val > max_val) {
+            return false;
+        }
+        op_val = val;
+        return true;
+
+    }
+
+    bool parse_options(int argc, char *argv[], size_t &key_bits, int &batches) {
+
+        if (argc > 3 || (argc > 1 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0))) {
+            print_usage();
+            return false;
+        }
+
+        unsigned long val;
+        if (argc > 1) {
+            if (parse_ulong(argv[1], BATCH_BENCH_MIN_KEY_BITS, BATCH_BENCH_MAX_KEY_BITS, val) == false || val % 2 != 0) {
+                std::cerr << "key bits must be even and between " << BATCH_BENCH_MIN_KEY_BITS << " and " \
+                    << BATCH_BENCH_MAX_KEY_BITS << "\n";
+                print_usage();
+                return false;
+            }
+            key_bits = val;
+        }
+        if (argc > 2) {
+            if (parse_ulong(argv[2], 1, INT_MAX, val) == false) {
+                std::cerr << "batches must be a whole number of at least 1\n";
+                print_usage();
+                return false;
+            }
+            batches = static_cast<int>(val);
+        }
+        return true;
+
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t key_bits = 2048;
+    int batches = 8;
+    if (parse_options(argc, argv, key_bits, batches) == false) {
+        return 1;
+    }
+
+    rsa key(key_bits);
+    bi::big_int modulus = key.get_modulus();
+    /* big_int_get_num_of_bits() counts whole hex digits, stay a digit below the modulus. */
+    int plain_bits = modulus.big_int_get_num_of_bits() - 4;
+
+    std::cout << "key bits: " << key_bits << ", batches per size: " << batches << "\n";
+    std::cout << "batch size     batch us/msg     CRT us/msg     speedup\n";
+
+    for (size_t batch_size : {2U, 4U, 8U, 16U, 32U}) {
+        rsa_batch batch(key, batch_size);
+        std::vector<bi::big_int> plain(batch_size), batch_cipher(batch_size), crt_cipher(batch_size), decipher(batch_size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            plain[i].big_int_get_random_unsigned(plain_bits);
+            batch.rsa_batch_encrypt(i, plain[i], batch_cipher[i]);
+            key.rsa_encrypt(plain[i], crt_cipher[i]);
+        }
+
+        auto batch_start = std::chrono::steady_clock::now();
+        for (int b = 0; b < batches; ++b) {
+            batch.rsa_batch_decrypt(batch_cipher.data(), decipher.data(), batch_size);
+        }
+        auto batch_end = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < batch_size; ++i) {
+            if (decipher[i].big_int_compare(plain[i]) != 0) {
+                std::cerr << "batch decryption mismatch at slot " << i << "\n";
+                return 1;
+            }
+        }
+
+        auto crt_start = std::chrono::steady_clock::now();
+        for (int b = 0; b < batches; ++b) {
+            for (size_t i = 0; i < batch_size; ++i) {
+                key.rsa_decrypt(crt_cipher[i], decipher[i]);
+            }
+        }
+        auto crt_end = std::chrono::steady_clock::now();
+
+        double msgs = static_cast<double>(batches) * static_cast<double>(batch_size);
+        double batch_us = std::chrono::duration<double, std::micro>(batch_end - batch_start).count() / msgs;
+        double crt_us = std::chrono::duration<double, std::micro>(crt_end - crt_start).count() / msgs;
+        std::cout << "    " << batch_size << "\t\t" << batch_us << "\t\t" << crt_us << "\t\t" << crt_us / batch_us << "x\n";
+    }
+
+    return 0;
+
+}
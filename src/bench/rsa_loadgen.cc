@@ -0,0 +1,385 @@
+/**
+ *  @file   rsa_loadgen.cc
+ *  @brief  End to end RSA load generator
+ *
+ *  Worker threads run a weighted mix of encrypt, decrypt and key generation
+ *  against shared rsa instances for a fixed duration, then the throughput,
+ *  latency percentiles and CPU time are reported per operation.
+ *
+ *  usage: rsa_loadgen [--bits=N] [--primes=N] [--keys=N] [--threads=N] [--duration=S]
+ *                     [--mix=ENC:DEC:KEYGEN] [--keygen-bits=N] [--parallel-crt]
+ *
+ *      --bits=N            size of the shared keys (default 2048)
+ *      --primes=N          primes per key, only 2 (the default) is supported by rsa
+ *      --keys=N            shared rsa instances, picked at random per op (default 1)
+ *      --threads=N         worker threads (default std::thread::hardware_concurrency())
+ *      --duration=S        seconds to start new ops for (default 10), running ops finish
+ *      --mix=E:D:K         relative weights of encrypt, decrypt and keygen (default 70:29:1)
+ *      --keygen-bits=N     size of the keys generated by keygen ops (default --bits)
+ *      --parallel-crt      decrypt with rsa_decrypt_parallel_crt at any key size, the CRT
+ *                          halves of each decrypt then run on two threads
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "rsa.hpp"
+
+namespace {
+
+    enum loadgen_op {
+        LOADGEN_ENCRYPT,
+        LOADGEN_DECRYPT,
+        LOADGEN_KEYGEN,
+        LOADGEN_OP_COUNT
+    };
+
+    const char *const loadgen_op_names[LOADGEN_OP_COUNT] = {"encrypt", "decrypt", "keygen"};
+
+    struct loadgen_options {
+        size_t          bits            = 2048;
+        size_t          keygen_bits     = 0;
+        int             primes          = 2;
+        size_t          keys            = 1;
+        size_t          threads         = 0;
+        double          duration_s      = 10;
+        unsigned        mix[LOADGEN_OP_COUNT] = {70, 29, 1};
+        bool            parallel_crt    = false;
+    };
+
+    /* A shared key with a plain / cipher pair to feed the ops. */
+    struct loadgen_key {
+        std::unique_ptr<rsa>    key;
+        bi::big_int             plain;
+        bi::big_int             cipher;
+    };
+
+    /* Latencies in ns of every op a worker ran, merged after the run. */
+    struct loadgen_worker_stats {
+        std::vector<uint64_t>   latencies[LOADGEN_OP_COUNT];
+        uint64_t                errors = 0;
+    };
+
+    constexpr unsigned long LOADGEN_MIN_KEY_BITS = 64;
+    constexpr unsigned long LOADGEN_MAX_KEY_BITS = 16384;
+    constexpr unsigned long LOADGEN_MAX_KEYS = 65536;
+    constexpr unsigned long LOADGEN_MAX_THREADS = 4096;
+
+    void print_usage() {
+
+        fprintf(stderr, "usage: rsa_loadgen [--bits=N] [--primes=N] [--keys=N] [--threads=N] [--duration=S] "
+            "[--mix=ENC:DEC:KEYGEN] [--keygen-bits=N] [--parallel-crt]\n"
+            "    --bits, --keygen-bits   even, %lu to %lu\n"
+            "    --primes                2\n"
+            "    --keys                  1 to %lu\n"
+            "    --threads               0 (one per core) to %lu\n"
+            "    --duration              seconds, more than 0\n"
+            "    --mix                   three whole weights, not all zero\n", \
+            LOADGEN_MIN_KEY_BITS, LOADGEN_MAX_KEY_BITS, LOADGEN_MAX_KEYS, LOADGEN_MAX_THREADS);
+
+    }
+
+    /* Whole decimal value in [min_val, max_val] up to end_char, op_end gets the first character after it. */
+    bool parse_ulong(const char *arg, unsigned long min_val, unsigned long max_val, char end_char, \
+        unsigned long &op_val, const char **op_end = nullptr) {
+
+        char *end = nullptr;
+        errno = 0;
+        unsigned long val = strtoul(arg, &end, 10);
+        if (arg[0] < '0' || arg[0] > '9' || *end != end_char || errno == ERANGE || val < min_val || val > max_val) {
+            return false;
+        }
+        op_val = val;
+        if (op_end != nullptr) {
+            *op_end = end;
+        }
+        return true;
+
+    }
+
+    bool parse_key_bits(const char *arg, const char *option, size_t &op_bits) {
+
+        unsigned long val;
+        if (parse_ulong(arg, LOADGEN_MIN_KEY_BITS, LOADGEN_MAX_KEY_BITS, '\0', val) == false || val % 2 != 0) {
+            fprintf(stderr, "%s must be even and between %lu and %lu\n", option, LOADGEN_MIN_KEY_BITS, LOADGEN_MAX_KEY_BITS);
+            return false;
+        }
+        op_bits = val;
+        return true;
+
+    }
+
+    bool parse_mix(const char *arg, unsigned (&op_mix)[LOADGEN_OP_COUNT]) {
+
+        unsigned long weights[LOADGEN_OP_COUNT];
+        const char *cur = arg;
+        for (int op = 0; op < LOADGEN_OP_COUNT; ++op) {
+            char end_char = (op + 1 < LOADGEN_OP_COUNT) ? ':' : '\0';
+            if (parse_ulong(cur, 0, UINT_MAX, end_char, weights[op], &cur) == false) {
+                fprintf(stderr, "--mix expects ENC:DEC:KEYGEN weights\n");
+                return false;
+            }
+            ++cur;
+        }
+        if (weights[LOADGEN_ENCRYPT] + weights[LOADGEN_DECRYPT] + weights[LOADGEN_KEYGEN] == 0) {
+            fprintf(stderr, "--mix weights are all zero\n");
+            return false;
+        }
+        for (int op = 0; op < LOADGEN_OP_COUNT; ++op) {
+            op_mix[op] = static_cast<unsigned>(weights[op]);
+        }
+        return true;
+
+    }
+
+    bool parse_option(const char *arg, loadgen_options &options) {
+
+        unsigned long val;
+        if (strncmp(arg, "--bits=", 7) == 0) {
+            return parse_key_bits(arg + 7, "--bits", options.bits);
+        } else if (strncmp(arg, "--keygen-bits=", 14) == 0) {
+            return parse_key_bits(arg + 14, "--keygen-bits", options.keygen_bits);
+        } else if (strncmp(arg, "--primes=", 9) == 0) {
+            if (parse_ulong(arg + 9, 2, 2, '\0', val) == false) {
+                fprintf(stderr, "only 2 prime keys are supported\n");
+                return false;
+            }
+            options.primes = static_cast<int>(val);
+        } else if (strncmp(arg, "--keys=", 7) == 0) {
+            if (parse_ulong(arg + 7, 1, LOADGEN_MAX_KEYS, '\0', val) == false) {
+                fprintf(stderr, "--keys must be between 1 and %lu\n", LOADGEN_MAX_KEYS);
+                return false;
+            }
+            options.keys = val;
+        } else if (strncmp(arg, "--threads=", 10) == 0) {
+            if (parse_ulong(arg + 10, 0, LOADGEN_MAX_THREADS, '\0', val) == false) {
+                fprintf(stderr, "--threads must be between 0 and %lu\n", LOADGEN_MAX_THREADS);
+                return false;
+            }
+            options.threads = val;
+        } else if (strncmp(arg, "--duration=", 11) == 0) {
+            char *end = nullptr;
+            errno = 0;
+            double duration_s = strtod(arg + 11, &end);
+            if (end == arg + 11 || *end != '\0' || errno == ERANGE || !(duration_s > 0) || !std::isfinite(duration_s)) {
+                fprintf(stderr, "--duration must be a number of seconds above 0\n");
+                return false;
+            }
+            options.duration_s = duration_s;
+        } else if (strcmp(arg, "--parallel-crt") == 0) {
+            options.parallel_crt = true;
+        } else if (strncmp(arg, "--mix=", 6) == 0) {
+            return parse_mix(arg + 6, options.mix);
+        } else {
+            if (strcmp(arg, "--help") != 0 && strcmp(arg, "-h") != 0) {
+                fprintf(stderr, "unknown option %s\n", arg);
+            }
+            return false;
+        }
+        return true;
+
+    }
+
+    bool parse_options(int argc, char *argv[], loadgen_options &options) {
+
+        for (int i = 1; i < argc; ++i) {
+            if (parse_option(argv[i], options) == false) {
+                print_usage();
+                return false;
+            }
+        }
+
+        if (options.keygen_bits == 0) {
+            options.keygen_bits = options.bits;
+        }
+        if (options.threads == 0) {
+            options.threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+        return true;
+
+    }
+
+    double process_cpu_seconds() {
+
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+
+    }
+
+    /* Nearest rank percentile of sorted latencies, in microseconds. */
+    double percentile_us(const std::vector<uint64_t> &sorted, double pct) {
+
+        if (sorted.empty()) {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(pct / 100.0 * static_cast<double>(sorted.size()) + 0.999999);
+        rank = std::min(sorted.size(), std::max<size_t>(rank, 1));
+        return static_cast<double>(sorted[rank - 1]) / 1e3;
+
+    }
+
+    void run_worker(
+        size_t worker_idx,
+        const loadgen_options &options,
+        const std::vector<loadgen_key> &keys,
+        std::chrono::steady_clock::time_point deadline,
+        loadgen_worker_stats &stats) {
+
+        std::mt19937_64 rng(0x9E3779B97F4A7C15ULL * (worker_idx + 1));
+        std::discrete_distribution<int> op_dist(std::begin(options.mix), std::end(options.mix));
+        std::uniform_int_distribution<size_t> key_dist(0, keys.size() - 1);
+        bi::big_int result;
+
+        while (std::chrono::steady_clock::now() < deadline) {
+            int op = op_dist(rng);
+            const loadgen_key &shared = keys[key_dist(rng)];
+
+            auto start = std::chrono::steady_clock::now();
+            switch (op) {
+            case LOADGEN_ENCRYPT:
+                shared.key->rsa_encrypt(shared.plain, result);
+                if (result.big_int_compare(shared.cipher) != 0) {
+                    ++stats.errors;
+                }
+                break;
+            case LOADGEN_DECRYPT:
+                if (options.parallel_crt) {
+                    shared.key->rsa_decrypt_parallel_crt(shared.cipher, result, nullptr, 0);
+                } else {
+                    shared.key->rsa_decrypt(shared.cipher, result);
+                }
+                if (result.big_int_compare(shared.plain) != 0) {
+                    ++stats.errors;
+                }
+                break;
+            default:
+                /* Single threaded prime search, the workers already keep the cores busy. */
+                rsa new_key(options.keygen_bits, 20, 1);
+                break;
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            stats.latencies[op].push_back(static_cast<uint64_t>(\
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+
+    loadgen_options options;
+    if (parse_options(argc, argv, options) == false) {
+        return 1;
+    }
+
+    printf("rsa_loadgen: %zu bit keys x %zu (%d primes), %zu threads, %.1f s, mix encrypt %u decrypt %u keygen %u (%zu bit)%s\n", \
+        options.bits, options.keys, options.primes, options.threads, options.duration_s, options.mix[LOADGEN_ENCRYPT], \
+        options.mix[LOADGEN_DECRYPT], options.mix[LOADGEN_KEYGEN], options.keygen_bits, options.parallel_crt ? ", parallel CRT" : "");
+
+    auto setup_start = std::chrono::steady_clock::now();
+    std::vector<loadgen_key> keys(options.keys);
+    for (auto &shared : keys) {
+        shared.key.reset(new rsa(options.bits));
+        bi::big_int modulus = shared.key->get_modulus();
+        /* big_int_get_num_of_bits() counts whole hex digits, stay a digit below the modulus. */
+        shared.plain.big_int_get_random_unsigned(modulus.big_int_get_num_of_bits() - 4);
+        shared.key->rsa_encrypt(shared.plain, shared.cipher);
+    }
+    printf("key setup: %.1f ms\n\n", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setup_start).count());
+
+    std::vector<loadgen_worker_stats> stats(options.threads);
+    std::vector<std::thread> workers;
+    double cpu_start = process_cpu_seconds();
+    auto run_start = std::chrono::steady_clock::now();
+    auto deadline = run_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(\
+        std::chrono::duration<double>(options.duration_s));
+
+    for (size_t i = 0; i < options.threads; ++i) {
+        workers.emplace_back(run_worker, i, std::cref(options), std::cref(keys), deadline, std::ref(stats[i]));
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+    double cpu_s = process_cpu_seconds() - cpu_start;
+
+    std::vector<uint64_t> merged[LOADGEN_OP_COUNT];
+    uint64_t errors = 0, total_ops = 0;
+    for (const auto &worker_stats : stats) {
+        for (int op = 0; op < LOADGEN_OP_COUNT; ++op) {
+            merged[op].insert(merged[op].end(), worker_stats.latencies[op].begin(), worker_stats.latencies[op].end());
+        }
+        errors += worker_stats.errors;
+    }
+
+    printf("%-10s%10s%12s%12s%12s%12s%12s\n", "op", "count", "ops/s", "p50 us", "p99 us", "p99.9 us", "max us");
+    for (int op = 0; op < LOADGEN_OP_COUNT; ++op) {
+        std::vector<uint64_t> &sorted = merged[op];
+        std::sort(sorted.begin(), sorted.end());
+        total_ops += sorted.size();
+        printf("%-10s%10zu%12.1f%12.1f%12.1f%12.1f%12.1f\n", loadgen_op_names[op], sorted.size(), \
+            static_cast<double>(sorted.size()) / wall_s, percentile_us(sorted, 50), percentile_us(sorted, 99), \
+            percentile_us(sorted, 99.9), percentile_us(sorted, 100));
+    }
+    printf("%-10s%10llu%12.1f\n\n", "total", static_cast<unsigned long long>(total_ops), static_cast<double>(total_ops) / wall_s);
+    printf("wall %.2f s, cpu %.2f s (%.2f cores busy), %llu result mismatches\n", wall_s, cpu_s, cpu_s / wall_s, \
+        static_cast<unsigned long long>(errors));
+
+    /*  Keygen latency is dominated by how many candidates the prime search tests, so its tail is
+        long. Power of two buckets in ms show the whole shape rather than three points of it. */
+    const std::vector<uint64_t> &keygen = merged[LOADGEN_KEYGEN];
+    if (keygen.empty() == false) {
+        printf("\nkeygen latency (ms): min %.1f p10 %.1f p50 %.1f p90 %.1f p99 %.1f max %.1f\n", \
+            static_cast<double>(keygen.front()) / 1e6, percentile_us(keygen, 10) / 1e3, percentile_us(keygen, 50) / 1e3, \
+            percentile_us(keygen, 90) / 1e3, percentile_us(keygen, 99) / 1e3, static_cast<double>(keygen.back()) / 1e6);
+
+        std::vector<size_t> buckets;
+        for (uint64_t ns : keygen) {
+            size_t bucket = 0;
+            for (uint64_t ms = ns / 1000000; ms > 0; ms >>= 1) {
+                ++bucket;
+            }
+            if (bucket >= buckets.size()) {
+                buckets.resize(bucket + 1, 0);
+            }
+            ++buckets[bucket];
+        }
+        size_t max_count = *std::max_element(buckets.begin(), buckets.end());
+        size_t first_bucket = 0;
+        while (buckets[first_bucket] == 0) {
+            ++first_bucket;
+        }
+        for (size_t b = first_bucket; b < buckets.size(); ++b) {
+            unsigned long long lo = (b == 0) ? 0 : (1ULL << (b - 1)), hi = 1ULL << b;
+            printf("  [%6llu, %6llu) %8zu  ", lo, hi, buckets[b]);
+            for (size_t bar = 0; bar < (buckets[b] * 50 + max_count - 1) / max_count; ++bar) {
+                putchar('#');
+            }
+            putchar('\n');
+        }
+    }
+
+    return (errors == 0) ? 0 : 1;
+
+}
@@ -11,10 +11,10 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <exception>
 #include <string.h>
 #include <memory>
 #include <cstdio>
-#include <random>
 #include <iostream>
 #include <mutex>
 #include <atomic>
@@ -24,54 +24,228 @@
 #include "big_int.hpp"
 #include "big_int_lib_log.hpp"
 #include "big_int_inline_defs.hpp"
-#include "big_int_base_converter.hpp"
-
-const char *bin_num_set = "01";
-const char *dec_num_set = "0123456789";
-const char *hex_num_set = "0123456789ABCDEF";
+#include "big_int_bounded_queue.hpp"
+#include "big_int_chacha20.hpp"
+#include "big_int_hex_codec.hpp"
+#include "big_int_radix.hpp"
 
 int bi::big_int::big_int_from_string(const std::string &str_num_arg, bi_base target_base) {
 
-    std::string str_num(str_num_arg);
+    /* Parsed in place, no intermediate copies. An empty string reads as zero. */
+    const char *first = str_num_arg.data(), *last = first + str_num_arg.size();
+    if (first == last) {
+        return big_int_set_zero();
+    }
+
+    std::from_chars_result parse_res;
+    switch (target_base) {
+        case bi_base::BI_HEX:
+            parse_res = big_int_from_hex_chars(first, last);
+            break;
+        case bi_base::BI_DEC:
+            parse_res = big_int_from_dec_chars(first, last);
+            break;
+        case bi_base::BI_BIN:
+            parse_res = big_int_from_bin_chars(first, last);
+            break;
+        default:
+            throw std::invalid_argument("Invalid base");
+    }
 
+    if (parse_res.ec != std::errc() || parse_res.ptr != last) {
+        big_int_set_zero();
+        return -1;
+    }
+    return 0;
+}
+
+std::from_chars_result bi::big_int::big_int_from_hex_chars(const char *first, const char *last) {
+
+    const char *cur = first;
     bool is_neg = false;
-    if (str_num[0] == '-') {
+    if (cur != last && *cur == '-') {
         is_neg = true;
-        str_num = str_num.substr(1);
+        ++cur;
+    }
+    if (last - cur > 2 && cur[0] == '0' && (cur[1] == 'x' || cur[1] == 'X') && \
+        hex_codec_digit_value(cur[2]) != BI_HEX_INVALID_DIGIT) {
+        cur += 2;
     }
 
-    size_t n = str_num.find_first_not_of('0');
-    if (n != std::string::npos) {
-        str_num = str_num.substr(n);
+    size_t num_of_digits = hex_codec_count_digits(cur, last);
+    if (num_of_digits == 0) {
+        return {first, std::errc::invalid_argument};
     }
-    else {
-        str_num = "0";
+    const char *digits_end = cur + num_of_digits;
+
+    /* Leading zero digits do not need limbs. */
+    while (num_of_digits > 1 && *cur == '0') {
+        ++cur;
+        --num_of_digits;
     }
 
-    std::string hex_str;
-    switch (target_base) {
-        case bi_base::BI_BIN: {
-            BaseConverter bin_to_hex(bin_num_set, hex_num_set);
-            hex_str = bin_to_hex.Convert(str_num);
-            break;
+    int limbs_reqd = static_cast<int>((num_of_digits + BI_HEX_CHARS_PER_BASE_TYPE - 1) / BI_HEX_CHARS_PER_BASE_TYPE);
+    big_int_clear();
+    if (limbs_reqd >= _total_data) {
+        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + limbs_reqd);
+    }
+
+    /* Full limbs from the least significant end, the leftover digits form the top limb. */
+    const char *limb_end = digits_end;
+    while (static_cast<size_t>(limb_end - cur) >= BI_HEX_CHARS_PER_BASE_TYPE) {
+        limb_end -= BI_HEX_CHARS_PER_BASE_TYPE;
+        _data[_top++] = hex_codec_parse_bi_base_type(limb_end, BI_HEX_CHARS_PER_BASE_TYPE);
+    }
+    if (limb_end != cur) {
+        _data[_top++] = hex_codec_parse_bi_base_type(cur, static_cast<size_t>(limb_end - cur));
+    }
+
+    _neg = is_neg;
+    _big_int_remove_preceding_zeroes();
+    return {digits_end, std::errc()};
+
+}
+
+std::to_chars_result bi::big_int::big_int_to_hex_chars(char *first, char *last) const {
+
+    size_t num_of_chars = static_cast<size_t>(_big_int_get_num_of_hex_chars()) + (_neg ? 1 : 0);
+    if (static_cast<size_t>(last - first) < num_of_chars) {
+        return {last, std::errc::value_too_large};
+    }
+
+    char *cur = first;
+    if (_neg) {
+        *cur++ = '-';
+    }
+    cur += hex_codec_format_bi_base_type_trimmed(_data[_top - 1], cur);
+    for (int i = _top - 2; i >= 0; --i) {
+        hex_codec_format_bi_base_type(_data[i], cur);
+        cur += BI_HEX_CHARS_PER_BASE_TYPE;
+    }
+    return {cur, std::errc()};
+
+}
+
+std::from_chars_result bi::big_int::big_int_from_dec_chars(const char *first, const char *last) {
+
+    const char *cur = first;
+    bool is_neg = false;
+    if (cur != last && *cur == '-') {
+        is_neg = true;
+        ++cur;
+    }
+
+    const char *digits_end = cur;
+    while (digits_end != last && *digits_end >= '0' && *digits_end <= '9') {
+        ++digits_end;
+    }
+    if (digits_end == cur) {
+        return {first, std::errc::invalid_argument};
+    }
+
+    radix_limbs limbs;
+    radix_dec_to_limbs(cur, static_cast<size_t>(digits_end - cur), limbs);
+    if (limbs.empty()) {
+        big_int_set_zero();
+    } else {
+        big_int_from_base_type_array(limbs.data(), static_cast<int>(limbs.size()), is_neg);
+    }
+    return {digits_end, std::errc()};
+
+}
+
+std::to_chars_result bi::big_int::big_int_to_dec_chars(char *first, char *last) const {
+
+    char *cur = first;
+    bool overflow = false;
+    if (_neg) {
+        if (cur == last) {
+            return {last, std::errc::value_too_large};
         }
-        case bi_base::BI_DEC: {
-            BaseConverter dec_to_hex(dec_num_set, hex_num_set);
-            hex_str = dec_to_hex.Convert(str_num);
-            break;
+        *cur++ = '-';
+    }
+    radix_limbs limbs(_data, _data + _top);
+    radix_normalize(limbs);
+    /* The digits go straight into the caller's buffer, the rest is dropped once it is full. */
+    radix_limbs_to_dec(limbs, [&cur, last, &overflow](const char *chars, size_t count) {
+        if (overflow || static_cast<size_t>(last - cur) < count) {
+            overflow = true;
+            return;
         }
-        case bi_base::BI_HEX:
-            hex_str = str_num;
-            break;
-        default:
-            throw std::invalid_argument("Invalid base");
+        cur = std::copy_n(chars, count, cur);
+    });
+
+    if (overflow) {
+        return {last, std::errc::value_too_large};
     }
+    return {cur, std::errc()};
+
+}
+
+std::from_chars_result bi::big_int::big_int_from_bin_chars(const char *first, const char *last) {
 
-    if (is_neg) {
-        hex_str.insert(0, "-");
+    const char *cur = first;
+    bool is_neg = false;
+    if (cur != last && *cur == '-') {
+        is_neg = true;
+        ++cur;
     }
 
-    return _big_int_from_string(hex_str);;
+    const char *digits_end = cur;
+    while (digits_end != last && (*digits_end == '0' || *digits_end == '1')) {
+        ++digits_end;
+    }
+    if (digits_end == cur) {
+        return {first, std::errc::invalid_argument};
+    }
+    while (digits_end - cur > 1 && *cur == '0') {
+        ++cur;
+    }
+
+    /* Bits straight into the limbs, least significant bit last in the text. */
+    size_t num_of_bits = static_cast<size_t>(digits_end - cur);
+    int limbs_reqd = static_cast<int>((num_of_bits + BI_BASE_TYPE_TOTAL_BITS - 1) / BI_BASE_TYPE_TOTAL_BITS);
+    big_int_clear();
+    if (limbs_reqd >= _total_data) {
+        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + limbs_reqd);
+    }
+    std::fill_n(_data, limbs_reqd, 0);
+    for (size_t i = 0; i < num_of_bits; ++i) {
+        if (digits_end[-1 - static_cast<ptrdiff_t>(i)] == '1') {
+            _data[i / BI_BASE_TYPE_TOTAL_BITS] |= static_cast<BI_BASE_TYPE>(1) << (i % BI_BASE_TYPE_TOTAL_BITS);
+        }
+    }
+    _top = limbs_reqd;
+    _neg = is_neg;
+    _big_int_remove_preceding_zeroes();
+    return {digits_end, std::errc()};
+
+}
+
+std::to_chars_result bi::big_int::big_int_to_bin_chars(char *first, char *last) const {
+
+    /* Exact bit length, big_int_get_num_of_bits rounds up to whole hex digits. */
+    int num_of_bits = (_top - 1) * BI_BASE_TYPE_TOTAL_BITS;
+    for (BI_BASE_TYPE top_limb = _data[_top - 1]; top_limb != 0; top_limb >>= 1) {
+        ++num_of_bits;
+    }
+    size_t num_of_chars = static_cast<size_t>(num_of_bits > 0 ? num_of_bits : 1) + (_neg ? 1 : 0);
+    if (static_cast<size_t>(last - first) < num_of_chars) {
+        return {last, std::errc::value_too_large};
+    }
+
+    char *cur = first;
+    if (_neg) {
+        *cur++ = '-';
+    }
+    if (num_of_bits == 0) {
+        *cur++ = '0';
+    }
+    for (int i = num_of_bits - 1; i >= 0; --i) {
+        *cur++ = ((_data[i / BI_BASE_TYPE_TOTAL_BITS] >> (i % BI_BASE_TYPE_TOTAL_BITS)) & 1) ? '1' : '0';
+    }
+    return {cur, std::errc()};
+
 }
 
 int bi::big_int::big_int_from_base_type(const BI_BASE_TYPE &bt_val, const bool is_neg) {
@@ -83,6 +257,118 @@ int bi::big_int::big_int_from_base_type(const BI_BASE_TYPE &bt_val, const bool i
 
 }
 
+int bi::big_int::big_int_from_base_type_array(const BI_BASE_TYPE *data, int count, const bool is_neg) {
+
+    if (count <= 0) {
+        return -1;
+    }
+
+    big_int_clear();
+    if (count >= _total_data) {
+        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + count);
+    }
+    std::copy_n(data, count, _data);
+    _top = count;
+    _neg = is_neg;
+    return _big_int_remove_preceding_zeroes();
+
+}
+
+int bi::big_int::big_int_to_base_type_array(BI_BASE_TYPE *op_data, int op_data_count) const {
+
+    if (op_data_count < _top) {
+        return -1;
+    }
+
+    std::copy_n(_data, _top, op_data);
+    return 0;
+
+}
+
+int bi::big_int::big_int_get_num_of_base_type() const {
+
+    return _top;
+
+}
+
+int bi::big_int::big_int_from_bytes(const uint8_t *data, size_t data_size, bi_endian endian) {
+
+    const bool big_endian = (endian == bi_endian::BI_BIG_ENDIAN);
+    const size_t limb_bytes = sizeof(BI_BASE_TYPE);
+    size_t full_limbs = data_size / limb_bytes, partial_bytes = data_size % limb_bytes;
+    int limbs_reqd = static_cast<int>(full_limbs + (partial_bytes ? 1 : 0));
+
+    big_int_clear();
+    if (limbs_reqd == 0) {
+        return big_int_set_zero();
+    }
+    if (limbs_reqd >= _total_data) {
+        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + limbs_reqd);
+    }
+
+    /* Limb i holds bytes [i * 4, i * 4 + 4) counted from the least significant end. */
+    for (size_t i = 0; i < full_limbs; ++i) {
+        const uint8_t *src = big_endian ? (data + data_size - (i + 1) * limb_bytes) : (data + i * limb_bytes);
+        _data[_top++] = load_bi_base_type(src, big_endian);
+    }
+    if (partial_bytes) {
+        BI_BASE_TYPE top_limb = 0;
+        for (size_t i = 0; i < partial_bytes; ++i) {
+            /* Most significant remaining byte first. */
+            uint8_t byte_val = big_endian ? data[i] : data[data_size - 1 - i];
+            top_limb = (top_limb << 8) | byte_val;
+        }
+        _data[_top++] = top_limb;
+    }
+
+    return _big_int_remove_preceding_zeroes();
+
+}
+
+int bi::big_int::big_int_to_bytes(uint8_t *op_data, size_t op_data_size, bi_endian endian) const {
+
+    if (big_int_is_negetive() == true || big_int_get_num_of_bytes() > op_data_size) {
+        return -1;
+    }
+
+    const bool big_endian = (endian == bi_endian::BI_BIG_ENDIAN);
+    const size_t limb_bytes = sizeof(BI_BASE_TYPE);
+    size_t full_limbs = op_data_size / limb_bytes, partial_bytes = op_data_size % limb_bytes;
+
+    for (size_t i = 0; i < full_limbs; ++i) {
+        BI_BASE_TYPE limb = (i < static_cast<size_t>(_top)) ? _data[i] : 0;
+        uint8_t *dst = big_endian ? (op_data + op_data_size - (i + 1) * limb_bytes) : (op_data + i * limb_bytes);
+        store_bi_base_type(dst, limb, big_endian);
+    }
+    if (partial_bytes) {
+        BI_BASE_TYPE top_limb = (full_limbs < static_cast<size_t>(_top)) ? _data[full_limbs] : 0;
+        for (size_t i = 0; i < partial_bytes; ++i) {
+            /* Least significant remaining byte first. */
+            uint8_t byte_val = static_cast<uint8_t>(top_limb >> (8 * i));
+            if (big_endian) {
+                op_data[partial_bytes - 1 - i] = byte_val;
+            } else {
+                op_data[full_limbs * limb_bytes + i] = byte_val;
+            }
+        }
+    }
+
+    return 0;
+
+}
+
+size_t bi::big_int::big_int_get_num_of_bytes() const {
+
+    size_t num_of_bytes = static_cast<size_t>(_top - 1) * sizeof(BI_BASE_TYPE);
+    BI_BASE_TYPE top_limb = _data[_top - 1];
+    while (top_limb) {
+        ++num_of_bytes;
+        top_limb >>= 8;
+    }
+    return num_of_bytes;
+
+}
+
 int bi::big_int::big_int_unsigned_add(const bi::big_int &b) {
 
     int max_data_len, min_data_len;
@@ -135,7 +421,7 @@ int bi::big_int::big_int_unsigned_add(const bi::big_int &b) {
 
 }
 
-int bi::big_int::big_int_unsigned_add(const bi::big_int &b, bi::big_int &res) {
+int bi::big_int::big_int_unsigned_add(const bi::big_int &b, bi::big_int &res) const {
 
     res.big_int_clear();
     res.big_int_unsigned_add(b);
@@ -153,45 +439,37 @@ int bi::big_int::big_int_signed_add(const bi::big_int &b) {
 
 }
 
-int bi::big_int::big_int_signed_add(const bi::big_int &b, bi::big_int &res) {
+int bi::big_int::big_int_signed_add(const bi::big_int &b, bi::big_int &res) const {
+
+    return _big_int_signed_add(b, b._neg, res);
+
+}
+
+/* res = *this + b, with b_neg used as the sign of b. */
+int bi::big_int::_big_int_signed_add(const bi::big_int &b, bool b_neg, bi::big_int &res) const {
 
     res.big_int_clear();
     /* If the operands are of same sign. */
-    if (_neg == b._neg) {
+    if (_neg == b_neg) {
 
         big_int_unsigned_add(b, res);
         res._neg = _neg;
 
     }
-    /* If operands are of different sign. */
+    /* If operands are of different sign, the larger magnitude decides the sign. */
     else {
 
-        /* Convert to same type. */
-        _neg = !_neg;
-        int comp_stat = big_int_compare(b);
-        if (comp_stat == 1) {
-            if (_neg) {
-                b.big_int_unsigned_sub(*this, res);
-                res._neg = b._neg;
-            } else {
-                big_int_unsigned_sub(b, res);
-                res._neg = !_neg;
-            }
+        int comp_stat = big_int_unsigned_compare(b);
+        if (comp_stat > 0) {
+            big_int_unsigned_sub(b, res);
+            res._neg = _neg;
         } else if (comp_stat == 0) {
             res.big_int_set_zero();
         } else {
-            if (_neg) {
-                big_int_unsigned_sub(b, res);
-                res._neg = !_neg;
-            } else {
-                b.big_int_unsigned_sub(*this, res);
-                res._neg = b._neg;
-            }
+            b.big_int_unsigned_sub(*this, res);
+            res._neg = b_neg;
         }
 
-        /* Set back to previous type. */
-        _neg = !_neg;
-
     }
 
     /* Remove any preceding zeroes if any. */
@@ -237,18 +515,10 @@ int bi::big_int::big_int_signed_sub(const bi::big_int &b) {
 
 }
 
-int bi::big_int::big_int_signed_sub(const bi::big_int &b, bi::big_int &res) {
+int bi::big_int::big_int_signed_sub(const bi::big_int &b, bi::big_int &res) const {
 
-    int comp_stat = big_int_compare(b);
-    if (comp_stat == 0) {
-        return res.big_int_set_zero();
-    } else {
-
-        // TODO: avoid expensive (might be) copy here
-        bi::big_int temp_sub(b);
-        temp_sub._neg = !temp_sub._neg;
-        return big_int_signed_add(temp_sub, res);
-    }
+    /* a - b = a + (-b), b is read with its sign flipped instead of negating a copy. */
+    return _big_int_signed_add(b, !b._neg, res);
 
 }
 
@@ -278,8 +548,9 @@ int bi::big_int::big_int_unsigned_sub(const bi::big_int &b, bi::big_int &res) co
     res.big_int_clear();
     BI_BASE_TYPE borrow = _big_int_sub_base_type(b._data, min, res);
 
-    if((max - min) >= res._total_data) {
-        res._big_int_expand(BI_DEFAULT_EXPAND_COUNT + (max - min));
+    /* The low min words are already in res, the rest go on top of them. */
+    if(max >= res._total_data) {
+        res._big_int_expand(BI_DEFAULT_EXPAND_COUNT + max);
     }
 
     for(int i = min; i < max; i++) {
@@ -309,9 +580,15 @@ int bi::big_int::big_int_unsigned_sub(const bi::big_int &b) {
 
 }
 
-int bi::big_int::big_int_multiply(const bi::big_int &b, bi::big_int &res) {
+int bi::big_int::big_int_multiply(const bi::big_int &b, bi::big_int &res) const {
 
     bi::big_int temp_bi;
+    return _big_int_multiply(b, res, temp_bi);
+
+}
+
+/* Schoolbook product, temp_bi holds one partial product at a time. */
+int bi::big_int::_big_int_multiply(const bi::big_int &b, bi::big_int &res, bi::big_int &temp_bi) const {
 
     res.big_int_set_zero();
 
@@ -332,6 +609,13 @@ int bi::big_int::big_int_multiply(const bi::big_int &b, bi::big_int &res) {
 
 }
 
+int bi::big_int::big_int_multiply(const bi::big_int_view &b, bi::big_int &res) const {
+
+    const big_int borrowed_b(b, borrow_tag{});
+    return big_int_multiply(borrowed_b, res);
+
+}
+
 int bi::big_int::big_int_unsigned_multiply_base_type(const BI_BASE_TYPE &b, bi::big_int &res) const {
 
     return _big_int_unsigned_multiply_bi_base_type(b, res);
@@ -346,47 +630,36 @@ int bi::big_int::big_int_clear() {
     return 0;
 }
 
-std::string     bi::big_int::big_int_to_string(bi::bi_base base) {
-
-    std::string tmp_op_str, hex_str = _big_int_to_string();
-
-    bool is_neg = false;
-    if (hex_str[0] == '-') {
-        is_neg = true;
-        hex_str = hex_str.substr(1);
-    }
-
-    size_t n = hex_str.find_first_not_of('0');
-    if (n != std::string::npos) {
-        hex_str = hex_str.substr(n);
-    }
-    else {
-        hex_str = "0";
-    }
+std::string     bi::big_int::big_int_to_string(bi::bi_base base) const {
 
+    std::string op_str;
     switch (base) {
+        case bi_base::BI_HEX:
+            /* Formatted straight into the result, sized up front. */
+            op_str.assign(static_cast<size_t>(_big_int_get_num_of_hex_chars()) + (_neg ? 1 : 0), '0');
+            big_int_to_hex_chars(&op_str[0], &op_str[0] + op_str.size());
+            break;
         case bi_base::BI_BIN: {
-            BaseConverter hex_to_bin(hex_num_set, bin_num_set);
-            tmp_op_str = hex_to_bin.Convert(hex_str);
+            /* Sized for whole limbs, trimmed to what was written. */
+            op_str.assign(static_cast<size_t>(_top) * BI_BASE_TYPE_TOTAL_BITS + 1, '0');
+            std::to_chars_result format_res = big_int_to_bin_chars(&op_str[0], &op_str[0] + op_str.size());
+            op_str.resize(static_cast<size_t>(format_res.ptr - op_str.data()));
             break;
         }
         case bi_base::BI_DEC: {
-            BaseConverter hex_to_dec(hex_num_set, dec_num_set);
-            tmp_op_str = hex_to_dec.Convert(hex_str);
+            if (_neg) {
+                op_str.push_back('-');
+            }
+            radix_limbs limbs(_data, _data + _top);
+            radix_normalize(limbs);
+            radix_limbs_to_dec(limbs, [&op_str](const char *chars, size_t count) { op_str.append(chars, count); });
             break;
         }
-        case bi_base::BI_HEX:
-            tmp_op_str = hex_str;
-            break;
         default:
             throw std::invalid_argument("Invalid base");
-    }   
-
-    if (is_neg) {
-        tmp_op_str.insert(0, "-");
     }
 
-    return tmp_op_str;
+    return op_str;
 
 }
 
@@ -446,6 +719,20 @@ int bi::big_int::big_int_compare(const bi::big_int &other) const {
     }
 }
 
+int bi::big_int::big_int_unsigned_compare(const bi::big_int_view &other) const {
+
+    const big_int borrowed_other(other, borrow_tag{});
+    return big_int_unsigned_compare(borrowed_other);
+
+}
+
+int bi::big_int::big_int_compare(const bi::big_int_view &other) const {
+
+    const big_int borrowed_other(other, borrow_tag{});
+    return big_int_compare(borrowed_other);
+
+}
+
 int bi::big_int::big_int_left_shift(int bits) {
 
     int ret_val = 0;
@@ -461,7 +748,7 @@ int bi::big_int::big_int_left_shift(int bits) {
 
 }
 
-int bi::big_int::big_int_left_shift(int bits, bi::big_int &res) {
+int bi::big_int::big_int_left_shift(int bits, bi::big_int &res) const {
 
     int ret_val;
     big_int temp_val(*this);
@@ -471,7 +758,7 @@ int bi::big_int::big_int_left_shift(int bits, bi::big_int &res) {
 
 }
 
-int bi::big_int::big_int_left_shift_word(int shift_words, bi::big_int &res) {
+int bi::big_int::big_int_left_shift_word(int shift_words, bi::big_int &res) const {
 
     int ret_val;
     big_int temp_val(*this);
@@ -501,7 +788,7 @@ int bi::big_int::big_int_right_shift_word(int shift_words) {
 
 }
 
-int bi::big_int::big_int_right_shift_word(int shift_words, bi::big_int &res) {
+int bi::big_int::big_int_right_shift_word(int shift_words, bi::big_int &res) const {
 
     int ret_val;
     big_int temp_val(*this);
@@ -526,7 +813,7 @@ int bi::big_int::big_int_right_shift(int bits) {
 
 }
 
-int bi::big_int::big_int_right_shift(int bits, bi::big_int &res) {
+int bi::big_int::big_int_right_shift(int bits, bi::big_int &res) const {
 
     int ret_val;
     big_int temp_val(*this);
@@ -548,14 +835,26 @@ int bi::big_int::big_int_push_back_hex_chars(const BI_BASE_TYPE &hex_chars) {
 
 }
 
-int bi::big_int::big_int_divide_once(const bi::big_int &divisor, BI_BASE_TYPE &op_quotient, bi::big_int &op_remainder) {
+int bi::big_int::big_int_divide_once(const bi::big_int &divisor, BI_BASE_TYPE &op_quotient, bi::big_int &op_remainder) const {
 
     return _big_int_divide_once(divisor, op_quotient, op_remainder);
 
 }
 
-int bi::big_int::big_int_div(const bi::big_int &divisor, bi::big_int &op_quotient, bi::big_int &op_remainder) {
+int bi::big_int::big_int_div(const bi::big_int &divisor, bi::big_int &op_quotient, bi::big_int &op_remainder) const {
+
+    big_int_workspace workspace;
+    return big_int_div(divisor, op_quotient, op_remainder, workspace);
 
+}
+
+int bi::big_int::big_int_div(
+    const bi::big_int &divisor, 
+    bi::big_int &op_quotient, 
+    bi::big_int &op_remainder, 
+    bi::big_int_workspace &workspace) const {
+
+    _BI_STAT_ADD(BI_STAT_DIVISIONS, 1);
     if (divisor.big_int_is_zero()) {
         // throw std::length_error("Division by zero undefined");
         return -1;
@@ -575,7 +874,7 @@ int bi::big_int::big_int_div(const bi::big_int &divisor, bi::big_int &op_quotien
     case -1:
         /* Divisor is greater than dividend, set quotient as zero 
         and remainder as dividend */
-        op_remainder = *this;
+        op_remainder._big_int_assign(*this);
         /* Remainder takes the sign of dividend. */
         op_remainder.big_int_set_negetive(_neg);
         op_quotient.big_int_set_zero();
@@ -591,31 +890,40 @@ int bi::big_int::big_int_div(const bi::big_int &divisor, bi::big_int &op_quotien
         op_quotient.big_int_set_zero();
 
         BI_BASE_TYPE temp_div_once_quotient, temp_new_hex_rem_lsb = 0;
-        bi::big_int temp_div_once_dividend, temp_div_once_remainder; 
+        big_int_workspace_frame frame(workspace);
+        bi::big_int &temp_div_once_dividend = frame.big_int_workspace_frame_get();
+        bi::big_int &temp_div_once_remainder = frame.big_int_workspace_frame_get();
+        bi::big_int &temp_div_once_scratch = frame.big_int_workspace_frame_get();
         int divisor_length = divisor._big_int_get_num_of_hex_chars();
         int dividend_length = _big_int_get_num_of_hex_chars();
-        int ret_code = big_int_right_shift((dividend_length - divisor_length) * 4, temp_div_once_dividend);
+        int ret_code = temp_div_once_dividend._big_int_assign(*this);
+        ret_code += temp_div_once_dividend.big_int_right_shift((dividend_length - divisor_length) * 4);
         int divide_cntr = 0;
         
         do {
         
+            if (big_int_cancel_scope::cancellation_requested()) {
+                return -1;
+            }
+
             /* Divide once. */
             temp_div_once_quotient = 0;
             temp_div_once_remainder.big_int_clear();
-            ret_code += temp_div_once_dividend._big_int_divide_once(divisor, temp_div_once_quotient, temp_div_once_remainder);
+            ret_code += temp_div_once_dividend._big_int_divide_once(divisor, temp_div_once_quotient, temp_div_once_remainder, \
+                temp_div_once_scratch);
             ret_code += op_quotient._big_int_push_back_hex_chars(temp_div_once_quotient);
 
             if ((dividend_length - divisor_length - divide_cntr - 1) >= 0) {
                 ret_code += _big_int_get_hex_char_from_lsb(dividend_length - divisor_length - divide_cntr - 1, temp_new_hex_rem_lsb);
             } 
             
-            temp_div_once_dividend = temp_div_once_remainder;
+            ret_code += temp_div_once_dividend._big_int_assign(temp_div_once_remainder);
             ret_code += temp_div_once_dividend.big_int_push_back_hex_chars(temp_new_hex_rem_lsb);
             ++divide_cntr;
         
         } while ((dividend_length - divisor_length + 1 - divide_cntr) > 0 && ret_code == 0);
         
-        op_remainder = temp_div_once_remainder;
+        op_remainder._big_int_assign(temp_div_once_remainder);
         op_quotient.big_int_set_negetive(result_sign);
 
         /* Remainder takes the sign of dividend. */
@@ -630,7 +938,14 @@ int bi::big_int::big_int_div(const bi::big_int &divisor, bi::big_int &op_quotien
 
 }
 
-int bi::big_int::big_int_power_base_type(const BI_BASE_TYPE &exponent, big_int &result) {
+int bi::big_int::big_int_div(const bi::big_int_view &divisor, bi::big_int &op_quotient, bi::big_int &op_remainder) const {
+
+    const big_int borrowed_divisor(divisor, borrow_tag{});
+    return big_int_div(borrowed_divisor, op_quotient, op_remainder);
+
+}
+
+int bi::big_int::big_int_power_base_type(const BI_BASE_TYPE &exponent, big_int &result) const {
 
     int ret_val = 0;
 
@@ -656,23 +971,32 @@ int bi::big_int::big_int_power_base_type(const BI_BASE_TYPE &exponent, big_int &
 
 }
 
-int bi::big_int::big_int_modulus(const big_int &modulus, big_int &result) {
+int bi::big_int::big_int_modulus(const big_int &modulus, big_int &result) const {
+
+    big_int_workspace workspace;
+    return big_int_modulus(modulus, result, workspace);
+
+}
+
+int bi::big_int::big_int_modulus(const big_int &modulus, big_int &result, big_int_workspace &workspace) const {
 
-    big_int temp_quo, temp_rem;
+    big_int_workspace_frame frame(workspace);
+    big_int &temp_quo = frame.big_int_workspace_frame_get();
+    big_int &temp_rem = frame.big_int_workspace_frame_get();
     int ret_val = 0;
 
-    ret_val += big_int_div(modulus, temp_quo, temp_rem);
+    ret_val += big_int_div(modulus, temp_quo, temp_rem, workspace);
     if (modulus.big_int_is_negetive() == false) {
         if (temp_rem.big_int_is_negetive() == true) {
             ret_val += modulus.big_int_unsigned_sub(temp_rem, result);
         } else {
-            result = temp_rem;
+            result._big_int_assign(temp_rem);
         }
     } else {
         if ((temp_rem.big_int_is_negetive() == false) && (temp_rem.big_int_is_zero() == false)) {
             ret_val += modulus.big_int_unsigned_sub(temp_rem, result);   
         } else {
-            result = temp_rem;
+            result._big_int_assign(temp_rem);
         }
         if (result.big_int_is_zero() == false) {
             ret_val += result.big_int_set_negetive(true);
@@ -682,6 +1006,13 @@ int bi::big_int::big_int_modulus(const big_int &modulus, big_int &result) {
 
 }
 
+int bi::big_int::big_int_modulus(const big_int_view &modulus, big_int &result) const {
+
+    const big_int borrowed_modulus(modulus, borrow_tag{});
+    return big_int_modulus(borrowed_modulus, result);
+
+}
+
 bool bi::big_int::big_int_is_even() const {
 
     if (_top > 0) {
@@ -740,11 +1071,23 @@ bool bi::big_int::big_int_is_even() const {
 
 */
 
-int bi::big_int::big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result) {
+int bi::big_int::big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result) const {
+
+    big_int_workspace workspace;
+    return big_int_fast_modular_exponentiation(exponent, modulus, result, workspace);
+
+}
+
+int bi::big_int::big_int_fast_modular_exponentiation(
+    const big_int &exponent, 
+    const big_int &modulus, 
+    big_int &result, 
+    big_int_workspace &workspace) const {
 
     int ret_val = 0;
 
-    big_int bi_1;
+    big_int_workspace_frame frame(workspace);
+    big_int &bi_1 = frame.big_int_workspace_frame_get();
     bi_1.big_int_from_base_type(1, false);
     /* Compare modulus with one. */
     int comp_res = modulus.big_int_unsigned_compare(bi_1);
@@ -754,11 +1097,11 @@ int bi::big_int::big_int_fast_modular_exponentiation(const big_int &exponent, co
     if (exp_comp_res == 0) {
         if (exponent.big_int_is_negetive() == false) {
             /* Compare exponent with 1, return early with mod of base. */
-            return (*this).big_int_modulus(modulus, result);
+            return (*this).big_int_modulus(modulus, result, workspace);
         } else {
             /* Compare exponent with -1, return early with inverse of base. */
             try {
-                ret_val += (*this).big_int_modular_inverse_extended_euclidean_algorithm(modulus, result);
+                ret_val += (*this).big_int_modular_inverse_extended_euclidean_algorithm(modulus, result, workspace);
             } catch (...) {
                 throw;
             }
@@ -780,7 +1123,7 @@ int bi::big_int::big_int_fast_modular_exponentiation(const big_int &exponent, co
             throw std::range_error("Given base (0) doesn't have inverse. ");
         } else if (exponent.big_int_is_zero() == true) {
             if (modulus.big_int_is_negetive() == false) {
-                result = bi_1;
+                result._big_int_assign(bi_1);
             } else {
                 ret_val += modulus.big_int_unsigned_sub(bi_1, result);  
                 ret_val += result.big_int_set_negetive(true);
@@ -789,21 +1132,109 @@ int bi::big_int::big_int_fast_modular_exponentiation(const big_int &exponent, co
         }
     }
     
-    if (exponent.big_int_is_negetive() == false) {
+    if (exponent.big_int_is_negetive() == false && modulus.big_int_is_negetive() == false && \
+        modulus.big_int_is_even() == false && modulus._top > 1) {
+        /* Odd multi word modulus, Montgomery exponentiation with the context from the cache. */
+        std::shared_ptr<const big_int_montgomery_ctx> modulus_ctx = big_int_montgomery_cache::big_int_montgomery_cache_get(modulus);
+        if ((*this).big_int_is_negetive() == true || (*this).big_int_unsigned_compare(modulus) >= 0) {
+            big_int &reduced_base = frame.big_int_workspace_frame_get();
+            ret_val += (*this).big_int_modulus(modulus, reduced_base, workspace);
+            ret_val += modulus_ctx->big_int_montgomery_modular_exponentiation(reduced_base, exponent, result);
+        } else {
+            ret_val += modulus_ctx->big_int_montgomery_modular_exponentiation(*this, exponent, result);
+        }
+    } else if (exponent.big_int_is_negetive() == false) {
         /* +ve exponent, follow usual algorithm. */
-        ret_val += (*this)._big_int_fast_modular_exponentiation(exponent, modulus, result);
+        ret_val += (*this)._big_int_fast_modular_exponentiation(exponent, modulus, result, workspace);
     } else {
         /* -ve exponent,  find inverse of base first. */
-        big_int temp_inverse;
+        big_int &temp_inverse = frame.big_int_workspace_frame_get();
         try {
-            ret_val += (*this).big_int_modular_inverse_extended_euclidean_algorithm(modulus, temp_inverse);
+            ret_val += (*this).big_int_modular_inverse_extended_euclidean_algorithm(modulus, temp_inverse, workspace);
         } catch (...) {
             throw;
         }
-        big_int us_exp(exponent);
+        big_int &us_exp = frame.big_int_workspace_frame_get();
+        us_exp._big_int_assign(exponent);
         us_exp.big_int_set_negetive(false);
         /* Do modular exponentiation on inverse of the original base to get the final result. */
-        ret_val += temp_inverse.big_int_fast_modular_exponentiation(us_exp, modulus, result);
+        ret_val += temp_inverse.big_int_fast_modular_exponentiation(us_exp, modulus, result, workspace);
+    }
+    return ret_val;
+
+}
+
+int bi::big_int::big_int_fast_modular_exponentiation(
+    const big_int &exponent, 
+    const big_int &modulus, 
+    big_int &result, 
+    const big_int_cancel_token &cancel_token) const {
+
+    int ret_val;
+    {
+        big_int_cancel_scope modexp_cancel_scope(cancel_token);
+        ret_val = big_int_fast_modular_exponentiation(exponent, modulus, result);
+    }
+
+    if (cancel_token.is_cancelled()) {
+        return cancel_token.has_timed_out() ? BI_STATUS_TIMED_OUT : BI_STATUS_CANCELLED;
+    }
+    return ret_val;
+
+}
+
+int bi::big_int::big_int_fast_modular_exponentiation(const big_int_view &exponent, const big_int_view &modulus, big_int &result) const {
+
+    const big_int borrowed_exponent(exponent, borrow_tag{}), borrowed_modulus(modulus, borrow_tag{});
+    return big_int_fast_modular_exponentiation(borrowed_exponent, borrowed_modulus, result);
+
+}
+
+int bi::big_int::big_int_multi_modular_exponentiation(
+    const big_int *bases,
+    const big_int *exponents,
+    const big_int *moduli,
+    big_int *results,
+    size_t count) {
+
+    return _big_int_multi_modular_exponentiation(bases, exponents, moduli, results, count, true);
+
+}
+
+int bi::big_int::_big_int_multi_modular_exponentiation(
+    const big_int *bases,
+    const big_int *exponents,
+    const big_int *moduli,
+    big_int *results,
+    size_t count,
+    bool cache_contexts) {
+
+    int ret_val = 0;
+    std::vector<std::shared_ptr<const big_int_montgomery_ctx>> ctxs;
+    std::vector<const big_int_montgomery_ctx *> multi_ctxs;
+    std::vector<big_int> multi_bases, multi_exponents, multi_results;
+    std::vector<size_t> multi_index;
+
+    for (size_t i = 0; i < count; ++i) {
+        bool montgomery_ok = moduli[i].big_int_is_negetive() == false && moduli[i].big_int_is_even() == false && \
+            moduli[i].big_int_get_num_of_base_type() > 1 && exponents[i].big_int_is_negetive() == false;
+        if (montgomery_ok == false) {
+            ret_val += bases[i].big_int_fast_modular_exponentiation(exponents[i], moduli[i], results[i]);
+            continue;
+        }
+        ctxs.push_back(cache_contexts ? big_int_montgomery_cache::big_int_montgomery_cache_get(moduli[i]) : \
+            std::make_shared<const big_int_montgomery_ctx>(moduli[i]));
+        multi_ctxs.push_back(ctxs.back().get());
+        multi_bases.push_back(bases[i]);
+        multi_exponents.push_back(exponents[i]);
+        multi_index.push_back(i);
+    }
+
+    multi_results.resize(multi_index.size());
+    ret_val += big_int_montgomery_ctx::big_int_montgomery_multi_modular_exponentiation(multi_ctxs.data(), \
+        multi_bases.data(), multi_exponents.data(), multi_results.data(), multi_index.size());
+    for (size_t k = 0; k < multi_index.size(); ++k) {
+        results[multi_index[k]] = std::move(multi_results[k]);
     }
     return ret_val;
 
@@ -834,7 +1265,14 @@ int bi::big_int::big_int_fast_modular_exponentiation(const big_int &exponent, co
 
 */
 
-int bi::big_int::big_int_gcd_euclidean_algorithm(const big_int &b, big_int &op_gcd) {
+int bi::big_int::big_int_gcd_euclidean_algorithm(const big_int &b, big_int &op_gcd) const {
+
+    big_int_workspace workspace;
+    return big_int_gcd_euclidean_algorithm(b, op_gcd, workspace);
+
+}
+
+int bi::big_int::big_int_gcd_euclidean_algorithm(const big_int &b, big_int &op_gcd, big_int_workspace &workspace) const {
 
     if (((*this).big_int_is_zero() & b.big_int_is_zero()) == true) {
         /* If both numbers are zero gcd is zero. */
@@ -842,48 +1280,48 @@ int bi::big_int::big_int_gcd_euclidean_algorithm(const big_int &b, big_int &op_g
     } else if ((*this).big_int_is_zero()) {
         /* If one of the number is zero and other is non zero then gcd is the non
         zero number. */
-        op_gcd = b;
+        op_gcd._big_int_assign(b);
         return  op_gcd.big_int_set_negetive(false);
     } else if (b.big_int_is_zero()) {
         /* If one of the number is zero and other is non zero then gcd is the non
         zero number. */
-        op_gcd = (*this);
+        op_gcd._big_int_assign(*this);
         return op_gcd.big_int_set_negetive(false);    
     }
 
     /* Temp working variables. */
-    big_int temp_greater, temp_lower, temp_quo, temp_rem, prev_rem;
+    big_int_workspace_frame frame(workspace);
+    big_int &temp_greater = frame.big_int_workspace_frame_get();
+    big_int &temp_lower = frame.big_int_workspace_frame_get();
+    big_int &temp_quo = frame.big_int_workspace_frame_get();
+    big_int &temp_rem = frame.big_int_workspace_frame_get();
 
     /* Compare and assign greater and lower big int temp variables. */
     int ret_code = 0, comp_stat = (*this).big_int_unsigned_compare(b);
     if (comp_stat == 0) {
         /* If both numbers are equal then gcd is equal to the +ve number. */
-        op_gcd = (*this);
+        op_gcd._big_int_assign(*this);
         return op_gcd.big_int_set_negetive(false);
     } else if (comp_stat == 1) {
-        temp_greater = (*this);
-        temp_lower = b;
+        temp_greater._big_int_assign(*this);
+        temp_lower._big_int_assign(b);
     } else {
-        temp_greater = b;
-        temp_lower = (*this);
+        temp_greater._big_int_assign(b);
+        temp_lower._big_int_assign(*this);
     }
 
     /* Set the numbers as positve as the gcd is +ve. */
     temp_greater.big_int_set_negetive(false); temp_lower.big_int_set_negetive(false);
 
-    /* Initialse the temp_rem and thus prev_rem with the lower number so that,
-    the gcd will be the lower number when both numbers are multiples. */
-    temp_rem = temp_lower;
+    /* GCD Euclidean algorithm (refer func. docs.), the values rotate through the 
+    three buffers, once the remainder is zero the last divisor (now temp_greater) is the gcd. */
     do {
-        /* GCD Euclidean algorithm (refer func. docs.) */
-        prev_rem = temp_rem;
-        ret_code += temp_greater.big_int_div(temp_lower, temp_quo, temp_rem);
-        temp_greater = temp_lower;
-        temp_lower = temp_rem;
-    } while(temp_rem.big_int_is_zero() == false);
-
-    /* Assign previous remainder as the gcd. */
-    op_gcd = prev_rem;
+        ret_code += temp_greater.big_int_div(temp_lower, temp_quo, temp_rem, workspace);
+        temp_greater._big_int_swap(temp_lower);
+        temp_lower._big_int_swap(temp_rem);
+    } while(temp_lower.big_int_is_zero() == false && ret_code == 0);
+
+    op_gcd._big_int_assign(temp_greater);
     return ret_code;
 
 }
@@ -917,19 +1355,42 @@ Find the inverse of 15 mod 26.
 
 */
 
-int bi::big_int::big_int_modular_inverse_extended_euclidean_algorithm(const big_int &ip_modulus, big_int &inverse) {
+int bi::big_int::big_int_modular_inverse_extended_euclidean_algorithm(const big_int &ip_modulus, big_int &inverse) const {
+
+    big_int_workspace workspace;
+    return big_int_modular_inverse_extended_euclidean_algorithm(ip_modulus, inverse, workspace);
+
+}
+
+int bi::big_int::big_int_modular_inverse_extended_euclidean_algorithm(
+    const big_int &ip_modulus, 
+    big_int &inverse, 
+    big_int_workspace &workspace) const {
 
-    big_int bi_1;
+    big_int_workspace_frame frame(workspace);
+    big_int &bi_1 = frame.big_int_workspace_frame_get();
     bi_1.big_int_from_base_type(1, false);
 
     /* Extended euclidean algorithm (EEA) working variables */
-    big_int pk_0, pk_1, pk_temp_1, pk_temp_2;
+    big_int &pk_0 = frame.big_int_workspace_frame_get();
+    big_int &pk_1 = frame.big_int_workspace_frame_get();
+    big_int &pk_temp_1 = frame.big_int_workspace_frame_get();
+    big_int &pk_temp_2 = frame.big_int_workspace_frame_get();
+    big_int &pk_mul_scratch = frame.big_int_workspace_frame_get();
     int step_cntr = 0;
     /* Temp working variables. */
-    big_int temp_greater, temp_lower, temp_quo, temp_rem, prev_rem, prev_quo[2];
+    big_int &temp_greater = frame.big_int_workspace_frame_get();
+    big_int &temp_lower = frame.big_int_workspace_frame_get();
+    big_int &temp_quo = frame.big_int_workspace_frame_get();
+    big_int &temp_rem = frame.big_int_workspace_frame_get();
+    big_int &prev_quo_0 = frame.big_int_workspace_frame_get();
+    big_int &prev_quo_1 = frame.big_int_workspace_frame_get();
 
     /* Temporary working copies. */
-    big_int ip_num(*this), modulus(ip_modulus);
+    big_int &ip_num = frame.big_int_workspace_frame_get();
+    big_int &modulus = frame.big_int_workspace_frame_get();
+    ip_num._big_int_assign(*this);
+    modulus._big_int_assign(ip_modulus);
     int ret_code = 0;
 
     /* Do calculation as if they are +ve numbers. */
@@ -954,46 +1415,54 @@ int bi::big_int::big_int_modular_inverse_extended_euclidean_algorithm(const big_
         throw std::range_error("The number is not invertible for the given modulus");
     } else if (comp_stat > 0) {
         /* If greater then reduce. */
-        big_int temp_res;
-        ret_code += ip_num.big_int_modulus(modulus, temp_res);
-        ip_num = temp_res;
+        ret_code += ip_num.big_int_modulus(modulus, ip_num, workspace);
+        if (ip_num.big_int_is_zero() == true) {
+            throw std::range_error("The number is not invertible for the given modulus");
+        } else if (ip_num.big_int_unsigned_compare(bi_1) == 0) {
+            /* Reduces to 1, same as the number being 1 above. */
+            pk_1.big_int_from_base_type(1, false);
+            goto change_inverse_based_on_arg_sign;
+        }
     }
 
     /* Init the variables to 0 and 1. */
     pk_1.big_int_from_base_type(1, false);
 
-    temp_greater = modulus;
-    temp_lower = ip_num;
-    temp_rem = temp_lower;
+    temp_greater._big_int_assign(modulus);
+    temp_lower._big_int_assign(ip_num);
 
-    /* Extended euclidean algorithm */
+    /* Extended euclidean algorithm, the quotients and remainders rotate through the buffers
+    instead of being copied, the last non zero remainder ends up in temp_greater. */
     do {
         ++step_cntr;
-        prev_rem = temp_rem;
-        prev_quo[0] = prev_quo[1];
-        prev_quo[1] = temp_quo;
-        ret_code += temp_greater.big_int_div(temp_lower, temp_quo, temp_rem);
-        temp_greater = temp_lower;
-        temp_lower = temp_rem;
+        prev_quo_0._big_int_swap(prev_quo_1);
+        prev_quo_1._big_int_swap(temp_quo);
+        ret_code += temp_greater.big_int_div(temp_lower, temp_quo, temp_rem, workspace);
+        temp_greater._big_int_swap(temp_lower);
+        temp_lower._big_int_swap(temp_rem);
         if (step_cntr > 2) {
             /* pi = [pi-2 - (pi-1 * qi-2)] (mod n) */
-            ret_code += pk_1.big_int_multiply(prev_quo[0], pk_temp_1);
+            ret_code += pk_1._big_int_multiply(prev_quo_0, pk_temp_1, pk_mul_scratch);
             ret_code += pk_0.big_int_signed_sub(pk_temp_1, pk_temp_2);
-            pk_0 = pk_1;
-            ret_code += pk_temp_2.big_int_modulus(modulus, pk_1);
+            pk_0._big_int_swap(pk_1);
+            ret_code += pk_temp_2.big_int_modulus(modulus, pk_1, workspace);
         }
-    } while(temp_rem.big_int_is_zero() == false);
+    } while(temp_lower.big_int_is_zero() == false && ret_code == 0);
 
-    if (prev_rem.big_int_compare(bi_1) != 0) {
+    if (ret_code != 0) {
+        /* Cancelled division, the partial values mean nothing. */
+        return ret_code;
+    }
+    if (temp_greater.big_int_compare(bi_1) != 0) {
         /* Throw if the GCD of the args is not 1, which means, the
         numbers are not co - primes. */ 
         throw std::range_error("The number is not invertible for the given modulus");
     }
 
     /* Final iteration. */
-    ret_code += pk_1.big_int_multiply(prev_quo[1], pk_temp_1);
+    ret_code += pk_1._big_int_multiply(prev_quo_1, pk_temp_1, pk_mul_scratch);
     ret_code += pk_0.big_int_signed_sub(pk_temp_1, pk_temp_2);
-    ret_code += pk_temp_2.big_int_modulus(modulus, pk_1);
+    ret_code += pk_temp_2.big_int_modulus(modulus, pk_1, workspace);
 
 change_inverse_based_on_arg_sign:
     /* Use the argument signs to change final pk_1. 
@@ -1002,13 +1471,13 @@ change_inverse_based_on_arg_sign:
         if ((*this).big_int_is_negetive() == true) {
             ret_code += modulus.big_int_unsigned_sub(pk_1, inverse);
         } else {
-            inverse = pk_1;
+            inverse._big_int_assign(pk_1);
         }
     } else {
         if (((*this).big_int_is_negetive() == false) && ((*this).big_int_is_zero() == false)) {
             ret_code += modulus.big_int_unsigned_sub(pk_1, inverse);   
         } else {
-            inverse = pk_1;
+            inverse._big_int_assign(pk_1);
         }
         ret_code += inverse.big_int_set_negetive(true);
     }
@@ -1020,11 +1489,7 @@ change_inverse_based_on_arg_sign:
 
 int bi::big_int::big_int_get_random_unsigned(int bits) {
 
-    std::random_device dev;
-    std::mt19937 rng(dev());
-    std::uniform_int_distribution<BI_BASE_TYPE> rand_dist(0, 0xFFFFFFFF);
-
-    return _big_int_generate_random_unsigned(bits, rng, rand_dist);
+    return _big_int_generate_random_unsigned(bits, big_int_chacha20_rng::thread_instance());
 
 }
 
@@ -1075,76 +1540,44 @@ int bi::big_int::big_int_get_num_of_bits() const {
 int bi::big_int::big_int_get_random_unsigned_between(const big_int &low, const big_int &high) {
 
 
-    std::random_device rd;                              // only used once to initialise (seed) engine
-    std::mt19937 rng(rd());                             // random-number engine used (Mersenne-Twister in this case)
-    std::uniform_int_distribution<BI_BASE_TYPE> uni_dist(0, 0xFFFFFFFF);
-    std::uniform_int_distribution<int> get_rand_bits(low.big_int_get_num_of_bits(), high.big_int_get_num_of_bits());    
-
-    return _big_int_get_random_unsigned_between(rng, uni_dist, get_rand_bits, low, high);
+    return _big_int_get_random_unsigned_between(big_int_chacha20_rng::thread_instance(), low, high);
 
 }
 
 int bi::big_int::big_int_get_random_unsigned_prime_rabin_miller(int bits, int reqd_rabin_miller_iterations) {
 
+    return big_int_get_random_unsigned_prime_rabin_miller(bits, reqd_rabin_miller_iterations, big_int_system_random_source::instance());
+
+}
+
+int bi::big_int::big_int_get_random_unsigned_prime_rabin_miller(int bits, int reqd_rabin_miller_iterations, big_int_random_source &random_source) {
+
     int ret_val = 0;
+    big_int_trace_span trace_span("prime_search_single", "prime_search");
+    trace_span.big_int_trace_span_arg("bits", bits);
 
-    std::random_device rd;
-    std::mt19937 rng(rd()); 
-    std::uniform_int_distribution<BI_BASE_TYPE> uni_dist(0, 0xFFFFFFFF);
+    /* Deterministic sources draw candidate number k from sub stream k, matching the threaded search. */
+    bool per_candidate_streams = random_source.is_deterministic();
     
-    while (ret_val == 0) {
-
-        big_int candidate_num, bi_1, bi_2, candidate_num_sub_1, candidate_num_sub_1_copy, prev_candidate_num_sub_1;
-        ret_val += candidate_num._big_int_generate_random_probable_prime(bits, rng, uni_dist, -1); /* -1 -> Use all prime numbers in the array. */ 
-        ret_val += bi_1.big_int_from_base_type(1, false);
-        ret_val += bi_2.big_int_from_base_type(2, false);
-        std::uniform_int_distribution<int> uni_dist_rand_bits(bi_2.big_int_get_num_of_bits(), candidate_num.big_int_get_num_of_bits());
-
-        int max_div_by_two = 0;
-        BI_BASE_TYPE div_2_rem;
-        ret_val += candidate_num.big_int_unsigned_sub(bi_1, candidate_num_sub_1);
-        candidate_num_sub_1_copy = candidate_num_sub_1;
-
-        prev_candidate_num_sub_1 = candidate_num_sub_1;
-        ret_val += candidate_num_sub_1._big_int_fast_divide_by_two(div_2_rem);
-        while (div_2_rem == 0) {
-            ++max_div_by_two;
-            prev_candidate_num_sub_1 = candidate_num_sub_1;
-            ret_val += candidate_num_sub_1._big_int_fast_divide_by_two(div_2_rem);
-        }
+    for (uint64_t candidate_index = 0; ret_val == 0; ++candidate_index) {
 
-        //std::cout<<"d: "<<max_div_by_two<<" num: "<<prev_candidate_num_sub_1.big_int_to_string(bi_base::BI_HEX)<<"\n";
-        //break;
-        int i = 0;
-        for (; i < reqd_rabin_miller_iterations; ++i) {
-            big_int this_round_random_bi;
-            ret_val += this_round_random_bi._big_int_get_random_unsigned_between(rng, uni_dist, uni_dist_rand_bits, bi_2, candidate_num);
-
-            big_int mod_exp_res;
-            bool composite_test = true;
-            ret_val += this_round_random_bi.big_int_fast_modular_exponentiation(prev_candidate_num_sub_1, candidate_num, mod_exp_res);
-            if (mod_exp_res.big_int_unsigned_compare(bi_1) == 0) {
-                composite_test = false;
-            }
-            else {
-                for (int j = 0; j < max_div_by_two; ++j) {
-                    big_int temp_exp, fast_mul_bi_1(bi_1);
-                    ret_val += fast_mul_bi_1.big_int_left_shift(j);
-                    ret_val += prev_candidate_num_sub_1.big_int_multiply(fast_mul_bi_1, temp_exp);
-                    ret_val += this_round_random_bi.big_int_fast_modular_exponentiation(temp_exp, candidate_num, mod_exp_res);
-                    if (mod_exp_res.big_int_unsigned_compare(candidate_num_sub_1_copy) == 0) {
-                        composite_test = false;
-                        break;
-                    }
-                }
-            }
+        std::unique_ptr<big_int_random_source> candidate_rng;
+        if (per_candidate_streams) {
+            candidate_rng = random_source.split(candidate_index);
+        }
+        big_int_random_source &rng = per_candidate_streams ? *candidate_rng : random_source;
 
-            if (composite_test == true) {
-                break;
-            }
+        big_int candidate_num;
+        bool is_probable_prime;
+        ret_val += candidate_num._big_int_generate_random_probable_prime(bits, rng, -1); /* -1 -> Use all prime numbers in the array. */ 
+        if (ret_val != 0) {
+            /* Cancelled while sieving, the candidate is left at zero. */
+            break;
         }
+        ret_val += candidate_num._big_int_rabin_miller_test(reqd_rabin_miller_iterations, rng, is_probable_prime);
 
-        if (i == reqd_rabin_miller_iterations) {
+        if (is_probable_prime == true) {
+            big_int_trace_session::big_int_trace_instant("prime_found", "prime_search", "candidate", static_cast<int64_t>(candidate_index));
             (*this) = candidate_num;
             break;
         }
@@ -1163,104 +1596,408 @@ no_of_threads -> number of threads used to run the function, -ve or 0 thread cou
 */
 int bi::big_int::big_int_get_random_unsigned_prime_rabin_miller_threaded(int bits, int reqd_rabin_miller_iterations, int no_of_threads) {
 
-    std::mutex          final_op_mutex;
-    big_int             final_op;
-    std::atomic<bool>   stop_thread{false};
+    big_int_cancel_token never_cancelled;
+    return big_int_get_random_unsigned_prime_rabin_miller_threaded(bits, reqd_rabin_miller_iterations, no_of_threads, never_cancelled);
+
+}
+
+/*
+cancel_token -> caller owned token, the search returns BI_STATUS_TIMED_OUT if its deadline passes and
+                BI_STATUS_CANCELLED if it is cancelled before a prime is found.
+*/
+int bi::big_int::big_int_get_random_unsigned_prime_rabin_miller_threaded(
+    int bits, 
+    int reqd_rabin_miller_iterations, 
+    int no_of_threads, 
+    const big_int_cancel_token &cancel_token) {
+
+    return big_int_get_random_unsigned_prime_rabin_miller_threaded(bits, reqd_rabin_miller_iterations, no_of_threads, \
+        cancel_token, big_int_system_random_source::instance());
+
+}
+
+/*
+random_source -> non deterministic sources give every thread its own split() stream and the first prime found wins.
+                 Deterministic sources give candidate number k its own split(k) stream, threads claim candidate 
+                 numbers in order and the prime with the lowest candidate number wins, so the result only 
+                 depends on the seed and not on the thread count or scheduling.
+*/
+int bi::big_int::big_int_get_random_unsigned_prime_rabin_miller_threaded(
+    int bits, 
+    int reqd_rabin_miller_iterations, 
+    int no_of_threads, 
+    const big_int_cancel_token &cancel_token, 
+    big_int_random_source &random_source) {
+
+    size_t total_thread_count;
+    if (no_of_threads <= 0) {
+        total_thread_count = std::thread::hardware_concurrency();
+    } else if (static_cast<size_t>(no_of_threads) > std::thread::hardware_concurrency()) {
+        total_thread_count = std::thread::hardware_concurrency();
+    } else {
+        total_thread_count = static_cast<size_t>(no_of_threads);
+    }
+    if (total_thread_count == 0) {
+        total_thread_count = 1;
+    }
+
+    big_int_trace_span trace_span("prime_search_threaded", "prime_search");
+    trace_span.big_int_trace_span_arg("bits", bits);
+    trace_span.big_int_trace_span_arg("threads", static_cast<int64_t>(total_thread_count));
+
+    std::mutex              final_op_mutex;
+    big_int                 final_op;
+    bool                    final_op_found = false;
+    /* Cancelled by the first thread to find a prime, also follows the caller's token. */
+    big_int_cancel_token    stop_thread(&cancel_token);
+
+    /* Deterministic mode: next candidate number to claim, lowest accepted candidate number and 
+       the candidate number each thread is working on (with a token to abort just that thread). */
+    constexpr uint64_t                                  no_candidate = UINT64_MAX;
+    std::atomic<uint64_t>                               next_candidate{0};
+    std::atomic<uint64_t>                               best_candidate{no_candidate};
+    std::unique_ptr<std::atomic<uint64_t> []>           thread_candidate(new std::atomic<uint64_t>[total_thread_count]);
+    std::vector<std::unique_ptr<big_int_cancel_token>>  thread_stop;
+    std::vector<std::unique_ptr<big_int_random_source>> thread_rng;
+
+    for (size_t i = 0; i < total_thread_count; ++i) {
+        thread_candidate[i] = no_candidate;
+        thread_stop.emplace_back(new big_int_cancel_token(&stop_thread));
+        if (random_source.is_deterministic() == false) {
+            thread_rng.push_back(random_source.split(i));
+        }
+    }
 
-    auto rabin_miller_lambda = [&] {
+    auto rabin_miller_lambda = [&] (size_t thread_indx) {
 
         int ret_val = 0;
+        big_int_cancel_scope thread_cancel_scope(stop_thread);
 
-        std::random_device rd;
-        std::mt19937 rng(rd()); 
-        std::uniform_int_distribution<BI_BASE_TYPE> uni_dist(0, 0xFFFFFFFF);
+        big_int_random_source &rng = *thread_rng[thread_indx];
+        big_int_random_source *rngs[BI_MONTGOMERY_LANES];
+        std::fill_n(rngs, BI_MONTGOMERY_LANES, &rng);
         
-        while (ret_val == 0 && !stop_thread) {
-
-            big_int candidate_num, bi_1, bi_2, candidate_num_sub_1, candidate_num_sub_1_copy, prev_candidate_num_sub_1;
-            ret_val += candidate_num._big_int_generate_random_probable_prime(bits, rng, uni_dist, -1); /* -1 -> Use all prime numbers in the array. */ 
-            ret_val += bi_1.big_int_from_base_type(1, false);
-            ret_val += bi_2.big_int_from_base_type(2, false);
-            std::uniform_int_distribution<int> uni_dist_rand_bits(bi_2.big_int_get_num_of_bits(), candidate_num.big_int_get_num_of_bits());
-
-            int max_div_by_two = 0;
-            BI_BASE_TYPE div_2_rem;
-            ret_val += candidate_num.big_int_unsigned_sub(bi_1, candidate_num_sub_1);
-            candidate_num_sub_1_copy = candidate_num_sub_1;
-
-            prev_candidate_num_sub_1 = candidate_num_sub_1;
-            ret_val += candidate_num_sub_1._big_int_fast_divide_by_two(div_2_rem);
-            while (div_2_rem == 0 && !stop_thread) {
-                ++max_div_by_two;
-                prev_candidate_num_sub_1 = candidate_num_sub_1;
-                ret_val += candidate_num_sub_1._big_int_fast_divide_by_two(div_2_rem);
+        while (ret_val == 0 && !stop_thread.is_cancelled()) {
+
+            /* Sieve one multi buffer batch, then test all of it at once. */
+            big_int candidates[BI_MONTGOMERY_LANES];
+            bool is_probable_prime[BI_MONTGOMERY_LANES];
+            for (size_t i = 0; i < BI_MONTGOMERY_LANES && ret_val == 0; ++i) {
+                ret_val += candidates[i]._big_int_generate_random_probable_prime(bits, rng, -1); /* -1 -> Use all prime numbers in the array. */ 
+            }
+            if (ret_val != 0) {
+                /* Cancelled while sieving, the candidate is left at zero. */
+                break;
+            }
+            ret_val += _big_int_rabin_miller_test_multi(candidates, BI_MONTGOMERY_LANES, reqd_rabin_miller_iterations, \
+                rngs, is_probable_prime);
+
+            size_t found = static_cast<size_t>(std::find(is_probable_prime, is_probable_prime + BI_MONTGOMERY_LANES, true) - is_probable_prime);
+            if (found < BI_MONTGOMERY_LANES) {
+                std::unique_lock<std::mutex> op_value_lock(final_op_mutex);
+                final_op = candidates[found];
+                final_op_found = true;
+                op_value_lock.unlock();
+                stop_thread.cancel();
+                big_int_trace_session::big_int_trace_instant("prime_found", "prime_search");
+                break;
+            }
+
+        }
+
+        return ret_val;
+
+    };
+
+    auto rabin_miller_ordered_lambda = [&] (size_t thread_indx) {
+
+        int ret_val = 0;
+        big_int_cancel_token &this_thread_stop = *thread_stop[thread_indx];
+        big_int_cancel_scope thread_cancel_scope(this_thread_stop);
+
+        while (ret_val == 0 && !this_thread_stop.is_cancelled()) {
+
+            /* Claims BI_MONTGOMERY_LANES consecutive candidate numbers, each still drawn from its
+               own sub stream, and tests them as one multi buffer batch. */
+            uint64_t first_index = next_candidate.fetch_add(BI_MONTGOMERY_LANES);
+            thread_candidate[thread_indx] = first_index;
+            if (first_index > best_candidate) {
+                /* A lower numbered candidate was already accepted. */
+                break;
+            }
+
+            std::unique_ptr<big_int_random_source> rng_owner[BI_MONTGOMERY_LANES];
+            big_int_random_source *rngs[BI_MONTGOMERY_LANES];
+            big_int candidates[BI_MONTGOMERY_LANES];
+            bool is_probable_prime[BI_MONTGOMERY_LANES];
+            for (size_t i = 0; i < BI_MONTGOMERY_LANES && ret_val == 0; ++i) {
+                rng_owner[i] = random_source.split(first_index + i);
+                rngs[i] = rng_owner[i].get();
+                ret_val += candidates[i]._big_int_generate_random_probable_prime(bits, *rngs[i], -1); /* -1 -> Use all prime numbers in the array. */ 
             }
+            if (ret_val != 0) {
+                /* Aborted by a lower numbered winner while sieving, the candidate is left at zero. */
+                break;
+            }
+            ret_val += _big_int_rabin_miller_test_multi(candidates, BI_MONTGOMERY_LANES, reqd_rabin_miller_iterations, \
+                rngs, is_probable_prime);
 
-            //std::cout<<"d: "<<max_div_by_two<<" num: "<<prev_candidate_num_sub_1.big_int_to_string(bi_base::BI_HEX)<<"\n";
-            //break;
-            int i = 0;
-            for (; i < reqd_rabin_miller_iterations && !stop_thread; ++i) {
-                big_int this_round_random_bi;
-                ret_val += this_round_random_bi._big_int_get_random_unsigned_between(rng, uni_dist, uni_dist_rand_bits, bi_2, candidate_num);
-
-                big_int mod_exp_res;
-                bool composite_test = true;
-                ret_val += this_round_random_bi.big_int_fast_modular_exponentiation(prev_candidate_num_sub_1, candidate_num, mod_exp_res);
-                if (mod_exp_res.big_int_unsigned_compare(bi_1) == 0) {
-                    composite_test = false;
+            /* The lowest numbered prime of the batch, as a one by one search would accept. */
+            size_t found = static_cast<size_t>(std::find(is_probable_prime, is_probable_prime + BI_MONTGOMERY_LANES, true) - is_probable_prime);
+            if (found < BI_MONTGOMERY_LANES) {
+                uint64_t candidate_index = first_index + found;
+                std::unique_lock<std::mutex> op_value_lock(final_op_mutex);
+                if (candidate_index < best_candidate) {
+                    final_op = candidates[found];
+                    final_op_found = true;
+                    best_candidate = candidate_index;
                 }
-                else {
-                    for (int j = 0; j < max_div_by_two && !stop_thread; ++j) {
-                        big_int temp_exp, fast_mul_bi_1(bi_1);
-                        ret_val += fast_mul_bi_1.big_int_left_shift(j);
-                        ret_val += prev_candidate_num_sub_1.big_int_multiply(fast_mul_bi_1, temp_exp);
-                        ret_val += this_round_random_bi.big_int_fast_modular_exponentiation(temp_exp, candidate_num, mod_exp_res);
-                        if (mod_exp_res.big_int_unsigned_compare(candidate_num_sub_1_copy) == 0) {
-                            composite_test = false;
-                            break;
-                        }
+                op_value_lock.unlock();
+                big_int_trace_session::big_int_trace_instant("prime_found", "prime_search", "candidate", static_cast<int64_t>(candidate_index));
+                /* Abort only the threads working past the accepted candidate, lower numbered 
+                   candidates still have to be finished. */
+                for (size_t i = 0; i < total_thread_count; ++i) {
+                    if (thread_candidate[i] != no_candidate && thread_candidate[i] > candidate_index) {
+                        thread_stop[i]->cancel();
                     }
                 }
+                break;
+            }
 
-                if (composite_test == true) {
-                    break;
-                }
+        }
+
+        thread_candidate[thread_indx] = no_candidate;
+        return ret_val;
+
+    };
+
+    /* What each thread returned or threw, an exception also stops the other threads. */
+    std::vector<int>                    thread_ret_val(total_thread_count, 0);
+    std::vector<std::exception_ptr>     thread_error(total_thread_count);
+    auto thread_main = [&] (size_t thread_indx) {
+        try {
+            thread_ret_val[thread_indx] = random_source.is_deterministic() ? \
+                rabin_miller_ordered_lambda(thread_indx) : rabin_miller_lambda(thread_indx);
+        } catch (...) {
+            thread_error[thread_indx] = std::current_exception();
+            stop_thread.cancel();
+        }
+    };
+
+    std::vector<std::thread> rabin_miller_threads;
+    rabin_miller_threads.reserve(total_thread_count);
+    for(size_t i = 0; i < total_thread_count; ++i) {
+        rabin_miller_threads.emplace_back(thread_main, i);
+    }
+
+    {
+        big_int_trace_span join_span("thread_join", "prime_search");
+        for(auto &t : rabin_miller_threads) {
+            t.join();
+        }
+    }
+
+    if (final_op_found == false) {
+        for (const auto &error : thread_error) {
+            if (error != nullptr) {
+                std::rethrow_exception(error);
             }
+        }
+        if (cancel_token.is_cancelled()) {
+            return cancel_token.has_timed_out() ? BI_STATUS_TIMED_OUT : BI_STATUS_CANCELLED;
+        }
+        /* Every thread gave up without being cancelled. */
+        for (int thread_ret : thread_ret_val) {
+            if (thread_ret != 0) {
+                return thread_ret;
+            }
+        }
+        return -1;
+    }
+
+    (*this) = final_op;
+    return 0;
+
+}
+
+/*
+
+    Pipelined prime search
+    ----------------------
+
+    Splits the search into two stages connected by a bounded lock-free queue:
+
+        producers   ==> generate random candidates and sieve them by trial division
+                        with the small primes list, survivors are pushed to the queue.
+        consumers   ==> pop up to BI_MONTGOMERY_LANES sieved candidates, run a single base 2
+                        strong probable prime test on all of them through the multi buffer
+                        exponentiation (rejects almost every composite) and only then the full
+                        reqd_rabin_miller_iterations random witness rounds.
+
+    All stages exit as soon as one consumer accepts a prime.
+
+no_of_producer_threads, no_of_consumer_threads -> -ve or 0 for either splits std::thread::hardware_concurrency() 
+                                                  between the stages (about one producer per four threads).
+
+*/
+int bi::big_int::big_int_get_random_unsigned_prime_rabin_miller_pipelined(
+    int bits, 
+    int reqd_rabin_miller_iterations, 
+    int no_of_producer_threads, 
+    int no_of_consumer_threads) {
+
+    constexpr size_t    candidate_queue_capacity = 64;
+
+    big_int_trace_span trace_span("prime_search_pipelined", "prime_search");
+    trace_span.big_int_trace_span_arg("bits", bits);
+
+    std::mutex              final_op_mutex;
+    big_int                 final_op;
+    bool                    final_op_found = false;
+    big_int_cancel_token    stop_thread;
+    std::atomic<int>        pipeline_ret_val{0};
+
+    big_int_bounded_queue<big_int>  candidate_queue(candidate_queue_capacity);
+
+    auto producer_lambda = [&] {
+
+        int ret_val = 0;
+        big_int_cancel_scope thread_cancel_scope(stop_thread);
+
+        big_int_chacha20_rng &rng = big_int_chacha20_rng::thread_instance();
 
-            if (i == reqd_rabin_miller_iterations) {
+        while (ret_val == 0 && !stop_thread.is_cancelled()) {
+
+            big_int candidate_num;
+            ret_val += candidate_num._big_int_generate_random_probable_prime(bits, rng, -1); /* -1 -> Use all prime numbers in the array. */ 
+            if (ret_val != 0) {
+                break;
+            }
+
+            /* Back off while the consumers catch up. */
+            while (!stop_thread.is_cancelled() && candidate_queue.try_push(candidate_num) == false) {
+                std::this_thread::yield();
+            }
+
+        }
+
+        /* Failures caused by the stop request itself are not errors. */
+        if (ret_val != 0 && stop_thread.is_cancelled() == false) {
+            pipeline_ret_val += ret_val;
+            stop_thread.cancel();
+        }
+
+    };
+
+    auto consumer_lambda = [&] {
+
+        int ret_val = 0;
+        big_int_cancel_scope thread_cancel_scope(stop_thread);
+
+        big_int_random_source *rngs[BI_MONTGOMERY_LANES];
+        std::fill_n(rngs, BI_MONTGOMERY_LANES, &big_int_chacha20_rng::thread_instance());
+
+        while (ret_val == 0 && !stop_thread.is_cancelled()) {
+
+            /* Take whatever is queued, up to one multi buffer batch. */
+            big_int candidates[BI_MONTGOMERY_LANES];
+            size_t popped = 0;
+            while (popped < BI_MONTGOMERY_LANES && candidate_queue.try_pop(candidates[popped])) {
+                ++popped;
+            }
+            if (popped == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            /* Base 2 filter and random witness rounds on all of them at once. */
+            bool is_probable_prime[BI_MONTGOMERY_LANES];
+            ret_val += _big_int_rabin_miller_test_multi(candidates, popped, reqd_rabin_miller_iterations, rngs, is_probable_prime);
+
+            size_t found = static_cast<size_t>(std::find(is_probable_prime, is_probable_prime + popped, true) - is_probable_prime);
+            if (ret_val == 0 && found < popped) {
                 std::unique_lock<std::mutex> op_value_lock(final_op_mutex);
-                final_op = candidate_num;
+                final_op = candidates[found];
+                final_op_found = true;
                 op_value_lock.unlock();
-                stop_thread = true;
-                break;
+                stop_thread.cancel();
+                big_int_trace_session::big_int_trace_instant("prime_found", "prime_search");
             }
 
         }
 
-        return ret_val;
+        /* Failures caused by the stop request itself are not errors. */
+        if (ret_val != 0 && stop_thread.is_cancelled() == false) {
+            pipeline_ret_val += ret_val;
+            stop_thread.cancel();
+        }
 
     };
 
-    size_t total_thread_count;
-    if (no_of_threads <= 0) {
-        total_thread_count = std::thread::hardware_concurrency();
-    } else if (static_cast<size_t>(no_of_threads) > std::thread::hardware_concurrency()) {
-        total_thread_count = std::thread::hardware_concurrency();
+    size_t max_thread_count = std::thread::hardware_concurrency();
+    if (max_thread_count < 2) {
+        max_thread_count = 2;
+    }
+
+    size_t producer_count, consumer_count;
+    if (no_of_producer_threads <= 0 || no_of_consumer_threads <= 0) {
+        producer_count = std::max<size_t>(1, max_thread_count / 4);
+        consumer_count = max_thread_count - producer_count;
     } else {
-        total_thread_count = static_cast<size_t>(no_of_threads);
+        producer_count = static_cast<size_t>(no_of_producer_threads);
+        consumer_count = static_cast<size_t>(no_of_consumer_threads);
+        if (producer_count + consumer_count > max_thread_count) {
+            /* Keep the requested ratio within the available threads. */
+            producer_count = std::max<size_t>(1, (producer_count * max_thread_count) / (producer_count + consumer_count));
+            consumer_count = max_thread_count - producer_count;
+        }
     }
 
-    std::vector<std::thread> rabin_miller_threads;
-    rabin_miller_threads.reserve(total_thread_count);
-    for(auto i = 0u; i < total_thread_count; ++i) {
-        rabin_miller_threads.emplace_back(rabin_miller_lambda);
+    /* What each thread threw, an exception also stops the other threads. */
+    std::vector<std::exception_ptr> thread_error(producer_count + consumer_count);
+    auto thread_main = [&] (size_t thread_indx, bool is_producer) {
+        try {
+            if (is_producer) {
+                producer_lambda();
+            } else {
+                consumer_lambda();
+            }
+        }
+        catch (...) {
+            thread_error[thread_indx] = std::current_exception();
+            stop_thread.cancel();
+        }
+    };
+
+    std::vector<std::thread> pipeline_threads;
+    pipeline_threads.reserve(producer_count + consumer_count);
+    for (size_t i = 0; i < producer_count; ++i) {
+        pipeline_threads.emplace_back(thread_main, i, true);
+    }
+    for (size_t i = 0; i < consumer_count; ++i) {
+        pipeline_threads.emplace_back(thread_main, producer_count + i, false);
     }
 
-    for(auto &t : rabin_miller_threads) {
-        t.join();
+    {
+        big_int_trace_span join_span("thread_join", "prime_search");
+        for (auto &t : pipeline_threads) {
+            t.join();
+        }
+    }
+
+    if (final_op_found == false) {
+        for (const auto &error : thread_error) {
+            if (error != nullptr) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    if (pipeline_ret_val != 0) {
+        return -1;
     }
 
     (*this) = final_op;
     return 0;
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,100 @@
+/**
+ *  @file   big_int_cancel_token.cc
+ *  @brief  Cancellation token and per thread cancellation scope
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include "big_int.hpp"
+
+namespace {
+    /* Token polled by the big_int operations running on this thread. */
+    thread_local const bi::big_int_cancel_token *active_cancel_token = nullptr;
+}
+
+bi::big_int_cancel_token::big_int_cancel_token()
+:   _cancelled      {false},
+    _timed_out      {false},
+    _has_deadline   {false},
+    _deadline       {},
+    _parent         {nullptr} {
+
+}
+
+bi::big_int_cancel_token::big_int_cancel_token(const bi::big_int_cancel_token *parent)
+:   _cancelled      {false},
+    _timed_out      {false},
+    _has_deadline   {false},
+    _deadline       {},
+    _parent         {parent} {
+
+}
+
+bi::big_int_cancel_token::big_int_cancel_token(std::chrono::steady_clock::time_point deadline, const bi::big_int_cancel_token *parent)
+:   _cancelled      {false},
+    _timed_out      {false},
+    _has_deadline   {true},
+    _deadline       {deadline},
+    _parent         {parent} {
+
+}
+
+void bi::big_int_cancel_token::cancel() {
+
+    _cancelled.store(true, std::memory_order_release);
+
+}
+
+bool bi::big_int_cancel_token::is_cancelled() const {
+
+    if (_cancelled.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    if (_has_deadline && std::chrono::steady_clock::now() >= _deadline) {
+        _timed_out.store(true, std::memory_order_relaxed);
+        _cancelled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    if (_parent != nullptr && _parent->is_cancelled()) {
+        _cancelled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    return false;
+
+}
+
+bool bi::big_int_cancel_token::has_timed_out() const {
+
+    /* Refresh the deadline state first. */
+    is_cancelled();
+
+    if (_timed_out.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return (_parent != nullptr && _parent->has_timed_out());
+
+}
+
+bi::big_int_cancel_scope::big_int_cancel_scope(const bi::big_int_cancel_token &token)
+:   _prev_token     {active_cancel_token} {
+
+    active_cancel_token = &token;
+
+}
+
+bi::big_int_cancel_scope::~big_int_cancel_scope() {
+
+    active_cancel_token = _prev_token;
+
+}
+
+bool bi::big_int_cancel_scope::cancellation_requested() {
+
+    return (active_cancel_token != nullptr && active_cancel_token->is_cancelled());
+
+}
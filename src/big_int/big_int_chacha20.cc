@@ -0,0 +1,292 @@
+/**
+ *  @file   big_int_chacha20.cc
+ *  @brief  ChaCha20 based random number generator
+ *
+ *  ChaCha20 block function as in RFC 8439 with a 64 bit block counter and a
+ *  64 bit stream id in place of the nonce.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/random.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#include "big_int_chacha20.hpp"
+#include "big_int_lib_log.hpp"
+
+static_assert(sizeof(BI_BASE_TYPE) == sizeof(uint32_t), "ChaCha20 generator emits 32 bit words");
+
+namespace {
+
+    /* Bumped in forked children so that they never reuse the parent's keystream. */
+    std::atomic<unsigned> fork_generation{0};
+
+#if defined(__unix__) || defined(__APPLE__)
+    void on_fork_child() {
+        fork_generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const int atfork_registered = pthread_atfork(nullptr, nullptr, on_fork_child);
+#endif
+
+    /* Plain memset on a buffer that dies right after may be dropped by the optimizer. */
+    void wipe_words(uint32_t *words, size_t count) {
+        volatile uint32_t *dst = words;
+        for (size_t i = 0; i < count; ++i) {
+            dst[i] = 0;
+        }
+    }
+
+    inline uint32_t rotl32(uint32_t v, int c) {
+        return (v << c) | (v >> (32 - c));
+    }
+
+    inline void quarter_round(uint32_t *x, int a, int b, int c, int d) {
+        x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 8);
+        x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 7);
+    }
+
+    void chacha20_block(const uint32_t *key, uint64_t counter, uint64_t stream_id, uint32_t *out) {
+
+        uint32_t input[16] = {
+            0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,     /* "expand 32-byte k" */
+            key[0], key[1], key[2], key[3],
+            key[4], key[5], key[6], key[7],
+            static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+            static_cast<uint32_t>(stream_id), static_cast<uint32_t>(stream_id >> 32)
+        };
+
+        uint32_t x[16];
+        memcpy(x, input, sizeof(x));
+        for (int i = 0; i < 10; ++i) {
+            quarter_round(x, 0, 4,  8, 12);
+            quarter_round(x, 1, 5,  9, 13);
+            quarter_round(x, 2, 6, 10, 14);
+            quarter_round(x, 3, 7, 11, 15);
+            quarter_round(x, 0, 5, 10, 15);
+            quarter_round(x, 1, 6, 11, 12);
+            quarter_round(x, 2, 7,  8, 13);
+            quarter_round(x, 3, 4,  9, 14);
+        }
+        for (int i = 0; i < 16; ++i) {
+            out[i] = x[i] + input[i];
+        }
+
+    }
+
+    void get_os_entropy(uint32_t *data, size_t count) {
+
+        unsigned char *dst = reinterpret_cast<unsigned char *>(data);
+        size_t bytes_left = count * sizeof(uint32_t);
+
+#if defined(__linux__)
+        while (bytes_left > 0) {
+            ssize_t got = getrandom(dst, bytes_left, 0);
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            dst += got;
+            bytes_left -= static_cast<size_t>(got);
+        }
+        if (bytes_left == 0) {
+            return;
+        }
+        _BI_LOG(1, "getrandom failed, falling back to std::random_device");
+#endif
+
+        std::random_device rd;
+        while (bytes_left > 0) {
+            uint32_t rd_val = rd();
+            size_t copy_len = bytes_left < sizeof(rd_val) ? bytes_left : sizeof(rd_val);
+            memcpy(dst, &rd_val, copy_len);
+            dst += copy_len;
+            bytes_left -= copy_len;
+        }
+
+    }
+
+}
+
+bi::big_int_chacha20_rng::big_int_chacha20_rng()
+:   _initial_key        {},
+    _deterministic      {false},
+    _stream_id          {0},
+    _counter            {0},
+    _buffer_pos         {BUFFER_WORDS},
+    _fork_generation    {0} {
+
+    _reseed_from_os();
+
+}
+
+bi::big_int_chacha20_rng::big_int_chacha20_rng(const uint32_t (&key)[KEY_WORDS], uint64_t stream_id)
+:   _deterministic      {true},
+    _stream_id          {stream_id},
+    _counter            {0},
+    _buffer_pos         {BUFFER_WORDS},
+    _fork_generation    {fork_generation.load(std::memory_order_relaxed)} {
+
+    memcpy(_key, key, sizeof(_key));
+    memcpy(_initial_key, key, sizeof(_initial_key));
+
+}
+
+void bi::big_int_chacha20_rng::_reseed_from_os() {
+
+    /* The OS seed is not kept, fast key erasure in _refill() leaves nothing to replay the
+       keystream from. */
+    get_os_entropy(_key, KEY_WORDS);
+    _counter = 0;
+    _buffer_pos = BUFFER_WORDS;
+    _fork_generation = fork_generation.load(std::memory_order_relaxed);
+
+}
+
+void bi::big_int_chacha20_rng::_refill() {
+
+    for (size_t i = 0; i < BLOCKS_PER_REFILL; ++i) {
+        chacha20_block(_key, _counter++, _stream_id, _buffer + i * BLOCK_WORDS);
+    }
+
+    /* Fast key erasure, the first words become the next key and are never handed out. */
+    memcpy(_key, _buffer, sizeof(_key));
+    memset(_buffer, 0, sizeof(_key));
+    _buffer_pos = KEY_WORDS;
+
+}
+
+void bi::big_int_chacha20_rng::fill(BI_BASE_TYPE *data, size_t count) {
+
+    while (count > 0) {
+        if (_buffer_pos == BUFFER_WORDS) {
+            _refill();
+        }
+        size_t copy_len = BUFFER_WORDS - _buffer_pos;
+        if (copy_len > count) {
+            copy_len = count;
+        }
+        memcpy(data, _buffer + _buffer_pos, copy_len * sizeof(BI_BASE_TYPE));
+        /* Used keystream is not kept around. */
+        memset(_buffer + _buffer_pos, 0, copy_len * sizeof(BI_BASE_TYPE));
+        _buffer_pos += copy_len;
+        data += copy_len;
+        count -= copy_len;
+    }
+
+}
+
+std::unique_ptr<bi::big_int_random_source> bi::big_int_chacha20_rng::split(uint64_t stream_id) const {
+
+    if (_deterministic == false) {
+        return std::unique_ptr<big_int_random_source>(new big_int_chacha20_rng());
+    }
+
+    /* Sub stream key = first words of the block at the reserved counter value UINT64_MAX, which
+       the regular output (counting up from zero) never reaches. */
+    uint32_t derive_block[BLOCK_WORDS];
+    uint32_t sub_key[KEY_WORDS];
+    chacha20_block(_initial_key, UINT64_MAX, stream_id, derive_block);
+    memcpy(sub_key, derive_block, sizeof(sub_key));
+    std::unique_ptr<big_int_random_source> sub_stream(new big_int_chacha20_rng(sub_key, 0));
+    wipe_words(derive_block, BLOCK_WORDS);
+    wipe_words(sub_key, KEY_WORDS);
+    return sub_stream;
+
+}
+
+bool bi::big_int_chacha20_rng::is_deterministic() const {
+
+    return _deterministic;
+
+}
+
+BI_BASE_TYPE bi::big_int_chacha20_rng::next() {
+
+    BI_BASE_TYPE val;
+    fill(&val, 1);
+    return val;
+
+}
+
+bi::big_int_chacha20_rng &bi::big_int_chacha20_rng::thread_instance() {
+
+    thread_local big_int_chacha20_rng thread_rng;
+    if (thread_rng._fork_generation != fork_generation.load(std::memory_order_relaxed)) {
+        thread_rng._reseed_from_os();
+    }
+    return thread_rng;
+
+}
+
+void bi::big_int_system_random_source::fill(BI_BASE_TYPE *data, size_t count) {
+
+    big_int_chacha20_rng::thread_instance().fill(data, count);
+
+}
+
+std::unique_ptr<bi::big_int_random_source> bi::big_int_system_random_source::split(uint64_t) const {
+
+    /* Every thread already has its own generator. */
+    return std::unique_ptr<big_int_random_source>(new big_int_system_random_source());
+
+}
+
+bool bi::big_int_system_random_source::is_deterministic() const {
+
+    return false;
+
+}
+
+bi::big_int_system_random_source &bi::big_int_system_random_source::instance() {
+
+    static big_int_system_random_source system_source;
+    return system_source;
+
+}
+
+bi::big_int_seeded_drbg::big_int_seeded_drbg(uint64_t seed) {
+
+    const uint32_t seed_key[big_int_chacha20_rng::KEY_WORDS] = {
+        static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), 0, 0, 0, 0, 0, 0
+    };
+    _rng.reset(new big_int_chacha20_rng(seed_key, 0));
+
+}
+
+bi::big_int_seeded_drbg::~big_int_seeded_drbg() = default;
+
+void bi::big_int_seeded_drbg::fill(BI_BASE_TYPE *data, size_t count) {
+
+    _rng->fill(data, count);
+
+}
+
+std::unique_ptr<bi::big_int_random_source> bi::big_int_seeded_drbg::split(uint64_t stream_id) const {
+
+    return _rng->split(stream_id);
+
+}
+
+bool bi::big_int_seeded_drbg::is_deterministic() const {
+
+    return true;
+
+}
@@ -19,9 +19,11 @@
 bi::big_int::big_int() 
 :   _total_data {DEFAULT_MEM_ALLOC_BYTES / sizeof(BI_BASE_TYPE)},  
     _top        {0},
-    _neg        {false} {
+    _neg        {false},
+    _borrowed   {false} {
 
     _data           = new BI_BASE_TYPE[_total_data];
+    _BI_STAT_ADD(BI_STAT_BYTES_ALLOCATED, sizeof(BI_BASE_TYPE) * static_cast<size_t>(_total_data));
 
     if(_data) {
         _data[_top++] = 0; /* Init. with zero. */
@@ -37,9 +39,11 @@ bi::big_int::big_int()
 bi::big_int::big_int(const bi::big_int &src) 
 :   _total_data {src._total_data},  
     _top        {src._top},
-    _neg        {src._neg} {
+    _neg        {src._neg},
+    _borrowed   {false} {
 
     _data           = new BI_BASE_TYPE[_total_data];
+    _BI_STAT_ADD(BI_STAT_BYTES_ALLOCATED, sizeof(BI_BASE_TYPE) * static_cast<size_t>(_total_data));
 
     if(_data) {
         _BI_LOG(1, "Big int init, with: %d items", _total_data);
@@ -68,7 +72,8 @@ bi::big_int::big_int(bi::big_int &&src)
 :   _data       {nullptr},
     _total_data {0},  
     _top        {0},
-    _neg        {false} {
+    _neg        {false},
+    _borrowed   {false} {
 
     _big_int_swap(src);
 
@@ -76,10 +81,68 @@ bi::big_int::big_int(bi::big_int &&src)
 
 }
 
+bi::big_int::big_int(const bi::big_int_view &view, borrow_tag)
+:   _data       {const_cast<BI_BASE_TYPE *>(view.big_int_view_data())},
+    _total_data {view.big_int_view_count()},
+    _top        {view.big_int_view_count()},
+    _neg        {view.big_int_view_is_negetive()},
+    _borrowed   {true} {
+
+    _BI_LOG(3, "Borrowing 'ctor");
+}
+
 bi::big_int::~big_int() {
 
-    delete[]    _data;
+    if (_borrowed == false) {
+        delete[]    _data;
+    }
     _BI_LOG(1, "Freeing: %d, items", _total_data);
 
 }
 
+
+bi::big_int_view::big_int_view(const BI_BASE_TYPE *data, int count, bool is_neg)
+:   _data       {data},
+    _count      {count},
+    _neg        {is_neg} {
+
+    /* Same shape as a big_int: no leading zero limbs, zero is a single zero limb. */
+    static const BI_BASE_TYPE zero_limb = 0;
+    if (count < 0 || (data == nullptr && count > 0)) {
+        throw std::invalid_argument("Invalid big int view");
+    }
+    while (_count > 0 && _data[_count - 1] == 0) {
+        --_count;
+    }
+    if (_count == 0) {
+        _data = &zero_limb;
+        _count = 1;
+        _neg = false;
+    }
+
+}
+
+bi::big_int_view::big_int_view(const bi::big_int &src)
+:   _data       {src._data},
+    _count      {src._top},
+    _neg        {src._neg} {
+
+}
+
+const BI_BASE_TYPE* bi::big_int_view::big_int_view_data() const {
+
+    return _data;
+
+}
+
+int bi::big_int_view::big_int_view_count() const {
+
+    return _count;
+
+}
+
+bool bi::big_int_view::big_int_view_is_negetive() const {
+
+    return _neg;
+
+}
@@ -0,0 +1,147 @@
+/**
+ *  @file   big_int_hex_codec.cc
+ *  @brief  Table driven hex codec
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <string.h>
+
+#include "big_int_hex_codec.hpp"
+#include "big_int_inline_defs.hpp"
+
+namespace {
+
+    struct hex_codec_tables {
+
+        unsigned char   digit_value[256];
+        char            byte_chars[256][2];
+
+        constexpr hex_codec_tables() : digit_value{}, byte_chars{} {
+
+            const char upper_digits[] = "0123456789ABCDEF";
+            for (int i = 0; i < 256; ++i) {
+                digit_value[i] = BI_HEX_INVALID_DIGIT;
+                byte_chars[i][0] = upper_digits[i >> 4];
+                byte_chars[i][1] = upper_digits[i & 0xF];
+            }
+            for (int i = 0; i < 10; ++i) {
+                digit_value['0' + i] = static_cast<unsigned char>(i);
+            }
+            for (int i = 0; i < 6; ++i) {
+                digit_value['A' + i] = static_cast<unsigned char>(10 + i);
+                digit_value['a' + i] = static_cast<unsigned char>(10 + i);
+            }
+
+        }
+
+    };
+
+    constexpr hex_codec_tables codec_tables;
+
+    constexpr uint64_t  SWAR_ONES       = 0x0101010101010101ULL;
+    constexpr uint64_t  SWAR_HIGH_BITS  = 0x8080808080808080ULL;
+
+    /* High bit of every byte set iff the byte is in [lo, hi], all bytes must be below 0x80. */
+    inline uint64_t swar_bytes_in_range(uint64_t x, uint8_t lo, uint8_t hi) {
+
+        uint64_t at_least_lo = x + SWAR_ONES * static_cast<uint64_t>(0x80 - lo);
+        uint64_t above_hi = x + SWAR_ONES * static_cast<uint64_t>(0x7F - hi);
+        return at_least_lo & ~above_hi & SWAR_HIGH_BITS;
+
+    }
+
+    /* 8 characters in one 64 bit word, the first character in the lowest byte. */
+    inline uint64_t swar_load_chars(const char *src) {
+
+        uint64_t x;
+        memcpy(&x, src, sizeof(x));
+#if BI_HOST_BIG_ENDIAN
+#if defined(__GNUC__) || defined(__clang__)
+        x = __builtin_bswap64(x);
+#else
+        x = (static_cast<uint64_t>(byte_swap_bi_base_type(static_cast<BI_BASE_TYPE>(x))) << 32) | \
+            byte_swap_bi_base_type(static_cast<BI_BASE_TYPE>(x >> 32));
+#endif
+#endif
+        return x;
+
+    }
+
+}
+
+unsigned char bi::hex_codec_digit_value(char c) {
+
+    return codec_tables.digit_value[static_cast<unsigned char>(c)];
+
+}
+
+size_t bi::hex_codec_count_digits(const char *first, const char *last) {
+
+    const char *cur = first;
+
+    /* 8 characters at a time while all of them are hex digits. */
+    while (last - cur >= 8) {
+        uint64_t x = swar_load_chars(cur);
+        if ((x & SWAR_HIGH_BITS) != 0) {
+            break;
+        }
+        uint64_t valid = swar_bytes_in_range(x, '0', '9') | swar_bytes_in_range(x | (SWAR_ONES * 0x20), 'a', 'f');
+        if (valid != SWAR_HIGH_BITS) {
+            break;
+        }
+        cur += 8;
+    }
+
+    while (cur != last && hex_codec_digit_value(*cur) != BI_HEX_INVALID_DIGIT) {
+        ++cur;
+    }
+    return static_cast<size_t>(cur - first);
+
+}
+
+BI_BASE_TYPE bi::hex_codec_parse_bi_base_type(const char *src, size_t count) {
+
+    if (count == BI_HEX_CHARS_PER_BASE_TYPE) {
+        /* Digit value of every byte: low nibble, plus 9 for letters (bit 6 set). */
+        uint64_t x = swar_load_chars(src);
+        x = (x & (SWAR_ONES * 0x0F)) + ((x >> 6) & SWAR_ONES) * 9;
+        /* Pair up neighbouring nibbles, the first character is the more significant one. */
+        x = ((x << 4) | (x >> 8)) & 0x00FF00FF00FF00FFULL;
+        return static_cast<BI_BASE_TYPE>(((x & 0xFF) << 24) | (((x >> 16) & 0xFF) << 16) | \
+            (((x >> 32) & 0xFF) << 8) | ((x >> 48) & 0xFF));
+    }
+
+    BI_BASE_TYPE val = 0;
+    for (size_t i = 0; i < count; ++i) {
+        val = (val << 4) | hex_codec_digit_value(src[i]);
+    }
+    return val;
+
+}
+
+void bi::hex_codec_format_bi_base_type(BI_BASE_TYPE val, char *dst) {
+
+    for (int i = 0; i < 4; ++i) {
+        const char *chars = codec_tables.byte_chars[(val >> (24 - 8 * i)) & 0xFF];
+        dst[2 * i] = chars[0];
+        dst[2 * i + 1] = chars[1];
+    }
+
+}
+
+size_t bi::hex_codec_format_bi_base_type_trimmed(BI_BASE_TYPE val, char *dst) {
+
+    char full_chars[BI_HEX_CHARS_PER_BASE_TYPE];
+    hex_codec_format_bi_base_type(val, full_chars);
+
+    size_t skip = 0;
+    while (skip < BI_HEX_CHARS_PER_BASE_TYPE - 1 && full_chars[skip] == '0') {
+        ++skip;
+    }
+    memcpy(dst, full_chars + skip, BI_HEX_CHARS_PER_BASE_TYPE - skip);
+    return BI_HEX_CHARS_PER_BASE_TYPE - skip;
+
+}
@@ -0,0 +1,110 @@
+/**
+ *  @file   big_int_bounded_queue.hpp
+ *  @brief  Bounded lock-free MPMC queue used between the prime search stages
+ *
+ *  Fixed capacity ring of slots, each guarded by a sequence counter
+ *  (Dmitry Vyukov's bounded MPMC queue). Producers and consumers only
+ *  contend on the enqueue/dequeue positions through CAS, no locks are taken.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <stddef.h>
+
+template <typename T>
+class big_int_bounded_queue {
+
+public:
+
+    /* capacity is rounded up to the next power of two. */
+    explicit big_int_bounded_queue(size_t capacity) {
+
+        size_t pow_2_cap = 2;
+        while (pow_2_cap < capacity) {
+            pow_2_cap <<= 1;
+        }
+        _mask = pow_2_cap - 1;
+        _slots.reset(new slot[pow_2_cap]);
+        for (size_t i = 0; i < pow_2_cap; ++i) {
+            _slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+        _enqueue_pos.store(0, std::memory_order_relaxed);
+        _dequeue_pos.store(0, std::memory_order_relaxed);
+
+    }
+
+    big_int_bounded_queue(const big_int_bounded_queue &) = delete;
+    big_int_bounded_queue& operator=(const big_int_bounded_queue &) = delete;
+
+    /* Returns false if the queue is full, data is left untouched in that case. */
+    bool try_push(T &data) {
+
+        slot *cur_slot;
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cur_slot = &_slots[pos & _mask];
+            size_t seq = cur_slot->seq.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cur_slot->data = std::move(data);
+        cur_slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+
+    }
+
+    /* Returns false if the queue is empty. */
+    bool try_pop(T &data) {
+
+        slot *cur_slot;
+        size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cur_slot = &_slots[pos & _mask];
+            size_t seq = cur_slot->seq.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        data = std::move(cur_slot->data);
+        cur_slot->seq.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+
+    }
+
+private:
+
+    struct slot {
+        std::atomic<size_t>     seq;
+        T                       data;
+    };
+
+    /* Keep the producer and consumer positions on separate cache lines. */
+    alignas(64) std::unique_ptr<slot []>    _slots;
+    size_t                                  _mask;
+    alignas(64) std::atomic<size_t>         _enqueue_pos;
+    alignas(64) std::atomic<size_t>         _dequeue_pos;
+
+};
@@ -0,0 +1,64 @@
+/**
+ *  @file   big_int_chacha20.hpp
+ *  @brief  Header for the ChaCha20 based random number generator
+ *
+ *  Buffered ChaCha20 keystream generator used for all the random numbers
+ *  drawn by the big int library (candidates, Miller-Rabin witnesses).
+ *  Uses fast key erasure: every refill overwrites the key with the first
+ *  block words before handing out the rest.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "big_int.hpp"
+
+namespace bi {
+
+    class big_int_chacha20_rng : public big_int_random_source {
+
+        public:
+
+        static constexpr size_t     KEY_WORDS               = 8;
+        static constexpr size_t     BLOCK_WORDS             = 16;
+        static constexpr size_t     BLOCKS_PER_REFILL       = 4;
+        static constexpr size_t     BUFFER_WORDS            = BLOCK_WORDS * BLOCKS_PER_REFILL;
+
+        /* Seeds the key from the operating system entropy source. */
+        big_int_chacha20_rng();
+        /* Deterministic generator, the same key and stream id always give the same output. */
+        big_int_chacha20_rng(const uint32_t (&key)[KEY_WORDS], uint64_t stream_id);
+
+        void                        fill(BI_BASE_TYPE *data, size_t count) override;
+        /* Deterministic generators derive the sub stream key from their initial key, 
+           OS seeded ones return a freshly seeded generator. */
+        std::unique_ptr<big_int_random_source> split(uint64_t stream_id) const override;
+        bool                        is_deterministic() const override;
+        BI_BASE_TYPE                next();
+
+        /* Generator owned by the calling thread, seeded on first use (and again in a forked child). */
+        static big_int_chacha20_rng &thread_instance();
+
+        private:
+
+        uint32_t                    _key[KEY_WORDS];
+        uint32_t                    _initial_key[KEY_WORDS];    /* Seed of split() sub streams, deterministic generators only */
+        bool                        _deterministic;
+        uint64_t                    _stream_id;
+        uint64_t                    _counter;
+        uint32_t                    _buffer[BUFFER_WORDS];
+        size_t                      _buffer_pos;
+        unsigned                    _fork_generation;
+
+        void                        _refill();
+        void                        _reseed_from_os();
+
+    };
+
+}
@@ -0,0 +1,40 @@
+/**
+ *  @file   big_int_hex_codec.hpp
+ *  @brief  Header for the table driven hex codec
+ *
+ *  Conversion between limbs and hex characters without sscanf/sprintf:
+ *  lookup tables for single characters / bytes and a SWAR path that
+ *  validates and converts 8 hex characters (one limb) per step.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "big_int.hpp"
+
+#define         BI_HEX_CHARS_PER_BASE_TYPE                  (2 * sizeof(BI_BASE_TYPE))
+#define         BI_HEX_INVALID_DIGIT                        (0xFF)
+
+namespace bi {
+
+    /* Value 0 - 15 of a hex character, BI_HEX_INVALID_DIGIT otherwise. */
+    unsigned char   hex_codec_digit_value(char c);
+
+    /* Number of leading hex digits in [first, last). */
+    size_t          hex_codec_count_digits(const char *first, const char *last);
+
+    /* Parses count (1 - 8) valid hex digits, most significant first. */
+    BI_BASE_TYPE    hex_codec_parse_bi_base_type(const char *src, size_t count);
+
+    /* Writes exactly 8 upper case hex characters. */
+    void            hex_codec_format_bi_base_type(BI_BASE_TYPE val, char *dst);
+
+    /* Writes val without leading zeroes (at least one digit), returns the number of characters. */
+    size_t          hex_codec_format_bi_base_type_trimmed(BI_BASE_TYPE val, char *dst);
+
+}
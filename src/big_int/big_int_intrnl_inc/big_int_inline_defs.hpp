@@ -9,10 +9,18 @@
  *  @bug            No known bugs.
  */
 
+#include <string.h>
+
 #include "big_int.hpp"
 
 #pragma once
 
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define         BI_HOST_BIG_ENDIAN          (1)
+#else
+#define         BI_HOST_BIG_ENDIAN          (0)
+#endif
+
 static inline int compare_bi_base_type(const BI_BASE_TYPE a, const BI_BASE_TYPE b) {
 
     if(a >= b)
@@ -32,4 +40,31 @@ static inline int compare_bi_base_type_n_top(const BI_BASE_TYPE a, const BI_BASE
         return 0;
     }
 
-}
\ No newline at end of file
+}
+static inline BI_BASE_TYPE byte_swap_bi_base_type(const BI_BASE_TYPE val) {
+
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap32(val);
+#else
+    return ((val & 0xFF) << 24) | ((val & 0xFF00) << 8) | ((val >> 8) & 0xFF00) | (val >> 24);
+#endif
+
+}
+
+/* Unaligned load / store of one limb in the given byte order. */
+static inline BI_BASE_TYPE load_bi_base_type(const uint8_t *src, const bool big_endian) {
+
+    BI_BASE_TYPE val;
+    memcpy(&val, src, sizeof(val));
+    return (big_endian != static_cast<bool>(BI_HOST_BIG_ENDIAN)) ? byte_swap_bi_base_type(val) : val;
+
+}
+
+static inline void store_bi_base_type(uint8_t *dst, BI_BASE_TYPE val, const bool big_endian) {
+
+    if (big_endian != static_cast<bool>(BI_HOST_BIG_ENDIAN)) {
+        val = byte_swap_bi_base_type(val);
+    }
+    memcpy(dst, &val, sizeof(val));
+
+}
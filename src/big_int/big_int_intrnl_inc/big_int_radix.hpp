@@ -0,0 +1,48 @@
+/**
+ *  @file   big_int_radix.hpp
+ *  @brief  Header for the native decimal / binary radix conversion
+ *
+ *  Limb vector arithmetic used by the base conversion: Karatsuba
+ *  multiplication, Knuth algorithm D division and divide and conquer
+ *  conversion against cached powers 10^(9 * 2^k).
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+#include "big_int.hpp"
+
+#define         BI_DEC_DIGITS_PER_BASE_TYPE                 (9)
+#define         BI_DEC_BASE_TYPE_RADIX                      (1000000000)
+
+namespace bi {
+
+    /* Little endian limbs, normalized (no leading zero limbs, zero is empty). */
+    typedef std::vector<BI_BASE_TYPE>                       radix_limbs;
+    /* Receives the output characters in order, possibly in several pieces. */
+    typedef std::function<void(const char *, size_t)>      radix_char_sink;
+
+    void            radix_normalize(radix_limbs &val);
+    void            radix_multiply(const radix_limbs &a, const radix_limbs &b, radix_limbs &res);
+    /* b must be non zero. */
+    void            radix_divmod(const radix_limbs &a, const radix_limbs &b, radix_limbs &quotient, radix_limbs &remainder);
+
+    /* 10^(9 * 2^k), cached for the process lifetime, safe to call from any thread. */
+    const radix_limbs&  radix_dec_power(size_t k);
+    void            radix_pow10(size_t exponent, radix_limbs &res);
+    /* res = high * 10^low_digits + low */
+    void            radix_combine_dec(const radix_limbs &high, const radix_limbs &low, size_t low_digits, radix_limbs &res);
+
+    /* count decimal digits (all '0' - '9') to limbs. */
+    void            radix_dec_to_limbs(const char *digits, size_t count, radix_limbs &res);
+    /* Decimal digits of val without leading zeroes ("0" for zero). */
+    void            radix_limbs_to_dec(const radix_limbs &val, const radix_char_sink &sink);
+
+}
@@ -0,0 +1,612 @@
+/**
+ *  @file   big_int_montgomery.cc
+ *  @brief  Montgomery context for modular exponentiation with odd moduli
+ *
+ *  Word level Montgomery multiplication (CIOS, coarsely integrated operand
+ *  scanning) and fixed window exponentiation on top of it.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "big_int.hpp"
+#include "big_int_lib_log.hpp"
+
+namespace {
+
+    constexpr int       MONT_WINDOW_BITS        = 4;
+    constexpr int       MONT_WINDOW_TABLE_SIZE  = 1 << MONT_WINDOW_BITS;
+
+    /* Returns 1, 0, -1 like big_int_unsigned_compare for two len word numbers. */
+    int limbs_compare(const BI_BASE_TYPE *a, const BI_BASE_TYPE *b, int len) {
+
+        for (int i = len - 1; i >= 0; --i) {
+            if (a[i] != b[i]) {
+                return (a[i] > b[i]) ? 1 : -1;
+            }
+        }
+        return 0;
+
+    }
+
+    /* res = a - b over len words, returns the borrow out. */
+    BI_BASE_TYPE limbs_sub(const BI_BASE_TYPE *a, const BI_BASE_TYPE *b, BI_BASE_TYPE *res, int len) {
+
+        BI_BASE_TYPE borrow = 0;
+        for (int i = 0; i < len; ++i) {
+            BI_DOUBLE_BASE_TYPE diff = static_cast<BI_DOUBLE_BASE_TYPE>(a[i]) - b[i] - borrow;
+            res[i] = static_cast<BI_BASE_TYPE>(diff);
+            borrow = static_cast<BI_BASE_TYPE>((diff >> BI_BASE_TYPE_TOTAL_BITS) & 1);
+        }
+        return borrow;
+
+    }
+
+    bool exponent_bit(const BI_BASE_TYPE *data, int top, int bit) {
+
+        int word = bit / BI_BASE_TYPE_TOTAL_BITS;
+        if (word >= top) {
+            return false;
+        }
+        return ((data[word] >> (bit % BI_BASE_TYPE_TOTAL_BITS)) & 1) != 0;
+
+    }
+
+
+    /*  Lane interleaved CIOS for LANES independent moduli of s words each. Every operand holds
+        word j of lane l at [j * LANES + l], so the innermost loop walks the lanes with no
+        dependency between them: the carry chains overlap and the loop can be vectorized.
+        res = a * b * R ^ -1 mod n per lane, scratch needs (s + 2) * LANES words, res may alias. */
+    template <size_t LANES>
+    void multi_montgomery_multiply(
+        const BI_BASE_TYPE *a,
+        const BI_BASE_TYPE *b,
+        BI_BASE_TYPE *res,
+        const BI_BASE_TYPE *n,
+        const BI_BASE_TYPE *n0_inv,
+        size_t s,
+        BI_BASE_TYPE *scratch) {
+
+        BI_BASE_TYPE *t = scratch;
+        BI_BASE_TYPE carry[LANES], m[LANES];
+        BI_DOUBLE_BASE_TYPE interim_res;
+
+        _BI_STAT_ADD(BI_STAT_LIMB_MULTIPLIES, LANES * (2 * s * s + s));
+        std::fill_n(t, (s + 2) * LANES, 0);
+        for (size_t i = 0; i < s; ++i) {
+            const BI_BASE_TYPE *b_i = b + i * LANES;
+            std::fill_n(carry, LANES, 0);
+            for (size_t j = 0; j < s; ++j) {
+                for (size_t l = 0; l < LANES; ++l) {
+                    interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(a[j * LANES + l]) * b_i[l] + t[j * LANES + l] + carry[l];
+                    t[j * LANES + l] = static_cast<BI_BASE_TYPE>(interim_res);
+                    carry[l] = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+                }
+            }
+            for (size_t l = 0; l < LANES; ++l) {
+                interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(t[s * LANES + l]) + carry[l];
+                t[s * LANES + l] = static_cast<BI_BASE_TYPE>(interim_res);
+                t[(s + 1) * LANES + l] = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+                m[l] = t[l] * n0_inv[l];
+                interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(m[l]) * n[l] + t[l];
+                carry[l] = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+            }
+            for (size_t j = 1; j < s; ++j) {
+                for (size_t l = 0; l < LANES; ++l) {
+                    interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(m[l]) * n[j * LANES + l] + t[j * LANES + l] + carry[l];
+                    t[(j - 1) * LANES + l] = static_cast<BI_BASE_TYPE>(interim_res);
+                    carry[l] = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+                }
+            }
+            for (size_t l = 0; l < LANES; ++l) {
+                interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(t[s * LANES + l]) + carry[l];
+                t[(s - 1) * LANES + l] = static_cast<BI_BASE_TYPE>(interim_res);
+                t[s * LANES + l] = t[(s + 1) * LANES + l] + static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+            }
+        }
+
+        /* Conditional subtraction per lane, t < 2n. */
+        for (size_t l = 0; l < LANES; ++l) {
+            bool subtract = (t[s * LANES + l] != 0);
+            for (size_t j = s; subtract == false && j-- > 0;) {
+                if (t[j * LANES + l] != n[j * LANES + l]) {
+                    subtract = (t[j * LANES + l] > n[j * LANES + l]);
+                    break;
+                }
+                if (j == 0) {
+                    subtract = true;
+                }
+            }
+            BI_BASE_TYPE borrow = 0;
+            for (size_t j = 0; j < s; ++j) {
+                if (subtract) {
+                    BI_DOUBLE_BASE_TYPE diff = static_cast<BI_DOUBLE_BASE_TYPE>(t[j * LANES + l]) - n[j * LANES + l] - borrow;
+                    res[j * LANES + l] = static_cast<BI_BASE_TYPE>(diff);
+                    borrow = static_cast<BI_BASE_TYPE>((diff >> BI_BASE_TYPE_TOTAL_BITS) & 1);
+                } else {
+                    res[j * LANES + l] = t[j * LANES + l];
+                }
+            }
+        }
+
+    }
+
+    /* Interleaves the low s words of src (zero extended) into lane l of dst. */
+    void lane_load(BI_BASE_TYPE *dst, size_t l, const BI_BASE_TYPE *src, size_t src_count, size_t s) {
+
+        for (size_t j = 0; j < s; ++j) {
+            dst[j * BI_MONTGOMERY_LANES + l] = (j < src_count) ? src[j] : 0;
+        }
+
+    }
+
+}
+
+bi::big_int_montgomery_ctx::big_int_montgomery_ctx(const big_int &modulus)
+:   _modulus        {modulus},
+    _r_squared      {},
+    _n0_inv         {0},
+    _limbs          {modulus._top} {
+
+    if (modulus.big_int_is_negetive() || modulus.big_int_is_even() || (modulus._top == 1 && modulus._data[0] == 1)) {
+        throw std::invalid_argument("Montgomery modulus must be odd and greater than one");
+    }
+
+    /* n0 ^ -1 mod 2^32 by Newton iteration, each step doubles the number of correct low bits. */
+    BI_BASE_TYPE n0 = modulus._data[0], inv = 1;
+    for (int i = 0; i < 5; ++i) {
+        inv *= 2 - n0 * inv;
+    }
+    _n0_inv = 0 - inv;
+
+    /* R ^ 2 mod n with R = 2 ^ (32 * limbs), by doubling 1 and reducing after every step
+       so no division (and no cancellation point) is needed. */
+    std::unique_ptr<BI_BASE_TYPE []> acc_mem(new BI_BASE_TYPE[static_cast<size_t>(_limbs) + 1]);
+    BI_BASE_TYPE *acc = acc_mem.get();
+    std::fill_n(acc, _limbs + 1, 0);
+    acc[0] = 1;
+    for (int i = 0; i < 2 * BI_BASE_TYPE_TOTAL_BITS * _limbs; ++i) {
+        BI_BASE_TYPE carry = 0;
+        for (int j = 0; j <= _limbs; ++j) {
+            BI_BASE_TYPE next_carry = acc[j] >> (BI_BASE_TYPE_TOTAL_BITS - 1);
+            acc[j] = (acc[j] << 1) | carry;
+            carry = next_carry;
+        }
+        if (acc[_limbs] != 0 || limbs_compare(acc, _modulus._data, _limbs) >= 0) {
+            acc[_limbs] -= limbs_sub(acc, _modulus._data, acc, _limbs);
+        }
+    }
+
+    if (_r_squared._total_data <= _limbs) {
+        _r_squared._big_int_expand(BI_DEFAULT_EXPAND_COUNT + _limbs);
+    }
+    std::copy_n(acc, _limbs, _r_squared._data);
+    _r_squared._top = _limbs;
+    _r_squared._big_int_remove_preceding_zeroes();
+
+    _BI_LOG(2, "Montgomery context for %d words", _limbs);
+
+}
+
+bi::big_int_montgomery_ctx::big_int_montgomery_ctx(const big_int &modulus, BI_BASE_TYPE n0_inv, const big_int &r_squared)
+:   _modulus        {modulus},
+    _r_squared      {r_squared},
+    _n0_inv         {n0_inv},
+    _limbs          {modulus._top} {
+
+    if (modulus.big_int_is_negetive() || modulus.big_int_is_even() || (modulus._top == 1 && modulus._data[0] == 1)) {
+        throw std::invalid_argument("Montgomery modulus must be odd and greater than one");
+    }
+
+    /* n * n0_inv = -1 mod 2^32 and R^2 mod n < n. */
+    if (modulus._data[0] * n0_inv != BI_BASE_TYPE_MAX || \
+        r_squared.big_int_is_negetive() || r_squared.big_int_unsigned_compare(modulus) >= 0) {
+        throw std::invalid_argument("Montgomery constants do not match the modulus");
+    }
+
+    /* Two Montgomery multiplies by 1 divide by R twice, only the real R^2 mod n comes out as 1. */
+    size_t s = static_cast<size_t>(_limbs);
+    std::unique_ptr<BI_BASE_TYPE []> check_mem(new BI_BASE_TYPE[3 * s + 2]);
+    BI_BASE_TYPE *acc = check_mem.get(), *one = acc + s, *scratch = one + s;
+    std::fill_n(acc, 2 * s, 0);
+    std::copy_n(r_squared._data, r_squared._top, acc);
+    one[0] = 1;
+    _big_int_montgomery_multiply(acc, one, acc, scratch);
+    _big_int_montgomery_multiply(acc, one, acc, scratch);
+    if (acc[0] != 1 || std::any_of(acc + 1, acc + s, [](BI_BASE_TYPE limb) { return limb != 0; })) {
+        throw std::invalid_argument("Montgomery constants do not match the modulus");
+    }
+
+}
+
+const bi::big_int& bi::big_int_montgomery_ctx::big_int_montgomery_get_modulus() const {
+
+    return _modulus;
+
+}
+
+BI_BASE_TYPE bi::big_int_montgomery_ctx::big_int_montgomery_get_n0_inv() const {
+
+    return _n0_inv;
+
+}
+
+const bi::big_int& bi::big_int_montgomery_ctx::big_int_montgomery_get_r_squared() const {
+
+    return _r_squared;
+
+}
+
+/* res = a * b * R ^ -1 mod n, scratch needs limbs + 2 words. res may alias a or b. */
+void bi::big_int_montgomery_ctx::_big_int_montgomery_multiply(
+    const BI_BASE_TYPE *a,
+    const BI_BASE_TYPE *b,
+    BI_BASE_TYPE *res,
+    BI_BASE_TYPE *scratch) const {
+
+    const BI_BASE_TYPE *n = _modulus._data;
+    BI_BASE_TYPE *t = scratch;
+    int s = _limbs;
+    BI_DOUBLE_BASE_TYPE interim_res;
+    BI_BASE_TYPE carry;
+
+    _BI_STAT_ADD(BI_STAT_LIMB_MULTIPLIES, static_cast<uint64_t>(2 * s * s + s));
+    std::fill_n(t, s + 2, 0);
+    for (int i = 0; i < s; ++i) {
+        /* t += a * b[i] */
+        carry = 0;
+        for (int j = 0; j < s; ++j) {
+            interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(a[j]) * b[i] + t[j] + carry;
+            t[j] = static_cast<BI_BASE_TYPE>(interim_res);
+            carry = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+        }
+        interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(t[s]) + carry;
+        t[s] = static_cast<BI_BASE_TYPE>(interim_res);
+        t[s + 1] = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+
+        /* t = (t + m * n) / 2 ^ 32, m chosen so the lowest word becomes zero. */
+        BI_BASE_TYPE m = t[0] * _n0_inv;
+        interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(m) * n[0] + t[0];
+        carry = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+        for (int j = 1; j < s; ++j) {
+            interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(m) * n[j] + t[j] + carry;
+            t[j - 1] = static_cast<BI_BASE_TYPE>(interim_res);
+            carry = static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+        }
+        interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(t[s]) + carry;
+        t[s - 1] = static_cast<BI_BASE_TYPE>(interim_res);
+        t[s] = t[s + 1] + static_cast<BI_BASE_TYPE>(interim_res >> BI_BASE_TYPE_TOTAL_BITS);
+    }
+
+    /* t < 2n here, one conditional subtraction brings it below n. */
+    if (t[s] != 0 || limbs_compare(t, n, s) >= 0) {
+        limbs_sub(t, n, res, s);
+    } else {
+        std::copy_n(t, s, res);
+    }
+
+}
+
+int bi::big_int_montgomery_ctx::big_int_montgomery_modular_multiply(const big_int &a, const big_int &b, big_int &result) const {
+
+    if (a.big_int_is_negetive() || b.big_int_is_negetive() || \
+        a.big_int_unsigned_compare(_modulus) >= 0 || b.big_int_unsigned_compare(_modulus) >= 0) {
+        return -1;
+    }
+
+    size_t s = static_cast<size_t>(_limbs);
+    thread_local std::vector<BI_BASE_TYPE> work_mem;
+    if (work_mem.size() < 4 * s + 2) {
+        work_mem.resize(4 * s + 2);
+    }
+    BI_BASE_TYPE *op_a = work_mem.data(), *op_b = op_a + s, *r_squared = op_b + s, *scratch = r_squared + s;
+    std::fill_n(op_a, 3 * s, 0);
+    std::copy_n(a._data, a._top, op_a);
+    std::copy_n(b._data, b._top, op_b);
+    std::copy_n(_r_squared._data, _r_squared._top, r_squared);
+
+    /* (a * b * R^-1) * R^2 * R^-1 = a * b */
+    _big_int_montgomery_multiply(op_a, op_b, op_a, scratch);
+    _big_int_montgomery_multiply(op_a, r_squared, op_a, scratch);
+
+    result.big_int_clear();
+    if (result._total_data <= _limbs) {
+        result._big_int_expand(BI_DEFAULT_EXPAND_COUNT + _limbs);
+    }
+    std::copy_n(op_a, s, result._data);
+    result._top = _limbs;
+    result._neg = false;
+    return result._big_int_remove_preceding_zeroes();
+
+}
+
+/* Word sized exponents, above all the public exponent 65537, skip the window table: left to
+   right square and multiply from the top set bit, so 65537 takes 16 squarings and one multiply
+   besides the conversions in and out of Montgomery form. */
+int bi::big_int_montgomery_ctx::_big_int_montgomery_word_exponentiation(
+    const big_int &reduced_base, 
+    BI_BASE_TYPE exponent, 
+    big_int &result) const {
+
+    size_t s = static_cast<size_t>(_limbs);
+    thread_local std::vector<BI_BASE_TYPE> work_mem;
+    if (work_mem.size() < 4 * s + 2) {
+        work_mem.resize(4 * s + 2);
+    }
+    BI_BASE_TYPE *base_m = work_mem.data(), *acc = base_m + s, *operand = acc + s, *scratch = operand + s;
+
+    /* base_m = base * R^2 * R^-1 = base * R mod n */
+    std::fill_n(operand, s, 0);
+    std::copy_n(reduced_base._data, reduced_base._top, operand);
+    std::fill_n(acc, s, 0);
+    std::copy_n(_r_squared._data, _r_squared._top, acc);
+    _big_int_montgomery_multiply(operand, acc, base_m, scratch);
+
+    int top_bit = BI_BASE_TYPE_TOTAL_BITS - 1;
+    while (((exponent >> top_bit) & 1) == 0) {
+        --top_bit;
+    }
+    std::copy_n(base_m, s, acc);
+    for (int b = top_bit - 1; b >= 0; --b) {
+        _big_int_montgomery_multiply(acc, acc, acc, scratch);
+        if (((exponent >> b) & 1) != 0) {
+            _big_int_montgomery_multiply(acc, base_m, acc, scratch);
+        }
+    }
+
+    /* Back from Montgomery form, acc * 1 * R ^ -1. */
+    std::fill_n(operand, s, 0);
+    operand[0] = 1;
+    _big_int_montgomery_multiply(acc, operand, acc, scratch);
+
+    result.big_int_clear();
+    if (result._total_data <= _limbs) {
+        result._big_int_expand(BI_DEFAULT_EXPAND_COUNT + _limbs);
+    }
+    std::copy_n(acc, s, result._data);
+    result._top = _limbs;
+    result._neg = false;
+    return result._big_int_remove_preceding_zeroes();
+
+}
+
+int bi::big_int_montgomery_ctx::big_int_montgomery_modular_exponentiation(
+    const big_int &base,
+    const big_int &exponent,
+    big_int &result) const {
+
+    if (exponent.big_int_is_negetive() == true) {
+        return -1;
+    }
+
+    _BI_STAT_ADD(BI_STAT_MODULAR_EXPONENTIATIONS, 1);
+    int ret_val = 0;
+    /* Only a base out of range is copied, the limbs of a reduced one are read in place. */
+    std::unique_ptr<big_int> base_mod_n;
+    const big_int *reduced_base = &base;
+    if (base.big_int_is_negetive() == true || base.big_int_unsigned_compare(_modulus) >= 0) {
+        base_mod_n.reset(new big_int);
+        ret_val += base.big_int_modulus(_modulus, *base_mod_n);
+        if (ret_val != 0) {
+            return ret_val;
+        }
+        reduced_base = base_mod_n.get();
+    }
+
+    if (exponent._top == 1 && exponent._data[0] != 0) {
+        return ret_val + _big_int_montgomery_word_exponentiation(*reduced_base, exponent._data[0], result);
+    }
+
+    /* Window table, accumulator, the two conversion operands and scratch in one per thread
+       buffer that is kept between calls, so back to back exponentiations do not allocate. */
+    size_t s = static_cast<size_t>(_limbs);
+    thread_local std::vector<BI_BASE_TYPE> work_mem;
+    if (work_mem.size() < (MONT_WINDOW_TABLE_SIZE + 3) * s + s + 2) {
+        work_mem.resize((MONT_WINDOW_TABLE_SIZE + 3) * s + s + 2);
+    }
+    BI_BASE_TYPE *table = work_mem.data();
+    BI_BASE_TYPE *acc = table + MONT_WINDOW_TABLE_SIZE * s;
+    BI_BASE_TYPE *operand = acc + s;
+    BI_BASE_TYPE *r_squared = operand + s;
+    BI_BASE_TYPE *scratch = r_squared + s;
+
+    std::fill_n(r_squared, s, 0);
+    std::copy_n(_r_squared._data, _r_squared._top, r_squared);
+
+    /* table[0] = R mod n (one in Montgomery form), table[k] = base ^ k * R mod n. */
+    std::fill_n(operand, s, 0);
+    operand[0] = 1;
+    _big_int_montgomery_multiply(operand, r_squared, table, scratch);
+    std::fill_n(operand, s, 0);
+    std::copy_n(reduced_base->_data, reduced_base->_top, operand);
+    _big_int_montgomery_multiply(operand, r_squared, table + s, scratch);
+    for (int k = 2; k < MONT_WINDOW_TABLE_SIZE; ++k) {
+        _big_int_montgomery_multiply(table + static_cast<size_t>(k - 1) * s, table + s, table + static_cast<size_t>(k) * s, scratch);
+    }
+
+    /* Left to right fixed window exponentiation. */
+    std::copy_n(table, s, acc);
+    int total_bits = exponent.big_int_get_num_of_bits();
+    int windows = (total_bits + MONT_WINDOW_BITS - 1) / MONT_WINDOW_BITS;
+    bool acc_is_one = true;
+    for (int w = windows - 1; w >= 0; --w) {
+        if (big_int_cancel_scope::cancellation_requested()) {
+            return -1;
+        }
+        int window_val = 0;
+        for (int b = MONT_WINDOW_BITS - 1; b >= 0; --b) {
+            window_val = (window_val << 1) | \
+                static_cast<int>(exponent_bit(exponent._data, exponent._top, w * MONT_WINDOW_BITS + b));
+        }
+        if (acc_is_one == false) {
+            for (int b = 0; b < MONT_WINDOW_BITS; ++b) {
+                _big_int_montgomery_multiply(acc, acc, acc, scratch);
+            }
+        }
+        if (window_val != 0) {
+            _big_int_montgomery_multiply(acc, table + static_cast<size_t>(window_val) * s, acc, scratch);
+            acc_is_one = false;
+        }
+    }
+
+    /* Back from Montgomery form, acc * 1 * R ^ -1. */
+    std::fill_n(operand, s, 0);
+    operand[0] = 1;
+    _big_int_montgomery_multiply(acc, operand, acc, scratch);
+
+    result.big_int_clear();
+    if (result._total_data <= _limbs) {
+        result._big_int_expand(BI_DEFAULT_EXPAND_COUNT + _limbs);
+    }
+    std::copy_n(acc, s, result._data);
+    result._top = _limbs;
+    result._neg = false;
+    ret_val += result._big_int_remove_preceding_zeroes();
+
+    return ret_val;
+
+}
+
+/*
+
+    Multi buffer exponentiation
+    ---------------------------
+
+    Groups of BI_MONTGOMERY_LANES jobs with equally long moduli share one left to right
+    fixed window schedule over the longest exponent. Every window squares all lanes
+    MONT_WINDOW_BITS times and multiplies each lane by its own table entry, entry 0
+    being one in Montgomery form, so lanes with shorter exponents just multiply by one.
+    Unused lanes of the last group repeat the group's first job and are discarded.
+
+*/
+int bi::big_int_montgomery_ctx::big_int_montgomery_multi_modular_exponentiation(
+    const big_int_montgomery_ctx *const *ctxs,
+    const big_int *bases,
+    const big_int *exponents,
+    big_int *results,
+    size_t count) {
+
+    constexpr size_t L = BI_MONTGOMERY_LANES;
+    int ret_val = 0;
+
+    std::vector<bool> done(count, false);
+    for (size_t first = 0; first < count; ++first) {
+        if (done[first]) {
+            continue;
+        }
+
+        /* Collect up to L pending jobs with the same modulus length. */
+        size_t lanes[L], used = 0;
+        int limbs = ctxs[first]->_limbs;
+        for (size_t i = first; i < count && used < L; ++i) {
+            if (done[i] == false && ctxs[i]->_limbs == limbs) {
+                if (exponents[i].big_int_is_negetive()) {
+                    return -1;
+                }
+                lanes[used++] = i;
+                done[i] = true;
+            }
+        }
+        if (used == 1) {
+            ret_val += ctxs[first]->big_int_montgomery_modular_exponentiation(bases[first], exponents[first], results[first]);
+            continue;
+        }
+        for (size_t l = used; l < L; ++l) {
+            lanes[l] = lanes[0];
+        }
+        _BI_STAT_ADD(BI_STAT_MODULAR_EXPONENTIATIONS, used);
+
+        size_t s = static_cast<size_t>(limbs);
+        std::vector<BI_BASE_TYPE> work_mem((MONT_WINDOW_TABLE_SIZE + 5) * s * L + (s + 2) * L);
+        BI_BASE_TYPE *table = work_mem.data();
+        BI_BASE_TYPE *acc = table + MONT_WINDOW_TABLE_SIZE * s * L;
+        BI_BASE_TYPE *operand = acc + s * L;
+        BI_BASE_TYPE *r_squared = operand + s * L;
+        BI_BASE_TYPE *n = r_squared + s * L;
+        BI_BASE_TYPE *one = n + s * L;
+        BI_BASE_TYPE *scratch = one + s * L;
+        BI_BASE_TYPE n0_inv[L];
+
+        int max_bits = 0;
+        for (size_t l = 0; l < L; ++l) {
+            const big_int_montgomery_ctx &ctx = *ctxs[lanes[l]];
+            big_int reduced_base;
+            const big_int &base = bases[lanes[l]];
+            if (base.big_int_is_negetive() == true || base.big_int_unsigned_compare(ctx._modulus) >= 0) {
+                big_int temp_base(base);
+                ret_val += temp_base.big_int_modulus(ctx._modulus, reduced_base);
+            } else {
+                reduced_base = base;
+            }
+            lane_load(n, l, ctx._modulus._data, static_cast<size_t>(ctx._modulus._top), s);
+            lane_load(r_squared, l, ctx._r_squared._data, static_cast<size_t>(ctx._r_squared._top), s);
+            lane_load(operand, l, reduced_base._data, static_cast<size_t>(reduced_base._top), s);
+            BI_BASE_TYPE one_word = 1;
+            lane_load(one, l, &one_word, 1, s);
+            n0_inv[l] = ctx._n0_inv;
+            max_bits = std::max(max_bits, exponents[lanes[l]].big_int_get_num_of_bits());
+        }
+        if (ret_val != 0) {
+            return ret_val;
+        }
+
+        /* table[0] = R mod n, table[k] = base ^ k * R mod n, all lanes at once. */
+        multi_montgomery_multiply<L>(operand, r_squared, table + s * L, n, n0_inv, s, scratch);
+        multi_montgomery_multiply<L>(one, r_squared, table, n, n0_inv, s, scratch);
+        for (size_t k = 2; k < MONT_WINDOW_TABLE_SIZE; ++k) {
+            multi_montgomery_multiply<L>(table + (k - 1) * s * L, table + s * L, table + k * s * L, n, n0_inv, s, scratch);
+        }
+
+        std::copy_n(table, s * L, acc);
+        int windows = (max_bits + MONT_WINDOW_BITS - 1) / MONT_WINDOW_BITS;
+        for (int w = windows - 1; w >= 0; --w) {
+            if (big_int_cancel_scope::cancellation_requested()) {
+                return -1;
+            }
+            if (w != windows - 1) {
+                for (int b = 0; b < MONT_WINDOW_BITS; ++b) {
+                    multi_montgomery_multiply<L>(acc, acc, acc, n, n0_inv, s, scratch);
+                }
+            }
+            for (size_t l = 0; l < L; ++l) {
+                const big_int &exponent = exponents[lanes[l]];
+                size_t window_val = 0;
+                for (int b = MONT_WINDOW_BITS - 1; b >= 0; --b) {
+                    window_val = (window_val << 1) | \
+                        static_cast<size_t>(exponent_bit(exponent._data, exponent._top, w * MONT_WINDOW_BITS + b));
+                }
+                const BI_BASE_TYPE *entry = table + window_val * s * L;
+                for (size_t j = 0; j < s; ++j) {
+                    operand[j * L + l] = entry[j * L + l];
+                }
+            }
+            multi_montgomery_multiply<L>(acc, operand, acc, n, n0_inv, s, scratch);
+        }
+
+        /* Back from Montgomery form. */
+        multi_montgomery_multiply<L>(acc, one, acc, n, n0_inv, s, scratch);
+
+        for (size_t l = 0; l < used; ++l) {
+            big_int &result = results[lanes[l]];
+            result.big_int_clear();
+            if (result._total_data <= limbs) {
+                result._big_int_expand(BI_DEFAULT_EXPAND_COUNT + limbs);
+            }
+            for (size_t j = 0; j < s; ++j) {
+                result._data[j] = acc[j * L + l];
+            }
+            result._top = limbs;
+            result._neg = false;
+            ret_val += result._big_int_remove_preceding_zeroes();
+        }
+    }
+
+    return ret_val;
+
+}
@@ -0,0 +1,300 @@
+/**
+ *  @file   big_int_montgomery_cache.cc
+ *  @brief  Process wide cache of Montgomery contexts with lock free lookups
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+#include "big_int.hpp"
+
+/*
+
+    Epoch based reclamation
+    -----------------------
+
+    Readers never take the writer mutex. A lookup stores the global epoch in its thread's
+    reader slot, loads the published table, copies the shared_ptr of the matching entry and
+    clears the slot again. A writer swaps in a new table, then bumps the epoch and tags the
+    replaced table (and any evicted entry) with the epoch before the bump, R. A reader that
+    still can see a retired object stored an epoch <= R, readers storing a later one loaded
+    the new table, so the object is freed once every reader slot is either idle or > R.
+
+*/
+
+namespace {
+
+    struct cache_entry {
+        uint64_t                                                hash;
+        std::shared_ptr<const bi::big_int_montgomery_ctx>       ctx;
+        /* Insert tick of the last hit, written only when it changes so hot entries are not
+           written by every lookup. */
+        mutable std::atomic<uint64_t>                           last_used;
+    };
+
+    /* Immutable once published, sorted by hash. */
+    struct cache_table {
+        std::vector<const cache_entry *>    entries;
+    };
+
+    struct reader_slot {
+        std::atomic<uint64_t>               epoch;          /* 0 while the thread is not in a lookup */
+        std::atomic<bool>                   in_use;
+        reader_slot                         *next;
+    };
+
+    struct retired_object {
+        uint64_t                            epoch;
+        const cache_table                   *table;
+        const cache_entry                   *entry;
+    };
+
+    struct cache_state {
+        std::atomic<const cache_table *>    table;
+        std::atomic<uint64_t>               epoch;
+        std::atomic<uint64_t>               tick;
+        std::atomic<reader_slot *>          readers;
+        std::atomic<size_t>                 capacity;
+
+        /* Writers only. */
+        std::mutex                          writer_mutex;
+        std::vector<retired_object>         retired;
+    };
+
+    /* Never destroyed, threads may still look up contexts while the statics are torn down. */
+    cache_state& cache() {
+
+        static cache_state *state = [] {
+            cache_state *new_state = new cache_state();
+            new_state->table.store(new cache_table(), std::memory_order_relaxed);
+            new_state->epoch.store(1, std::memory_order_relaxed);
+            new_state->tick.store(0, std::memory_order_relaxed);
+            new_state->readers.store(nullptr, std::memory_order_relaxed);
+            new_state->capacity.store(bi::big_int_montgomery_cache::BI_MONTGOMERY_CACHE_DEFAULT_CAPACITY, \
+                std::memory_order_relaxed);
+            return new_state;
+        }();
+        return *state;
+
+    }
+
+    thread_local reader_slot *thread_reader = nullptr;
+
+    struct reader_slot_release {
+        ~reader_slot_release() {
+            thread_reader->in_use.store(false, std::memory_order_release);
+            thread_reader = nullptr;
+        }
+    };
+
+    /* Slots are reused by later threads and never freed, so writers can walk the list at any time. */
+    reader_slot& acquire_reader_slot() {
+
+        if (thread_reader != nullptr) {
+            return *thread_reader;
+        }
+
+        cache_state &state = cache();
+        reader_slot *slot = nullptr;
+        for (reader_slot *free_slot = state.readers.load(std::memory_order_acquire); free_slot != nullptr; \
+            free_slot = free_slot->next) {
+            bool expected = false;
+            if (free_slot->in_use.load(std::memory_order_relaxed) == false && \
+                free_slot->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                slot = free_slot;
+                break;
+            }
+        }
+        if (slot == nullptr) {
+            slot = new reader_slot();
+            slot->epoch.store(0, std::memory_order_relaxed);
+            slot->in_use.store(true, std::memory_order_relaxed);
+            slot->next = state.readers.load(std::memory_order_relaxed);
+            while (state.readers.compare_exchange_weak(slot->next, slot, std::memory_order_release, \
+                std::memory_order_relaxed) == false) {
+            }
+        }
+        thread_reader = slot;
+
+        /* Hands the slot back when the thread exits. */
+        thread_local reader_slot_release release;
+        (void)release;
+        return *slot;
+
+    }
+
+    const cache_entry* table_find(const cache_table &table, uint64_t hash, const bi::big_int &modulus) {
+
+        auto it = std::lower_bound(table.entries.begin(), table.entries.end(), hash, \
+            [](const cache_entry *entry, uint64_t key) { return entry->hash < key; });
+        for (; it != table.entries.end() && (*it)->hash == hash; ++it) {
+            if ((*it)->ctx->big_int_montgomery_get_modulus().big_int_compare(modulus) == 0) {
+                return *it;
+            }
+        }
+        return nullptr;
+
+    }
+
+    /* Caller holds writer_mutex. Publishes new_table and retires the one it replaces. */
+    void publish_table(cache_state &state, const cache_table *new_table) {
+
+        const cache_table *old_table = state.table.exchange(new_table, std::memory_order_seq_cst);
+        uint64_t retire_epoch = state.epoch.fetch_add(1, std::memory_order_seq_cst);
+        state.retired.push_back(retired_object{retire_epoch, old_table, nullptr});
+
+    }
+
+    /* Caller holds writer_mutex. */
+    void retire_entry(cache_state &state, const cache_entry *entry) {
+
+        state.retired.push_back(retired_object{state.epoch.load(std::memory_order_relaxed), nullptr, entry});
+
+    }
+
+    /* Caller holds writer_mutex. Frees everything no running lookup can still see. */
+    void reclaim(cache_state &state) {
+
+        uint64_t oldest_reader = std::numeric_limits<uint64_t>::max();
+        for (reader_slot *slot = state.readers.load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+            uint64_t reader_epoch = slot->epoch.load(std::memory_order_seq_cst);
+            if (reader_epoch != 0) {
+                oldest_reader = std::min(oldest_reader, reader_epoch);
+            }
+        }
+
+        auto still_visible = std::partition(state.retired.begin(), state.retired.end(), \
+            [oldest_reader](const retired_object &object) { return object.epoch >= oldest_reader; });
+        for (auto it = still_visible; it != state.retired.end(); ++it) {
+            delete it->table;
+            delete it->entry;
+        }
+        state.retired.erase(still_visible, state.retired.end());
+
+    }
+
+    /* Caller holds writer_mutex. Drops least recently used entries until at most max_entries are left. */
+    void evict_to(cache_state &state, cache_table &table, size_t max_entries) {
+
+        while (table.entries.size() > max_entries) {
+            auto victim = std::min_element(table.entries.begin(), table.entries.end(), \
+                [](const cache_entry *a, const cache_entry *b) {
+                    return a->last_used.load(std::memory_order_relaxed) < b->last_used.load(std::memory_order_relaxed);
+                });
+            retire_entry(state, *victim);
+            table.entries.erase(victim);
+        }
+
+    }
+
+}
+
+uint64_t bi::big_int_montgomery_cache::_big_int_montgomery_cache_hash(const big_int &modulus) {
+
+    /* FNV-1a over the limbs. */
+    uint64_t hash = 0xCBF29CE484222325;
+    for (int i = 0; i < modulus._top; ++i) {
+        hash = (hash ^ modulus._data[i]) * 0x100000001B3;
+    }
+    return hash;
+
+}
+
+std::shared_ptr<const bi::big_int_montgomery_ctx> bi::big_int_montgomery_cache::big_int_montgomery_cache_get(const big_int &modulus) {
+
+    cache_state &state = cache();
+    uint64_t hash = _big_int_montgomery_cache_hash(modulus);
+
+    if (state.capacity.load(std::memory_order_relaxed) != 0) {
+        reader_slot &slot = acquire_reader_slot();
+        std::shared_ptr<const big_int_montgomery_ctx> found;
+        slot.epoch.store(state.epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+        const cache_entry *entry = table_find(*state.table.load(std::memory_order_seq_cst), hash, modulus);
+        if (entry != nullptr) {
+            uint64_t now = state.tick.load(std::memory_order_relaxed);
+            if (entry->last_used.load(std::memory_order_relaxed) != now) {
+                entry->last_used.store(now, std::memory_order_relaxed);
+            }
+            found = entry->ctx;
+        }
+        slot.epoch.store(0, std::memory_order_release);
+
+        if (found != nullptr) {
+            _BI_STAT_ADD(BI_STAT_MONTGOMERY_CACHE_HITS, 1);
+            return found;
+        }
+    }
+
+    /* Built outside the lock, racing threads may build the same context, the first one inserted wins. */
+    _BI_STAT_ADD(BI_STAT_MONTGOMERY_CACHE_MISSES, 1);
+    std::shared_ptr<const big_int_montgomery_ctx> new_ctx = std::make_shared<const big_int_montgomery_ctx>(modulus);
+
+    std::lock_guard<std::mutex> writer_lock(state.writer_mutex);
+    size_t capacity = state.capacity.load(std::memory_order_relaxed);
+    if (capacity == 0) {
+        return new_ctx;
+    }
+    const cache_table *old_table = state.table.load(std::memory_order_relaxed);
+    const cache_entry *existing = table_find(*old_table, hash, modulus);
+    if (existing != nullptr) {
+        return existing->ctx;
+    }
+
+    cache_entry *new_entry = new cache_entry{hash, new_ctx, {state.tick.fetch_add(1, std::memory_order_relaxed) + 1}};
+    std::unique_ptr<cache_table> new_table(new cache_table(*old_table));
+    evict_to(state, *new_table, capacity - 1);
+    new_table->entries.insert(std::upper_bound(new_table->entries.begin(), new_table->entries.end(), hash, \
+        [](uint64_t key, const cache_entry *entry) { return key < entry->hash; }), new_entry);
+    publish_table(state, new_table.release());
+    reclaim(state);
+    return new_ctx;
+
+}
+
+void bi::big_int_montgomery_cache::big_int_montgomery_cache_set_capacity(size_t max_entries) {
+
+    cache_state &state = cache();
+    std::lock_guard<std::mutex> writer_lock(state.writer_mutex);
+    state.capacity.store(max_entries, std::memory_order_relaxed);
+
+    const cache_table *old_table = state.table.load(std::memory_order_relaxed);
+    if (old_table->entries.size() > max_entries) {
+        std::unique_ptr<cache_table> new_table(new cache_table(*old_table));
+        evict_to(state, *new_table, max_entries);
+        publish_table(state, new_table.release());
+    }
+    reclaim(state);
+
+}
+
+size_t bi::big_int_montgomery_cache::big_int_montgomery_cache_capacity() {
+
+    return cache().capacity.load(std::memory_order_relaxed);
+
+}
+
+size_t bi::big_int_montgomery_cache::big_int_montgomery_cache_size() {
+
+    cache_state &state = cache();
+    std::lock_guard<std::mutex> writer_lock(state.writer_mutex);
+    return state.table.load(std::memory_order_relaxed)->entries.size();
+
+}
+
+void bi::big_int_montgomery_cache::big_int_montgomery_cache_clear() {
+
+    cache_state &state = cache();
+    std::lock_guard<std::mutex> writer_lock(state.writer_mutex);
+    std::unique_ptr<cache_table> new_table(new cache_table());
+    for (const cache_entry *entry : state.table.load(std::memory_order_relaxed)->entries) {
+        retire_entry(state, entry);
+    }
+    publish_table(state, new_table.release());
+    reclaim(state);
+
+}
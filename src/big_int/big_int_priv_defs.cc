@@ -10,10 +10,14 @@
 #include <algorithm>
 #include <stdexcept>
 #include <memory>
+#include <string.h>
+#include <cstdio>
+#include <vector>
 
 #include "big_int.hpp"
 #include "big_int_lib_log.hpp"
 #include "big_int_inline_defs.hpp"
+#include "big_int_chacha20.hpp"
 
 namespace {
     const BI_BASE_TYPE first_primes_list[] = {   
@@ -42,12 +46,31 @@ void bi::big_int::_big_int_swap(bi::big_int &src) {
     swap(_total_data,   src._total_data);
     swap(_top,          src._top);
     swap(_neg,          src._neg);
+    swap(_borrowed,     src._borrowed);
+
+}
+
+int bi::big_int::_big_int_assign(const bi::big_int &src) {
+
+    /* Copy into the existing buffer, allocates only if src does not fit. */
+    if (this == &src) {
+        return 0;
+    }
+    if (src._top >= _total_data) {
+        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + src._top);
+    }
+    std::copy_n(src._data, src._top, _data);
+    _top = src._top;
+    _neg = src._neg;
+    return 0;
 
 }
 
 int bi::big_int::_big_int_expand(int req) {
 
     if (req > 0) {
+        _BI_STAT_ADD(BI_STAT_EXPAND_CALLS, 1);
+        _BI_STAT_ADD(BI_STAT_BYTES_ALLOCATED, sizeof(BI_BASE_TYPE) * static_cast<size_t>(_total_data + req));
         BI_BASE_TYPE *temp_buff = new BI_BASE_TYPE[_total_data + req];
         if(!temp_buff) {
             _BI_LOG(1, "_big_int_expand failed");
@@ -67,89 +90,6 @@ int bi::big_int::_big_int_expand(int req) {
 
 }
 
-int bi::big_int::_big_int_from_string(const std::string &str_num) {
-
-    size_t str_size = str_num.length(), num_decor_cnt = 0;
-    size_t is_neg = 0;
-    if (str_size > 0 && str_num[0] == '-') {
-        is_neg = 1;
-        num_decor_cnt += 1;
-    }
-    if((str_size > (1 + is_neg)) && str_num[is_neg] == '0' && \
-    (str_num[is_neg + 1] == 'x' || str_num[is_neg + 1] == 'X')) {
-        num_decor_cnt += 2;
-    }
-
-    str_size -= num_decor_cnt;
-
-    /* Clear any previous data. */
-    big_int_clear();
-
-    size_t extr_space_reqd = ((str_size % BI_HEX_STR_TO_DATA_SIZE == 0) ? \
-    0 : (BI_HEX_STR_TO_DATA_SIZE - (str_size % BI_HEX_STR_TO_DATA_SIZE)));
-    
-    size_t base_t_aligned_size = str_size + extr_space_reqd;
-    std::unique_ptr<char []> temp_str(new char[base_t_aligned_size]);
-    memset(temp_str.get(), '0', extr_space_reqd);
-    memcpy(temp_str.get() + extr_space_reqd, str_num.c_str() + num_decor_cnt, str_size);
-
-    int str_cur_indx = static_cast<int>(base_t_aligned_size - BI_HEX_STR_TO_DATA_SIZE);
-
-    if(static_cast<int>((base_t_aligned_size / BI_HEX_STR_TO_DATA_SIZE) + 1) >= _total_data) {
-        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + static_cast<int>((base_t_aligned_size / BI_HEX_STR_TO_DATA_SIZE) + 1));
-    }
-    
-    for(; str_cur_indx >= 0; str_cur_indx -= static_cast<int>(BI_HEX_STR_TO_DATA_SIZE)) {
-        if(sscanf(&(temp_str.get()[str_cur_indx]), BI_SSCANF_FORMAT_HEX, &_data[_top++]) == EOF) {
-            big_int_clear();
-            return -1;
-        }
-    }
-
-    if(big_int_is_zero() == true && is_neg) {
-        return -1;
-    }
-    _neg = static_cast<bool>(is_neg);
-
-    /* Remove extra zeroes in the MSB if the i/p string had them, except the last zero (to denote zero big integer).*/
-    _big_int_remove_preceding_zeroes();
-
-    return 0;
-
-}
-
-std::string bi::big_int::_big_int_to_string() {
-
-    size_t chars_per_data = BI_SPRINF_FORMAT_HEX_CHARS;
-
-    if (_top <= 0) {
-        throw std::length_error("Invalid number: zero length");
-    }
-
-    size_t is_neg = 0;
-    if (big_int_is_negetive()) {
-        is_neg = 1;
-    }
-
-    std::unique_ptr<char []> char_temp_buff(new char[static_cast<size_t>(_top) * chars_per_data + 1 + is_neg]);
-    memset(char_temp_buff.get(), '\0', static_cast<size_t>(_top) * chars_per_data + 1 + is_neg);
-    if (is_neg) {
-        char_temp_buff.get()[0] = '-';
-    }
-
-    for(int i = _top - 1; i >= 0; --i) {
-
-        sprintf(char_temp_buff.get() + is_neg + ((static_cast<size_t>(_top) - 1) - static_cast<size_t>(i)) * \
-        chars_per_data, BI_SPRINF_FORMAT_HEX, _data[i]);
-        _BI_LOG(3, BI_SPRINF_FORMAT_HEX_LOG, _data[i]);
-    
-    }
-
-    std::string op_string(char_temp_buff.get());
-    return op_string;
-
-}
-
 BI_BASE_TYPE bi::big_int::_big_int_sub_base_type(BI_BASE_TYPE *data_ptr, int min, bi::big_int &res_ptr) const {
 
     BI_BASE_TYPE borrow = 0;
@@ -204,6 +144,7 @@ int bi::big_int::_big_int_unsigned_multiply_bi_base_type(BI_BASE_TYPE b, bi::big
         res_ptr._big_int_expand(BI_DEFAULT_EXPAND_COUNT + _top);
     }
 
+    _BI_STAT_ADD(BI_STAT_LIMB_MULTIPLIES, static_cast<uint64_t>(_top));
     for(int i = 0; i < _top; ++i) {
         interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(_data[i]) * b + carry;
         res_ptr._data[(res_ptr._top)++] = interim_res & BI_BASE_TYPE_MAX;
@@ -309,7 +250,14 @@ int bi::big_int::_big_int_get_num_of_hex_chars() const {
 
 }
 
-int bi::big_int::_big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder) {
+int bi::big_int::_big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder) const {
+
+    big_int scratch;
+    return _big_int_divide_once(divisor, op_quotient, op_remainder, scratch);
+
+}
+
+int bi::big_int::_big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder, big_int &scratch) const {
 
     if (divisor.big_int_is_zero()) {
         // throw std::length_error("Division by zero undefined");
@@ -333,7 +281,7 @@ int bi::big_int::_big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_q
     case -1:
         /* Divisor is greater than dividend, set quotient as zero 
         and remainder as dividend */
-        op_remainder = *this;
+        op_remainder._big_int_assign(*this);
         op_quotient = 0;
         return 0;
     case 0:
@@ -343,18 +291,16 @@ int bi::big_int::_big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_q
         return 0;
     }
 
-    big_int temp_val, temp_val_2;
-
     /* Start from 2 as the cases 0 & 1 are covered already in the above lines. */
     BI_BASE_TYPE i = 2;
     for (; i <= 0x10; ++i) {
-        divisor.big_int_unsigned_multiply_base_type(i, temp_val);
-        comp_res = big_int_unsigned_compare(temp_val);
+        divisor.big_int_unsigned_multiply_base_type(i, scratch);
+        comp_res = big_int_unsigned_compare(scratch);
         switch (comp_res) {
         case -1:
             op_quotient = i - 1;
-            divisor.big_int_unsigned_multiply_base_type(i - 1, temp_val_2);
-            big_int_unsigned_sub(temp_val_2, op_remainder);
+            divisor.big_int_unsigned_multiply_base_type(i - 1, scratch);
+            big_int_unsigned_sub(scratch, op_remainder);
             return 0;
         case 0:
             op_quotient = i;
@@ -407,35 +353,47 @@ int bi::big_int::_big_int_get_hex_char_from_lsb(int hex_indx_from_lsb, BI_BASE_T
 
 }
 
-int bi::big_int::_big_int_fast_modular_exponentiation(const bi::big_int &exponent, const bi::big_int &modulus, bi::big_int &result) {
+int bi::big_int::_big_int_fast_modular_exponentiation(
+    const bi::big_int &exponent, 
+    const bi::big_int &modulus, 
+    bi::big_int &result, 
+    bi::big_int_workspace &workspace) const {
 
     int ret_val = 0;
+    _BI_STAT_ADD(BI_STAT_MODULAR_EXPONENTIATIONS, 1);
 
+    big_int_workspace_frame frame(workspace);
     if (exponent.big_int_is_zero() == true && modulus.big_int_is_negetive() == true) {
-        big_int bi_1;
+        big_int &bi_1 = frame.big_int_workspace_frame_get();
         bi_1.big_int_from_base_type(1, false);
         ret_val += modulus.big_int_unsigned_sub(bi_1, result);
         ret_val += result.big_int_set_negetive(true);
         return ret_val;
     }
 
-    
+    big_int &temp_base = frame.big_int_workspace_frame_get();
+    big_int &temp_exponent = frame.big_int_workspace_frame_get();
+    big_int &temp_result = frame.big_int_workspace_frame_get();
+    big_int &temp_result_2 = frame.big_int_workspace_frame_get();
+    big_int &temp_mul_scratch = frame.big_int_workspace_frame_get();
+    ret_val += temp_base._big_int_assign(*this);
+    ret_val += temp_exponent._big_int_assign(exponent);
     ret_val += result.big_int_from_base_type(1, false);
-    big_int bi_2;
-    ret_val += bi_2.big_int_from_base_type(2, false);
     
-    big_int temp_base(*this), temp_exponent(exponent), temp_exponent_2, temp_result, temp_result_2;
     BI_BASE_TYPE temp_exponent_rem;
     while (temp_exponent.big_int_is_zero() == false) {
+        if (big_int_cancel_scope::cancellation_requested()) {
+            return -1;
+        }
         ret_val += temp_exponent._big_int_fast_divide_by_two(temp_exponent_rem);
         if (temp_exponent_rem != 0) {
-            ret_val += result.big_int_multiply(temp_base, temp_result);
-            ret_val += temp_result.big_int_modulus(modulus, temp_result_2);
-            result = temp_result_2;
+            ret_val += result._big_int_multiply(temp_base, temp_result, temp_mul_scratch);
+            ret_val += temp_result.big_int_modulus(modulus, temp_result_2, workspace);
+            ret_val += result._big_int_assign(temp_result_2);
         }
-        ret_val += temp_base.big_int_multiply(temp_base, temp_result);
-        ret_val += temp_result.big_int_modulus(modulus, temp_result_2);
-        temp_base = temp_result_2;
+        ret_val += temp_base._big_int_multiply(temp_base, temp_result, temp_mul_scratch);
+        ret_val += temp_result.big_int_modulus(modulus, temp_result_2, workspace);
+        temp_base._big_int_swap(temp_result_2);
     }
     return ret_val;
 
@@ -457,7 +415,7 @@ int bi::big_int::_big_int_fast_divide_by_two(BI_BASE_TYPE &remainder) {
 
 }
 
-int bi::big_int::_big_int_generate_random_probable_prime(int bits, std::mt19937 &mt_arg, std::uniform_int_distribution<BI_BASE_TYPE> &uni_dist, int max_lower_prime_check) {
+int bi::big_int::_big_int_generate_random_probable_prime(int bits, big_int_random_source &rng, int max_lower_prime_check) {
 
     int ret_val = 0;
     constexpr int max_prime_list_total_length = sizeof(first_primes_list) / sizeof(BI_BASE_TYPE);
@@ -472,15 +430,19 @@ int bi::big_int::_big_int_generate_random_probable_prime(int bits, std::mt19937
         max_prime_list_length = max_prime_list_total_length;
     }
 
+    big_int_trace_span trace_span("candidate_generation", "prime_search");
+    int64_t candidates = 0;
     while (ret_val == 0) {
         int prim_cntr = 0;
         big_int rand_test_val, lower_prime, temp_quo, temp_rem;
-        ret_val += rand_test_val._big_int_generate_random_unsigned(bits, mt_arg, uni_dist);
+        ret_val += rand_test_val._big_int_generate_random_unsigned(bits, rng);
+        ++candidates;
         for (int i = 0; i < max_prime_list_length; ++i) {
             ret_val += lower_prime.big_int_from_base_type(first_primes_list[i], false);
             ret_val += rand_test_val.big_int_div(lower_prime, temp_quo, temp_rem);
             if (temp_rem.big_int_is_zero() == true) {
                 ++prim_cntr;
+                big_int_trace_session::big_int_trace_instant("sieve_reject", "prime_search", "prime", first_primes_list[i]);
                 break;
             }
         }
@@ -488,56 +450,61 @@ int bi::big_int::_big_int_generate_random_probable_prime(int bits, std::mt19937
             (*this) = rand_test_val;
             break;
         }
+        _BI_STAT_ADD(BI_STAT_REJECTED_CANDIDATES, 1);
     }
+    trace_span.big_int_trace_span_arg("candidates", candidates);
     
     return ret_val;
 
 }
 
-int bi::big_int::_big_int_generate_random_unsigned(int bits, std::mt19937 &mt_arg, std::uniform_int_distribution<BI_BASE_TYPE> &uni_dist) {
+int bi::big_int::_big_int_generate_random_unsigned(int bits, big_int_random_source &rng) {
 
     big_int_clear();
 
-    if ((bits / BI_BASE_TYPE_TOTAL_BITS) >= _total_data) {
-        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + (bits / BI_BASE_TYPE_TOTAL_BITS));
+    if (bits <= 0) {
+        return big_int_set_zero();
     }
 
-    for (int i = 0; i < bits / BI_BASE_TYPE_TOTAL_BITS; ++i) {
-        _data[_top++] = uni_dist(mt_arg);
+    int total_words = (bits + BI_BASE_TYPE_TOTAL_BITS - 1) / BI_BASE_TYPE_TOTAL_BITS;
+    if (total_words >= _total_data) {
+        _big_int_expand(BI_DEFAULT_EXPAND_COUNT + total_words);
     }
+
+    /* Draw all the limbs straight from the keystream and mask the excess top bits. */
+    rng.fill(_data, static_cast<size_t>(total_words));
+    _top = total_words;
     
     int rem_bits = bits % BI_BASE_TYPE_TOTAL_BITS;
     if (rem_bits > 0) {
-        if (_top >= _total_data) {
-            _big_int_expand(BI_DEFAULT_EXPAND_COUNT);
-        }
-        BI_BASE_TYPE temp_val = (uni_dist(mt_arg) % static_cast<BI_BASE_TYPE>((1 << rem_bits)));
-        if (temp_val > 0) {
-            _data[_top++] = temp_val;
-        }
+        _data[_top - 1] &= static_cast<BI_BASE_TYPE>((static_cast<BI_DOUBLE_BASE_TYPE>(1) << rem_bits) - 1);
     }
 
-    return 0;
+    return _big_int_remove_preceding_zeroes();
 
 }
 
 int bi::big_int::_big_int_get_random_unsigned_between(
-    std::mt19937 &mt_arg, 
-    std::uniform_int_distribution<BI_BASE_TYPE> &uni_dist, 
-    std::uniform_int_distribution<int> &uni_dist_rand_bits, 
+    big_int_random_source &rng, 
     const big_int &low, 
     const big_int &high) {
 
     int ret_val = 0;
 
-    if (high.big_int_unsigned_compare(low) < 0) {
+    if (high.big_int_unsigned_compare(low) <= 0) {
         return -1;
     }
 
-    int rand_bits = uni_dist_rand_bits(mt_arg);
+    /* Exact bit length of high, draws are masked to it so each one lands below 
+       2 * high and more than half of them are accepted when low is small. */
+    int rand_bits = (high._top - 1) * BI_BASE_TYPE_TOTAL_BITS;
+    for (BI_BASE_TYPE top_word = high._data[high._top - 1]; top_word != 0; top_word >>= 1) {
+        ++rand_bits;
+    }
+
+    big_int temp_rand;
     while (ret_val == 0) {
-        big_int temp_rand;
-        temp_rand._big_int_generate_random_unsigned(rand_bits, mt_arg, uni_dist);
+        ret_val += temp_rand._big_int_generate_random_unsigned(rand_bits, rng);
         int low_comp_res = low.big_int_unsigned_compare(temp_rand);   
         int high_comp_res = high.big_int_unsigned_compare(temp_rand); 
         if ((low_comp_res <= 0) && (high_comp_res > 0)) {
@@ -548,4 +515,173 @@ int bi::big_int::_big_int_get_random_unsigned_between(
 
     return ret_val;
 
-}
\ No newline at end of file
+}
+
+int bi::big_int::_big_int_rabin_miller_decompose(big_int &op_d, int &op_s) const {
+
+    /* candidate - 1 = d * 2 ^ s, with d odd. */
+    int ret_val = 0;
+    big_int bi_1;
+    ret_val += bi_1.big_int_from_base_type(1, false);
+    ret_val += big_int_unsigned_sub(bi_1, op_d);
+
+    op_s = 0;
+    BI_BASE_TYPE div_2_rem;
+    while (op_d.big_int_is_zero() == false && op_d.big_int_is_even() == true) {
+        ret_val += op_d._big_int_fast_divide_by_two(div_2_rem);
+        ++op_s;
+    }
+    return ret_val;
+
+}
+
+/* x = witness ^ d mod candidate is neither 1 nor candidate - 1, square up to s - 1 times looking 
+   for candidate - 1, reaching 1 first proves compositeness. */
+int bi::big_int::_big_int_rabin_miller_square_chain(big_int &x, int s, bool &op_probable_prime, big_int_workspace &workspace) const {
+
+    int ret_val = 0;
+    big_int_workspace_frame frame(workspace);
+    big_int &bi_1 = frame.big_int_workspace_frame_get();
+    big_int &candidate_sub_1 = frame.big_int_workspace_frame_get();
+    big_int &temp_sqr = frame.big_int_workspace_frame_get();
+    big_int &temp_mul_scratch = frame.big_int_workspace_frame_get();
+    ret_val += bi_1.big_int_from_base_type(1, false);
+    ret_val += big_int_unsigned_sub(bi_1, candidate_sub_1);
+
+    op_probable_prime = false;
+    for (int j = 1; j < s && !big_int_cancel_scope::cancellation_requested(); ++j) {
+        ret_val += x._big_int_multiply(x, temp_sqr, temp_mul_scratch);
+        ret_val += temp_sqr.big_int_modulus(*this, x, workspace);
+        if (ret_val != 0) {
+            break;
+        }
+        if (x.big_int_unsigned_compare(candidate_sub_1) == 0) {
+            op_probable_prime = true;
+            break;
+        }
+        if (x.big_int_unsigned_compare(bi_1) == 0) {
+            break;
+        }
+    }
+
+    /* A candidate stops at its first failed round, so this counts it once. */
+    if (op_probable_prime == false && ret_val == 0 && !big_int_cancel_scope::cancellation_requested()) {
+        _BI_STAT_ADD(BI_STAT_REJECTED_CANDIDATES, 1);
+    }
+    return ret_val;
+
+}
+
+/* Rabin-Miller on count (odd, > 3) candidates in lock step, a base 2 round that rejects almost
+   every composite and then reqd_rabin_miller_iterations random witness rounds for the survivors.
+   Each round runs the exponentiations of all remaining candidates through the multi buffer kernel.
+   rngs[i] draws the witnesses of candidates[i], entries may point to the same generator. */
+int bi::big_int::_big_int_rabin_miller_test_multi(
+    const big_int *candidates, 
+    size_t count, 
+    int reqd_rabin_miller_iterations, 
+    big_int_random_source *const *rngs, 
+    bool *op_probable_prime) {
+
+    int ret_val = 0;
+    std::vector<big_int> round_candidates(candidates, candidates + count), d(count), witnesses(count), x(count);
+    std::vector<int> s(count);
+    std::vector<size_t> round_index(count);
+    bool montgomery_ok = true;
+    for (size_t i = 0; i < count; ++i) {
+        op_probable_prime[i] = false;
+        round_index[i] = i;
+        ret_val += candidates[i]._big_int_rabin_miller_decompose(d[i], s[i]);
+        montgomery_ok = montgomery_ok && candidates[i]._top > 1;
+    }
+
+    /* Candidates are one-shot moduli, their contexts are built once here and kept out of the
+       Montgomery cache so they do not evict the long lived keys. */
+    std::vector<std::unique_ptr<big_int_montgomery_ctx>> ctxs;
+    std::vector<const big_int_montgomery_ctx *> round_ctxs;
+    if (montgomery_ok) {
+        for (size_t i = 0; i < count; ++i) {
+            ctxs.emplace_back(new big_int_montgomery_ctx(candidates[i]));
+            round_ctxs.push_back(ctxs.back().get());
+        }
+    }
+
+    big_int_trace_span trace_span("rabin_miller_multi", "prime_search");
+    trace_span.big_int_trace_span_arg("candidates", static_cast<int64_t>(count));
+
+    big_int bi_1, bi_2, candidate_sub_1;
+    big_int_workspace workspace;
+    ret_val += bi_1.big_int_from_base_type(1, false);
+    ret_val += bi_2.big_int_from_base_type(2, false);
+
+    /* Round 0 is the base 2 round. */
+    int round = 0;
+    size_t remaining = count;
+    for (; round <= reqd_rabin_miller_iterations && remaining > 0 && ret_val == 0 && \
+        !big_int_cancel_scope::cancellation_requested(); ++round) {
+
+        for (size_t k = 0; k < remaining; ++k) {
+            if (round == 0) {
+                witnesses[k] = bi_2;
+            } else {
+                ret_val += witnesses[k]._big_int_get_random_unsigned_between(*rngs[round_index[k]], bi_2, round_candidates[k]);
+            }
+        }
+        _BI_STAT_ADD(BI_STAT_RABIN_MILLER_ROUNDS, remaining);
+        if (montgomery_ok) {
+            ret_val += big_int_montgomery_ctx::big_int_montgomery_multi_modular_exponentiation(round_ctxs.data(), \
+                witnesses.data(), d.data(), x.data(), remaining);
+        } else {
+            ret_val += _big_int_multi_modular_exponentiation(witnesses.data(), d.data(), round_candidates.data(), \
+                x.data(), remaining, false);
+        }
+        if (ret_val != 0) {
+            /* Cancelled or failed exponentiation, the partial results mean nothing. */
+            break;
+        }
+
+        /* Survivors are moved to the front, in their original order. */
+        size_t kept = 0;
+        for (size_t k = 0; k < remaining; ++k) {
+            bool passed;
+            ret_val += round_candidates[k].big_int_unsigned_sub(bi_1, candidate_sub_1);
+            if (x[k].big_int_unsigned_compare(bi_1) == 0 || x[k].big_int_unsigned_compare(candidate_sub_1) == 0) {
+                passed = true;
+            } else {
+                ret_val += round_candidates[k]._big_int_rabin_miller_square_chain(x[k], s[k], passed, workspace);
+            }
+            if (passed && kept != k) {
+                round_candidates[kept] = std::move(round_candidates[k]);
+                d[kept] = std::move(d[k]);
+                s[kept] = s[k];
+                round_index[kept] = round_index[k];
+                if (montgomery_ok) {
+                    round_ctxs[kept] = round_ctxs[k];
+                }
+            }
+            kept += passed ? 1 : 0;
+        }
+        remaining = kept;
+    }
+
+    /* Only a full set of passed rounds counts, a stopped test is not a prime. */
+    if (round == reqd_rabin_miller_iterations + 1 && ret_val == 0) {
+        for (size_t k = 0; k < remaining; ++k) {
+            op_probable_prime[round_index[k]] = true;
+        }
+    }
+    trace_span.big_int_trace_span_arg("passed", static_cast<int64_t>(remaining));
+    return ret_val;
+
+}
+
+int bi::big_int::_big_int_rabin_miller_test(
+    int reqd_rabin_miller_iterations, 
+    big_int_random_source &rng, 
+    bool &op_probable_prime) const {
+
+    /* A batch of one, which still gets the Montgomery kernel and the cheap base 2 round first. */
+    big_int_random_source *rngs[1] = {&rng};
+    return _big_int_rabin_miller_test_multi(this, 1, reqd_rabin_miller_iterations, rngs, &op_probable_prime);
+
+}
@@ -0,0 +1,707 @@
+/**
+ *  @file   big_int_radix.cc
+ *  @brief  Native decimal radix conversion
+ *
+ *  Decimal input splits the digit string at 9 * 2^k digits and recombines
+ *  the halves as hi * 10^(9 * 2^k) + lo with Karatsuba multiplication.
+ *  Decimal output divides by the cached power closest to the square root
+ *  of the number and emits quotient then zero padded remainder. Below a
+ *  threshold both directions work a word (9 digits) at a time.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+#include "big_int_radix.hpp"
+
+namespace {
+
+    constexpr size_t    KARATSUBA_THRESHOLD_LIMBS       = 32;
+    constexpr size_t    DEC_DC_THRESHOLD_LIMBS          = 48;
+    constexpr size_t    DEC_DC_THRESHOLD_DIGITS         = DEC_DC_THRESHOLD_LIMBS * BI_DEC_DIGITS_PER_BASE_TYPE;
+    constexpr size_t    BARRETT_THRESHOLD_LIMBS         = 64;
+
+    /* A cached power of ten, with the normalized copy and reciprocal used by
+       large divisions filled in on first use. */
+    struct dec_power_entry {
+        bi::radix_limbs     power;
+        bi::radix_limbs     normalized;
+        bi::radix_limbs     reciprocal;
+        int                 shift;
+    };
+
+    std::mutex                      dec_power_mutex;
+    std::deque<dec_power_entry>     dec_powers;
+
+    /* res[0, an + bn) += a * b */
+    void schoolbook_multiply_add(const BI_BASE_TYPE *a, size_t an, const BI_BASE_TYPE *b, size_t bn, BI_BASE_TYPE *res) {
+
+        for (size_t i = 0; i < bn; ++i) {
+            BI_DOUBLE_BASE_TYPE carry = 0;
+            for (size_t j = 0; j < an; ++j) {
+                BI_DOUBLE_BASE_TYPE interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(a[j]) * b[i] + res[i + j] + carry;
+                res[i + j] = static_cast<BI_BASE_TYPE>(interim_res);
+                carry = interim_res >> BI_BASE_TYPE_TOTAL_BITS;
+            }
+            for (size_t k = i + an; carry != 0; ++k) {
+                BI_DOUBLE_BASE_TYPE interim_res = static_cast<BI_DOUBLE_BASE_TYPE>(res[k]) + carry;
+                res[k] = static_cast<BI_BASE_TYPE>(interim_res);
+                carry = interim_res >> BI_BASE_TYPE_TOTAL_BITS;
+            }
+        }
+
+    }
+
+    /* dst[0, ...) += src[0, n), propagating the carry as far as needed. */
+    void limbs_add_into(BI_BASE_TYPE *dst, const BI_BASE_TYPE *src, size_t n) {
+
+        BI_DOUBLE_BASE_TYPE carry = 0;
+        size_t i = 0;
+        for (; i < n; ++i) {
+            carry += static_cast<BI_DOUBLE_BASE_TYPE>(dst[i]) + src[i];
+            dst[i] = static_cast<BI_BASE_TYPE>(carry);
+            carry >>= BI_BASE_TYPE_TOTAL_BITS;
+        }
+        for (; carry != 0; ++i) {
+            carry += dst[i];
+            dst[i] = static_cast<BI_BASE_TYPE>(carry);
+            carry >>= BI_BASE_TYPE_TOTAL_BITS;
+        }
+
+    }
+
+    /* dst[0, dn) -= src[0, n), the result must not be negetive. */
+    void limbs_sub_from(BI_BASE_TYPE *dst, size_t dn, const BI_BASE_TYPE *src, size_t n) {
+
+        BI_BASE_TYPE borrow = 0;
+        for (size_t i = 0; i < dn && (i < n || borrow != 0); ++i) {
+            BI_DOUBLE_BASE_TYPE diff = static_cast<BI_DOUBLE_BASE_TYPE>(dst[i]) - (i < n ? src[i] : 0) - borrow;
+            dst[i] = static_cast<BI_BASE_TYPE>(diff);
+            borrow = static_cast<BI_BASE_TYPE>((diff >> BI_BASE_TYPE_TOTAL_BITS) & 1);
+        }
+
+    }
+
+    /* res[0, an + bn) += a * b, an >= bn. */
+    void karatsuba_multiply_add(const BI_BASE_TYPE *a, size_t an, const BI_BASE_TYPE *b, size_t bn, BI_BASE_TYPE *res) {
+
+        if (bn < KARATSUBA_THRESHOLD_LIMBS) {
+            schoolbook_multiply_add(a, an, b, bn, res);
+            return;
+        }
+
+        if (an >= 2 * bn) {
+            /* Unbalanced, multiply b by bn sized slices of a. */
+            for (size_t offset = 0; offset < an; offset += bn) {
+                size_t slice = std::min(bn, an - offset);
+                if (slice >= bn) {
+                    karatsuba_multiply_add(a + offset, slice, b, bn, res + offset);
+                } else {
+                    karatsuba_multiply_add(b, bn, a + offset, slice, res + offset);
+                }
+            }
+            return;
+        }
+
+        /* a = a1 * W^h + a0, b = b1 * W^h + b0 with h < bn <= an < 2 * h + 2. */
+        size_t h = (an + 1) / 2;
+        size_t a1n = an - h, b1n = bn - h;
+
+        std::vector<BI_BASE_TYPE> sum_a(h + 1, 0), sum_b(h + 1, 0);
+        std::copy_n(a, h, sum_a.begin());
+        limbs_add_into(sum_a.data(), a + h, a1n);
+        std::copy_n(b, h, sum_b.begin());
+        limbs_add_into(sum_b.data(), b + h, b1n);
+
+        std::vector<BI_BASE_TYPE> z0(2 * h + 1, 0), z2(a1n + b1n + 1, 0), z1(2 * h + 3, 0);
+        karatsuba_multiply_add(a, h, b, h, z0.data());
+        if (b1n > 0) {
+            if (a1n >= b1n) {
+                karatsuba_multiply_add(a + h, a1n, b + h, b1n, z2.data());
+            } else {
+                karatsuba_multiply_add(b + h, b1n, a + h, a1n, z2.data());
+            }
+        }
+        karatsuba_multiply_add(sum_a.data(), h + 1, sum_b.data(), h + 1, z1.data());
+
+        /* z1 = (a0 + a1)(b0 + b1) - z0 - z2 */
+        limbs_sub_from(z1.data(), z1.size(), z0.data(), 2 * h);
+        limbs_sub_from(z1.data(), z1.size(), z2.data(), a1n + b1n);
+
+        /* Trim the spare top words (zero by now) so the adds stay inside res. */
+        size_t z1n = std::min(z1.size(), an + bn - h);
+        limbs_add_into(res, z0.data(), 2 * h);
+        limbs_add_into(res + h, z1.data(), z1n);
+        limbs_add_into(res + 2 * h, z2.data(), a1n + b1n);
+
+    }
+
+    /* val = val * mul + add */
+    void limbs_multiply_add_word(bi::radix_limbs &val, BI_BASE_TYPE mul, BI_BASE_TYPE add) {
+
+        BI_DOUBLE_BASE_TYPE carry = add;
+        for (auto &limb : val) {
+            carry += static_cast<BI_DOUBLE_BASE_TYPE>(limb) * mul;
+            limb = static_cast<BI_BASE_TYPE>(carry);
+            carry >>= BI_BASE_TYPE_TOTAL_BITS;
+        }
+        if (carry != 0) {
+            val.push_back(static_cast<BI_BASE_TYPE>(carry));
+        }
+
+    }
+
+    /* val /= div, returns the remainder. */
+    BI_BASE_TYPE limbs_divide_word(bi::radix_limbs &val, BI_BASE_TYPE div) {
+
+        BI_DOUBLE_BASE_TYPE rem = 0;
+        for (size_t i = val.size(); i-- > 0;) {
+            BI_DOUBLE_BASE_TYPE cur = (rem << BI_BASE_TYPE_TOTAL_BITS) | val[i];
+            val[i] = static_cast<BI_BASE_TYPE>(cur / div);
+            rem = cur % div;
+        }
+        bi::radix_normalize(val);
+        return static_cast<BI_BASE_TYPE>(rem);
+
+    }
+
+    BI_BASE_TYPE parse_dec_word(const char *digits, size_t count) {
+
+        BI_BASE_TYPE val = 0;
+        for (size_t i = 0; i < count; ++i) {
+            val = val * 10 + static_cast<BI_BASE_TYPE>(digits[i] - '0');
+        }
+        return val;
+
+    }
+
+    /* Writes exactly 9 digits. */
+    void format_dec_word(BI_BASE_TYPE val, char *dst) {
+
+        for (int i = BI_DEC_DIGITS_PER_BASE_TYPE - 1; i >= 0; --i) {
+            dst[i] = static_cast<char>('0' + val % 10);
+            val /= 10;
+        }
+
+    }
+
+    int limbs_compare(const bi::radix_limbs &a, const bi::radix_limbs &b) {
+
+        if (a.size() != b.size()) {
+            return (a.size() > b.size()) ? 1 : -1;
+        }
+        for (size_t i = a.size(); i-- > 0;) {
+            if (a[i] != b[i]) {
+                return (a[i] > b[i]) ? 1 : -1;
+            }
+        }
+        return 0;
+
+    }
+
+    /* a += b */
+    void limbs_add(bi::radix_limbs &a, const bi::radix_limbs &b) {
+
+        a.resize(std::max(a.size(), b.size()) + 1, 0);
+        limbs_add_into(a.data(), b.data(), b.size());
+        bi::radix_normalize(a);
+
+    }
+
+    /* a -= b, a >= b */
+    void limbs_sub(bi::radix_limbs &a, const bi::radix_limbs &b) {
+
+        limbs_sub_from(a.data(), a.size(), b.data(), b.size());
+        bi::radix_normalize(a);
+
+    }
+
+    /* a += w or a -= w for a single word w. */
+    void limbs_add_word(bi::radix_limbs &a, BI_BASE_TYPE w) {
+
+        limbs_add(a, bi::radix_limbs{w});
+
+    }
+
+    void limbs_sub_word(bi::radix_limbs &a, BI_BASE_TYPE w) {
+
+        limbs_sub(a, bi::radix_limbs{w});
+
+    }
+
+    /* Drops the lowest words limbs, i.e. a / W^words. */
+    bi::radix_limbs limbs_shift_down(const bi::radix_limbs &a, size_t words) {
+
+        if (a.size() <= words) {
+            return bi::radix_limbs();
+        }
+        return bi::radix_limbs(a.begin() + static_cast<std::ptrdiff_t>(words), a.end());
+
+    }
+
+    /* W^words */
+    bi::radix_limbs limbs_word_power(size_t words) {
+
+        bi::radix_limbs res(words + 1, 0);
+        res[words] = 1;
+        return res;
+
+    }
+
+    /* a << bits, bits < 32 */
+    bi::radix_limbs limbs_shift_bits_up(const bi::radix_limbs &a, int bits) {
+
+        bi::radix_limbs res(a.size() + 1, 0);
+        for (size_t i = 0; i < a.size(); ++i) {
+            res[i] |= a[i] << bits;
+            if (bits != 0) {
+                res[i + 1] = a[i] >> (BI_BASE_TYPE_TOTAL_BITS - bits);
+            }
+        }
+        bi::radix_normalize(res);
+        return res;
+
+    }
+
+    /*
+
+        Newton reciprocal
+        -----------------
+
+        For a normalized d (top bit set) of n limbs, v = floor(W^2n / d) with W = 2^32.
+        The reciprocal of the top h limbs, scaled up, is good to about h words; one Newton 
+        step v + v * (W^2n - d * v) / W^2n doubles that, and the last few units are 
+        corrected against the exact remainder. Costs a constant number of multiplications
+        of n limbs, so division by a cached power runs at Karatsuba speed.
+
+    */
+    void limbs_reciprocal(const bi::radix_limbs &d, bi::radix_limbs &v) {
+
+        size_t n = d.size();
+        bi::radix_limbs w2n = limbs_word_power(2 * n);
+
+        if (n <= BARRETT_THRESHOLD_LIMBS) {
+            bi::radix_limbs rem;
+            bi::radix_divmod(w2n, d, v, rem);
+            return;
+        }
+
+        /* A couple of guard limbs keep the initial error well inside one Newton step. */
+        size_t h = std::min(n, n / 2 + 2);
+        bi::radix_limbs dh = limbs_shift_down(d, n - h), vh;
+        limbs_reciprocal(dh, vh);
+        bi::radix_limbs v0(n - h, 0);
+        v0.insert(v0.end(), vh.begin(), vh.end());
+
+        bi::radix_limbs t, e, correction;
+        bi::radix_multiply(d, v0, t);
+        if (limbs_compare(t, w2n) <= 0) {
+            e = w2n;
+            limbs_sub(e, t);
+            bi::radix_multiply(v0, e, correction);
+            v = v0;
+            limbs_add(v, limbs_shift_down(correction, 2 * n));
+        } else {
+            e = t;
+            limbs_sub(e, w2n);
+            bi::radix_multiply(v0, e, correction);
+            v = v0;
+            limbs_sub(v, limbs_shift_down(correction, 2 * n));
+            limbs_sub_word(v, 1);
+        }
+
+        bi::radix_multiply(d, v, t);
+        while (limbs_compare(t, w2n) > 0) {
+            limbs_sub_word(v, 1);
+            limbs_sub(t, d);
+        }
+        bi::radix_limbs r = w2n;
+        limbs_sub(r, t);
+        while (limbs_compare(r, d) >= 0) {
+            limbs_add_word(v, 1);
+            limbs_sub(r, d);
+        }
+
+    }
+
+    /* a = q * d + r for a < W^n * d, d normalized with n limbs and v its reciprocal. */
+    void limbs_barrett_divmod(const bi::radix_limbs &a, const bi::radix_limbs &d, const bi::radix_limbs &v, \
+        bi::radix_limbs &q, bi::radix_limbs &r) {
+
+        size_t n = d.size();
+        bi::radix_limbs product;
+        bi::radix_multiply(a, v, product);
+        q = limbs_shift_down(product, 2 * n);
+
+        /* q is at most two short of the true quotient. */
+        bi::radix_multiply(q, d, product);
+        r = a;
+        limbs_sub(r, product);
+        while (limbs_compare(r, d) >= 0) {
+            limbs_add_word(q, 1);
+            limbs_sub(r, d);
+        }
+
+    }
+
+    /* val = quotient * 10^(9 * 2^k) + remainder */
+    void dec_power_divmod(const bi::radix_limbs &val, size_t k, bi::radix_limbs &quotient, bi::radix_limbs &remainder) {
+
+        const dec_power_entry *entry;
+        {
+            bi::radix_dec_power(k);
+            std::lock_guard<std::mutex> power_lock(dec_power_mutex);
+            dec_power_entry &cached = dec_powers[k];
+            if (cached.power.size() >= BARRETT_THRESHOLD_LIMBS && cached.reciprocal.empty()) {
+                cached.shift = 0;
+                while ((cached.power.back() << cached.shift & (static_cast<BI_BASE_TYPE>(1) << (BI_BASE_TYPE_TOTAL_BITS - 1))) == 0) {
+                    ++cached.shift;
+                }
+                cached.normalized = limbs_shift_bits_up(cached.power, cached.shift);
+                limbs_reciprocal(cached.normalized, cached.reciprocal);
+            }
+            entry = &cached;
+        }
+
+        if (entry->power.size() < BARRETT_THRESHOLD_LIMBS) {
+            bi::radix_divmod(val, entry->power, quotient, remainder);
+            return;
+        }
+
+        /* Long division in n limb blocks from the top, each step a Barrett division
+           of the running remainder and the next block. */
+        const bi::radix_limbs &d = entry->normalized;
+        size_t n = d.size();
+        bi::radix_limbs a = limbs_shift_bits_up(val, entry->shift);
+        size_t blocks = (a.size() + n - 1) / n;
+
+        bi::radix_limbs q(blocks * n, 0), r, cur, q_block;
+        for (size_t b = blocks; b-- > 0;) {
+            size_t begin = b * n, end = std::min(a.size(), begin + n);
+            cur.assign(n, 0);
+            std::copy(a.begin() + static_cast<std::ptrdiff_t>(begin), a.begin() + static_cast<std::ptrdiff_t>(end), cur.begin());
+            cur.insert(cur.end(), r.begin(), r.end());
+            bi::radix_normalize(cur);
+            limbs_barrett_divmod(cur, d, entry->reciprocal, q_block, r);
+            std::copy(q_block.begin(), q_block.end(), q.begin() + static_cast<std::ptrdiff_t>(begin));
+        }
+
+        /* Remainder back from the normalized scale. */
+        remainder.assign(r.size(), 0);
+        for (size_t i = 0; i < r.size(); ++i) {
+            remainder[i] = (r[i] >> entry->shift) | \
+                ((entry->shift != 0 && i + 1 < r.size()) ? r[i + 1] << (BI_BASE_TYPE_TOTAL_BITS - entry->shift) : 0);
+        }
+        bi::radix_normalize(remainder);
+        bi::radix_normalize(q);
+        quotient.swap(q);
+
+    }
+
+    /* Emits count '0' characters in bounded pieces. */
+    void emit_zeroes(size_t count, const bi::radix_char_sink &sink) {
+
+        static const char zeroes[64] = {
+            '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0',
+            '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0',
+            '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0',
+            '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0'
+        };
+        while (count > 0) {
+            size_t piece = std::min(count, sizeof(zeroes));
+            sink(zeroes, piece);
+            count -= piece;
+        }
+
+    }
+
+    void dec_to_limbs_word_at_a_time(const char *digits, size_t count, bi::radix_limbs &res) {
+
+        res.clear();
+        size_t head = count % BI_DEC_DIGITS_PER_BASE_TYPE;
+        if (head != 0) {
+            limbs_multiply_add_word(res, 1, parse_dec_word(digits, head));
+        }
+        for (size_t i = head; i < count; i += BI_DEC_DIGITS_PER_BASE_TYPE) {
+            limbs_multiply_add_word(res, BI_DEC_BASE_TYPE_RADIX, parse_dec_word(digits + i, BI_DEC_DIGITS_PER_BASE_TYPE));
+        }
+        bi::radix_normalize(res);
+
+    }
+
+    /* Emits val, left padded with zeroes to pad_digits (0 - no padding). */
+    void limbs_to_dec_word_at_a_time(bi::radix_limbs val, size_t pad_digits, const bi::radix_char_sink &sink) {
+
+        std::vector<BI_BASE_TYPE> words;
+        while (val.empty() == false) {
+            words.push_back(limbs_divide_word(val, BI_DEC_BASE_TYPE_RADIX));
+        }
+
+        std::vector<char> chars(words.size() * BI_DEC_DIGITS_PER_BASE_TYPE);
+        for (size_t i = 0; i < words.size(); ++i) {
+            format_dec_word(words[words.size() - 1 - i], chars.data() + i * BI_DEC_DIGITS_PER_BASE_TYPE);
+        }
+
+        size_t first = 0;
+        if (pad_digits == 0) {
+            while (first + 1 < chars.size() && chars[first] == '0') {
+                ++first;
+            }
+            if (chars.empty()) {
+                sink("0", 1);
+                return;
+            }
+        } else if (pad_digits > chars.size()) {
+            emit_zeroes(pad_digits - chars.size(), sink);
+        } else {
+            first = chars.size() - pad_digits;
+        }
+        sink(chars.data() + first, chars.size() - first);
+
+    }
+
+    void limbs_to_dec_dc(const bi::radix_limbs &val, size_t pad_digits, const bi::radix_char_sink &sink) {
+
+        if (val.size() <= DEC_DC_THRESHOLD_LIMBS) {
+            limbs_to_dec_word_at_a_time(val, pad_digits, sink);
+            return;
+        }
+
+        /* Largest cached power with at most half the limbs of val. */
+        size_t k = 0;
+        while (bi::radix_dec_power(k + 1).size() * 2 <= val.size() + 1) {
+            ++k;
+        }
+        size_t low_digits = static_cast<size_t>(BI_DEC_DIGITS_PER_BASE_TYPE) << k;
+
+        bi::radix_limbs quotient, remainder;
+        dec_power_divmod(val, k, quotient, remainder);
+        if (quotient.empty() == false || pad_digits > low_digits) {
+            limbs_to_dec_dc(quotient, (pad_digits > low_digits) ? (pad_digits - low_digits) : 0, sink);
+            limbs_to_dec_dc(remainder, low_digits, sink);
+        } else {
+            limbs_to_dec_dc(remainder, pad_digits, sink);
+        }
+
+    }
+
+}
+
+void bi::radix_normalize(radix_limbs &val) {
+
+    while (val.empty() == false && val.back() == 0) {
+        val.pop_back();
+    }
+
+}
+
+void bi::radix_multiply(const radix_limbs &a, const radix_limbs &b, radix_limbs &res) {
+
+    if (a.empty() || b.empty()) {
+        res.clear();
+        return;
+    }
+
+    radix_limbs product(a.size() + b.size(), 0);
+    if (a.size() >= b.size()) {
+        karatsuba_multiply_add(a.data(), a.size(), b.data(), b.size(), product.data());
+    } else {
+        karatsuba_multiply_add(b.data(), b.size(), a.data(), a.size(), product.data());
+    }
+    radix_normalize(product);
+    res.swap(product);
+
+}
+
+/*
+
+    Knuth algorithm D
+    -----------------
+
+    [refer](Hacker's Delight, divmnu64.c)
+
+    Normalize so the top bit of the divisor is set, then estimate every quotient
+    word from the top two dividend words and the top divisor word, correct the
+    estimate (at most twice) with the second divisor word, multiply and subtract,
+    and add back in the rare case the estimate was still one too large.
+
+*/
+
+void bi::radix_divmod(const radix_limbs &a, const radix_limbs &b, radix_limbs &quotient, radix_limbs &remainder) {
+
+    const BI_DOUBLE_BASE_TYPE base = static_cast<BI_DOUBLE_BASE_TYPE>(1) << BI_BASE_TYPE_TOTAL_BITS;
+    size_t m = a.size(), n = b.size();
+
+    if (m < n) {
+        quotient.clear();
+        remainder = a;
+        return;
+    }
+
+    if (n == 1) {
+        radix_limbs q(a);
+        BI_BASE_TYPE rem = limbs_divide_word(q, b[0]);
+        quotient.swap(q);
+        remainder.clear();
+        if (rem != 0) {
+            remainder.push_back(rem);
+        }
+        return;
+    }
+
+    int shift = 0;
+    while ((b[n - 1] << shift & (static_cast<BI_BASE_TYPE>(1) << (BI_BASE_TYPE_TOTAL_BITS - 1))) == 0) {
+        ++shift;
+    }
+
+    radix_limbs vn(n), un(m + 1), q(m - n + 1, 0);
+    for (size_t i = n - 1; i > 0; --i) {
+        vn[i] = (b[i] << shift) | (shift ? b[i - 1] >> (BI_BASE_TYPE_TOTAL_BITS - shift) : 0);
+    }
+    vn[0] = b[0] << shift;
+    un[m] = shift ? a[m - 1] >> (BI_BASE_TYPE_TOTAL_BITS - shift) : 0;
+    for (size_t i = m - 1; i > 0; --i) {
+        un[i] = (a[i] << shift) | (shift ? a[i - 1] >> (BI_BASE_TYPE_TOTAL_BITS - shift) : 0);
+    }
+    un[0] = a[0] << shift;
+
+    for (size_t j = m - n + 1; j-- > 0;) {
+        BI_DOUBLE_BASE_TYPE top = (static_cast<BI_DOUBLE_BASE_TYPE>(un[j + n]) << BI_BASE_TYPE_TOTAL_BITS) | un[j + n - 1];
+        BI_DOUBLE_BASE_TYPE qhat = top / vn[n - 1];
+        BI_DOUBLE_BASE_TYPE rhat = top % vn[n - 1];
+        while (qhat >= base || qhat * vn[n - 2] > ((rhat << BI_BASE_TYPE_TOTAL_BITS) | un[j + n - 2])) {
+            --qhat;
+            rhat += vn[n - 1];
+            if (rhat >= base) {
+                break;
+            }
+        }
+
+        /* un[j, j + n] -= qhat * vn */
+        BI_DOUBLE_BASE_TYPE mul_carry = 0;
+        int64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            BI_DOUBLE_BASE_TYPE product = qhat * vn[i] + mul_carry;
+            mul_carry = product >> BI_BASE_TYPE_TOTAL_BITS;
+            int64_t diff = static_cast<int64_t>(un[i + j]) - static_cast<int64_t>(product & BI_BASE_TYPE_MAX) + borrow;
+            un[i + j] = static_cast<BI_BASE_TYPE>(diff);
+            borrow = diff >> BI_BASE_TYPE_TOTAL_BITS;
+        }
+        int64_t diff = static_cast<int64_t>(un[j + n]) - static_cast<int64_t>(mul_carry) + borrow;
+        un[j + n] = static_cast<BI_BASE_TYPE>(diff);
+
+        if (diff < 0) {
+            /* Estimate was one too large, add one divisor back. */
+            --qhat;
+            BI_DOUBLE_BASE_TYPE carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                carry += static_cast<BI_DOUBLE_BASE_TYPE>(un[i + j]) + vn[i];
+                un[i + j] = static_cast<BI_BASE_TYPE>(carry);
+                carry >>= BI_BASE_TYPE_TOTAL_BITS;
+            }
+            un[j + n] = static_cast<BI_BASE_TYPE>(un[j + n] + carry);
+        }
+        q[j] = static_cast<BI_BASE_TYPE>(qhat);
+    }
+
+    /* Denormalize the remainder. */
+    radix_limbs r(n);
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = (un[i] >> shift) | (shift ? un[i + 1] << (BI_BASE_TYPE_TOTAL_BITS - shift) : 0);
+    }
+    radix_normalize(q);
+    radix_normalize(r);
+    quotient.swap(q);
+    remainder.swap(r);
+
+}
+
+const bi::radix_limbs &bi::radix_dec_power(size_t k) {
+
+    /* Computed on first use by repeated squaring and kept for the process lifetime.
+       A deque never moves its elements so references stay valid while it grows. */
+    std::lock_guard<std::mutex> power_lock(dec_power_mutex);
+    if (dec_powers.empty()) {
+        dec_powers.push_back(dec_power_entry{radix_limbs{BI_DEC_BASE_TYPE_RADIX}, {}, {}, 0});
+    }
+    while (dec_powers.size() <= k) {
+        dec_power_entry next_power{{}, {}, {}, 0};
+        radix_multiply(dec_powers.back().power, dec_powers.back().power, next_power.power);
+        dec_powers.push_back(std::move(next_power));
+    }
+    return dec_powers[k].power;
+
+}
+
+void bi::radix_pow10(size_t exponent, radix_limbs &res) {
+
+    /* 10^(exponent % 9) times the cached powers for the set bits of exponent / 9. */
+    BI_BASE_TYPE small_power = 1;
+    for (size_t i = 0; i < exponent % BI_DEC_DIGITS_PER_BASE_TYPE; ++i) {
+        small_power *= 10;
+    }
+    radix_limbs acc{small_power};
+    size_t words = exponent / BI_DEC_DIGITS_PER_BASE_TYPE;
+    for (size_t k = 0; words != 0; ++k, words >>= 1) {
+        if (words & 1) {
+            radix_multiply(acc, radix_dec_power(k), acc);
+        }
+    }
+    res.swap(acc);
+
+}
+
+void bi::radix_combine_dec(const radix_limbs &high, const radix_limbs &low, size_t low_digits, radix_limbs &res) {
+
+    radix_limbs high_scaled;
+    size_t words = low_digits / BI_DEC_DIGITS_PER_BASE_TYPE;
+    if (low_digits % BI_DEC_DIGITS_PER_BASE_TYPE == 0 && words != 0 && (words & (words - 1)) == 0) {
+        size_t k = 0;
+        while ((static_cast<size_t>(1) << k) < words) {
+            ++k;
+        }
+        radix_multiply(high, radix_dec_power(k), high_scaled);
+    } else {
+        radix_limbs power;
+        radix_pow10(low_digits, power);
+        radix_multiply(high, power, high_scaled);
+    }
+
+    high_scaled.resize(std::max(high_scaled.size(), low.size()) + 1, 0);
+    limbs_add_into(high_scaled.data(), low.data(), low.size());
+    radix_normalize(high_scaled);
+    res.swap(high_scaled);
+
+}
+
+void bi::radix_dec_to_limbs(const char *digits, size_t count, radix_limbs &res) {
+
+    if (count <= DEC_DC_THRESHOLD_DIGITS) {
+        dec_to_limbs_word_at_a_time(digits, count, res);
+        return;
+    }
+
+    /* Low part gets the largest 9 * 2^k digits below count. */
+    size_t k = 0;
+    while ((static_cast<size_t>(BI_DEC_DIGITS_PER_BASE_TYPE) << (k + 1)) < count) {
+        ++k;
+    }
+    size_t low_digits = static_cast<size_t>(BI_DEC_DIGITS_PER_BASE_TYPE) << k;
+
+    radix_limbs high, low;
+    radix_dec_to_limbs(digits, count - low_digits, high);
+    radix_dec_to_limbs(digits + count - low_digits, low_digits, low);
+    radix_combine_dec(high, low, low_digits, res);
+
+}
+
+void bi::radix_limbs_to_dec(const radix_limbs &val, const radix_char_sink &sink) {
+
+    limbs_to_dec_dc(val, 0, sink);
+
+}
@@ -0,0 +1,158 @@
+/**
+ *  @file   big_int_stats.cc
+ *  @brief  Per thread operation counters and their aggregation
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <deque>
+#include <mutex>
+
+#include "big_int.hpp"
+
+namespace {
+
+    constexpr size_t BI_STAT_SLOTS = static_cast<size_t>(bi::big_int_stat::BI_STAT_COUNT);
+
+    void stats_to_struct(const uint64_t *counters, bi::big_int_stats &op_stats) {
+
+        op_stats.limb_multiplies            = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_LIMB_MULTIPLIES)];
+        op_stats.divisions                  = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_DIVISIONS)];
+        op_stats.modular_exponentiations    = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_MODULAR_EXPONENTIATIONS)];
+        op_stats.rabin_miller_rounds        = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_RABIN_MILLER_ROUNDS)];
+        op_stats.rejected_candidates        = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_REJECTED_CANDIDATES)];
+        op_stats.expand_calls               = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_EXPAND_CALLS)];
+        op_stats.bytes_allocated            = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_BYTES_ALLOCATED)];
+        op_stats.rsa_keygens                = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_RSA_KEYGENS)];
+        op_stats.rsa_encryptions            = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_RSA_ENCRYPTIONS)];
+        op_stats.rsa_decryptions            = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_RSA_DECRYPTIONS)];
+        op_stats.montgomery_cache_hits      = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_MONTGOMERY_CACHE_HITS)];
+        op_stats.montgomery_cache_misses    = counters[static_cast<size_t>(bi::big_int_stat::BI_STAT_MONTGOMERY_CACHE_MISSES)];
+
+    }
+
+#if BI_STATS
+
+    /*  Counters of one thread, only ever written by that thread. The counts are cumulative,
+        a slot freed by an exiting thread is handed to the next new thread as it is. */
+    struct stats_slot {
+        std::atomic<uint64_t>       counters[BI_STAT_SLOTS];
+        bool                        in_use;
+    };
+
+    struct stats_registry {
+        std::mutex                  registry_mutex;
+        std::deque<stats_slot>      slots;
+        uint64_t                    baseline[BI_STAT_SLOTS];
+    };
+
+    /* Never destroyed, threads may still count while the statics are torn down. */
+    stats_registry& registry() {
+
+        static stats_registry *stats = new stats_registry();
+        return *stats;
+
+    }
+
+    thread_local stats_slot *thread_slot = nullptr;
+
+    struct stats_slot_release {
+        ~stats_slot_release() {
+            std::lock_guard<std::mutex> registry_lock(registry().registry_mutex);
+            thread_slot->in_use = false;
+            thread_slot = nullptr;
+        }
+    };
+
+    stats_slot* acquire_slot() {
+
+        stats_registry &stats = registry();
+        stats_slot *slot = nullptr;
+        {
+            std::lock_guard<std::mutex> registry_lock(stats.registry_mutex);
+            for (auto &free_slot : stats.slots) {
+                if (free_slot.in_use == false) {
+                    slot = &free_slot;
+                    break;
+                }
+            }
+            if (slot == nullptr) {
+                stats.slots.emplace_back();
+                slot = &stats.slots.back();
+                for (auto &counter : slot->counters) {
+                    counter.store(0, std::memory_order_relaxed);
+                }
+            }
+            slot->in_use = true;
+        }
+
+        /* Hands the slot back when the thread exits. */
+        thread_local stats_slot_release release;
+        (void)release;
+        return slot;
+
+    }
+
+    void stats_totals(stats_registry &stats, uint64_t *op_totals) {
+
+        std::fill_n(op_totals, BI_STAT_SLOTS, 0);
+        for (const auto &slot : stats.slots) {
+            for (size_t i = 0; i < BI_STAT_SLOTS; ++i) {
+                op_totals[i] += slot.counters[i].load(std::memory_order_relaxed);
+            }
+        }
+
+    }
+
+#endif  /* BI_STATS */
+
+}
+
+int bi::big_int_stats::big_int_stats_snapshot(big_int_stats &op_stats) {
+
+    uint64_t counters[BI_STAT_SLOTS] = {};
+
+#if BI_STATS
+    stats_registry &stats = registry();
+    std::lock_guard<std::mutex> registry_lock(stats.registry_mutex);
+    stats_totals(stats, counters);
+    for (size_t i = 0; i < BI_STAT_SLOTS; ++i) {
+        counters[i] -= stats.baseline[i];
+    }
+    stats_to_struct(counters, op_stats);
+    return 0;
+#else
+    stats_to_struct(counters, op_stats);
+    return -1;
+#endif
+
+}
+
+void bi::big_int_stats::big_int_stats_reset() {
+
+#if BI_STATS
+    /* Other threads keep adding to their own slots, so instead of zeroing those the
+       current totals become the point snapshots count from. */
+    stats_registry &stats = registry();
+    std::lock_guard<std::mutex> registry_lock(stats.registry_mutex);
+    stats_totals(stats, stats.baseline);
+#endif
+
+}
+
+void bi::big_int_stats::big_int_stats_add(big_int_stat stat, uint64_t count) {
+
+#if BI_STATS
+    if (thread_slot == nullptr) {
+        thread_slot = acquire_slot();
+    }
+    std::atomic<uint64_t> &counter = thread_slot->counters[static_cast<size_t>(stat)];
+    counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+#else
+    (void)stat;
+    (void)count;
+#endif
+
+}
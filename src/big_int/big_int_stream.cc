@@ -0,0 +1,519 @@
+/**
+ *  @file   big_int_stream.cc
+ *  @brief  Streaming text input / output of big ints
+ *
+ *  Hex and binary digits map to limbs directly. Decimal input converts
+ *  fixed size digit chunks and merges equal sized neighbours like a binary
+ *  counter, so every merge is a balanced Karatsuba multiplication by a
+ *  cached power of ten. Decimal output pipes the divide and conquer
+ *  conversion into the write buffer.
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#include "big_int.hpp"
+#include "big_int_hex_codec.hpp"
+#include "big_int_radix.hpp"
+
+namespace {
+
+    /* 9 * 2^12 digits, about 13.6k limbs per chunk value. */
+    constexpr size_t    DEC_CHUNK_DIGITS        = BI_DEC_DIGITS_PER_BASE_TYPE * 4096;
+
+    struct dec_chunk {
+        bi::radix_limbs     value;
+        size_t              digits;
+    };
+
+    bool is_space(int c) {
+
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+
+    }
+
+    int digit_value(int c, int bits_per_digit) {
+
+        if (bits_per_digit == 1) {
+            return (c == '0' || c == '1') ? c - '0' : -1;
+        }
+        BI_BASE_TYPE hex_val = bi::hex_codec_digit_value(static_cast<char>(c));
+        return (hex_val == BI_HEX_INVALID_DIGIT) ? -1 : static_cast<int>(hex_val);
+
+    }
+
+}
+
+bi::big_int_stream_reader::big_int_stream_reader(FILE *file)
+:   _file       {file},
+    _fd         {-1},
+    _buffer_mem {new char[BUFFER_SIZE]},
+    _buffer     {_buffer_mem.get()},
+    _pos        {0},
+    _len        {0},
+    _error      {false} {
+
+    if (file == nullptr) {
+        throw std::invalid_argument("Null FILE");
+    }
+
+}
+
+bi::big_int_stream_reader::big_int_stream_reader(int fd)
+:   _file       {nullptr},
+    _fd         {fd},
+    _buffer_mem {new char[BUFFER_SIZE]},
+    _buffer     {_buffer_mem.get()},
+    _pos        {0},
+    _len        {0},
+    _error      {false} {
+
+    if (fd < 0) {
+        throw std::invalid_argument("Invalid file descriptor");
+    }
+
+}
+
+bi::big_int_stream_reader::big_int_stream_reader(const char *data, size_t size)
+:   _file       {nullptr},
+    _fd         {-1},
+    _buffer_mem {},
+    _buffer     {data},
+    _pos        {0},
+    _len        {size},
+    _error      {false} {
+
+    /* The region itself is the buffer, nothing is ever copied. */
+    if (data == nullptr && size != 0) {
+        throw std::invalid_argument("Null memory region");
+    }
+
+}
+
+bool bi::big_int_stream_reader::_big_int_stream_fill() {
+
+    if (_buffer_mem == nullptr || _error) {
+        return false;
+    }
+
+    char *buffer = _buffer_mem.get();
+    size_t got = 0;
+    if (_file != nullptr) {
+        got = fread(buffer, 1, BUFFER_SIZE, _file);
+        if (got == 0 && ferror(_file)) {
+            _error = true;
+        }
+    } else {
+#if defined(__unix__) || defined(__APPLE__)
+        ssize_t read_res;
+        do {
+            read_res = ::read(_fd, buffer, BUFFER_SIZE);
+        } while (read_res < 0 && errno == EINTR);
+        if (read_res < 0) {
+            _error = true;
+        } else {
+            got = static_cast<size_t>(read_res);
+        }
+#else
+        _error = true;
+#endif
+    }
+
+    _pos = 0;
+    _len = got;
+    return got != 0;
+
+}
+
+int bi::big_int_stream_reader::_big_int_stream_peek() {
+
+    if (_pos == _len && _big_int_stream_fill() == false) {
+        return EOF;
+    }
+    return static_cast<unsigned char>(_buffer[_pos]);
+
+}
+
+bool bi::big_int_stream_reader::big_int_stream_eof() {
+
+    return _big_int_stream_peek() == EOF;
+
+}
+
+int bi::big_int_stream_reader::big_int_stream_read(big_int &op, bi_base base) {
+
+    int c = _big_int_stream_peek();
+    while (c != EOF && is_space(c)) {
+        ++_pos;
+        c = _big_int_stream_peek();
+    }
+
+    bool is_neg = false;
+    if (c == '-') {
+        is_neg = true;
+        ++_pos;
+    }
+
+    int ret_val;
+    bool seen_zero = false;
+    switch (base) {
+        case bi_base::BI_HEX:
+            /* "0x" is taken as a prefix only when a hex digit follows. A '0' that turns out
+               not to start a prefix is a leading zero of the number itself. */
+            if (_big_int_stream_peek() == '0') {
+                ++_pos;
+                c = _big_int_stream_peek();
+                if (c == 'x' || c == 'X') {
+                    ++_pos;
+                    if (digit_value(_big_int_stream_peek(), 4) < 0) {
+                        op.big_int_set_zero();
+                        return -1;
+                    }
+                } else {
+                    seen_zero = true;
+                }
+            }
+            ret_val = _big_int_stream_read_pow2(op, is_neg, 4, seen_zero);
+            break;
+        case bi_base::BI_BIN:
+            ret_val = _big_int_stream_read_pow2(op, is_neg, 1, false);
+            break;
+        case bi_base::BI_DEC:
+            ret_val = _big_int_stream_read_dec(op, is_neg);
+            break;
+        default:
+            throw std::invalid_argument("Invalid base");
+    }
+
+    if (ret_val != 0 || _error) {
+        op.big_int_set_zero();
+        return -1;
+    }
+    return 0;
+
+}
+
+int bi::big_int_stream_reader::_big_int_stream_read_pow2(big_int &op, bool is_neg, int bits_per_digit, bool seen_zero) {
+
+    /* Whole words in reading order (most significant first), then the leftover digits. */
+    const int digits_per_word = BI_BASE_TYPE_TOTAL_BITS / bits_per_digit;
+    std::vector<BI_BASE_TYPE> words;
+    BI_BASE_TYPE partial = 0;
+    int partial_digits = 0;
+    bool seen_digit = seen_zero, seen_non_zero = false;
+
+    for (int c = _big_int_stream_peek(); c != EOF; c = _big_int_stream_peek()) {
+        int val = digit_value(c, bits_per_digit);
+        if (val < 0) {
+            break;
+        }
+        ++_pos;
+        seen_digit = true;
+        if (seen_non_zero == false && val == 0) {
+            continue;
+        }
+        seen_non_zero = true;
+        partial = (partial << bits_per_digit) | static_cast<BI_BASE_TYPE>(val);
+        if (++partial_digits == digits_per_word) {
+            words.push_back(partial);
+            partial = 0;
+            partial_digits = 0;
+        }
+    }
+
+    if (seen_digit == false) {
+        return -1;
+    }
+    if (seen_non_zero == false) {
+        return op.big_int_set_zero();
+    }
+
+    /* value = words << shift | partial, little endian limbs. */
+    std::reverse(words.begin(), words.end());
+    int shift = partial_digits * bits_per_digit;
+    if (shift != 0) {
+        words.push_back(0);
+        for (size_t i = words.size() - 1; i > 0; --i) {
+            words[i] = (words[i] << shift) | (words[i - 1] >> (BI_BASE_TYPE_TOTAL_BITS - shift));
+        }
+        words[0] = (words[0] << shift) | partial;
+    }
+    radix_normalize(words);
+
+    return op.big_int_from_base_type_array(words.data(), static_cast<int>(words.size()), is_neg);
+
+}
+
+int bi::big_int_stream_reader::_big_int_stream_read_dec(big_int &op, bool is_neg) {
+
+    /* Stack of converted chunks, digit counts strictly decreasing towards the top
+       except for the last partial chunk. */
+    std::vector<dec_chunk> chunks;
+    std::vector<char> chunk_digits;
+    chunk_digits.reserve(DEC_CHUNK_DIGITS);
+    bool seen_digit = false;
+
+    auto push_chunk = [&chunks, &chunk_digits]() {
+        dec_chunk chunk;
+        radix_dec_to_limbs(chunk_digits.data(), chunk_digits.size(), chunk.value);
+        chunk.digits = chunk_digits.size();
+        chunk_digits.clear();
+        chunks.push_back(std::move(chunk));
+        while (chunks.size() > 1 && chunks[chunks.size() - 2].digits == chunks.back().digits) {
+            dec_chunk &high = chunks[chunks.size() - 2];
+            radix_combine_dec(high.value, chunks.back().value, chunks.back().digits, high.value);
+            high.digits *= 2;
+            chunks.pop_back();
+        }
+    };
+
+    for (;;) {
+        if (_pos == _len && _big_int_stream_fill() == false) {
+            break;
+        }
+        /* Scan the buffered run of digits in one go. */
+        size_t run_end = _pos;
+        while (run_end < _len && _buffer[run_end] >= '0' && _buffer[run_end] <= '9') {
+            ++run_end;
+        }
+        while (_pos < run_end) {
+            size_t take = std::min(run_end - _pos, DEC_CHUNK_DIGITS - chunk_digits.size());
+            chunk_digits.insert(chunk_digits.end(), _buffer + _pos, _buffer + _pos + take);
+            _pos += take;
+            seen_digit = true;
+            if (chunk_digits.size() == DEC_CHUNK_DIGITS) {
+                push_chunk();
+            }
+        }
+        if (run_end < _len) {
+            break;
+        }
+    }
+
+    if (seen_digit == false) {
+        return -1;
+    }
+    if (chunk_digits.empty() == false) {
+        push_chunk();
+    }
+
+    /* Fold the remaining chunks from the least significant end. */
+    radix_limbs acc = std::move(chunks.back().value);
+    size_t acc_digits = chunks.back().digits;
+    chunks.pop_back();
+    while (chunks.empty() == false) {
+        radix_combine_dec(chunks.back().value, acc, acc_digits, acc);
+        acc_digits += chunks.back().digits;
+        chunks.pop_back();
+    }
+
+    if (acc.empty()) {
+        return op.big_int_set_zero();
+    }
+    return op.big_int_from_base_type_array(acc.data(), static_cast<int>(acc.size()), is_neg);
+
+}
+
+bi::big_int_stream_writer::big_int_stream_writer(FILE *file)
+:   _file           {file},
+    _fd             {-1},
+    _region         {nullptr},
+    _region_size    {0},
+    _buffer         {new char[BUFFER_SIZE]},
+    _len            {0},
+    _bytes_written  {0},
+    _error          {false} {
+
+    if (file == nullptr) {
+        throw std::invalid_argument("Null FILE");
+    }
+
+}
+
+bi::big_int_stream_writer::big_int_stream_writer(int fd)
+:   _file           {nullptr},
+    _fd             {fd},
+    _region         {nullptr},
+    _region_size    {0},
+    _buffer         {new char[BUFFER_SIZE]},
+    _len            {0},
+    _bytes_written  {0},
+    _error          {false} {
+
+    if (fd < 0) {
+        throw std::invalid_argument("Invalid file descriptor");
+    }
+
+}
+
+bi::big_int_stream_writer::big_int_stream_writer(char *data, size_t size)
+:   _file           {nullptr},
+    _fd             {-1},
+    _region         {data},
+    _region_size    {size},
+    _buffer         {},
+    _len            {0},
+    _bytes_written  {0},
+    _error          {false} {
+
+    /* Written straight into the region, no buffer. */
+    if (data == nullptr && size != 0) {
+        throw std::invalid_argument("Null memory region");
+    }
+
+}
+
+bi::big_int_stream_writer::~big_int_stream_writer() {
+
+    big_int_stream_flush();
+
+}
+
+int bi::big_int_stream_writer::big_int_stream_flush() {
+
+    if (_error) {
+        return -1;
+    }
+
+    const char *src = _buffer.get();
+    while (_len > 0) {
+        size_t put = 0;
+        if (_file != nullptr) {
+            put = fwrite(src, 1, _len, _file);
+            if (put == 0) {
+                _error = true;
+            }
+        } else {
+#if defined(__unix__) || defined(__APPLE__)
+            ssize_t write_res = ::write(_fd, src, _len);
+            if (write_res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (write_res <= 0) {
+                _error = true;
+            } else {
+                put = static_cast<size_t>(write_res);
+            }
+#else
+            _error = true;
+#endif
+        }
+        if (_error) {
+            return -1;
+        }
+        src += put;
+        _len -= put;
+        _bytes_written += put;
+    }
+
+    if (_file != nullptr && fflush(_file) != 0) {
+        _error = true;
+        return -1;
+    }
+    return 0;
+
+}
+
+int bi::big_int_stream_writer::big_int_stream_write_chars(const char *chars, size_t count) {
+
+    if (_error) {
+        return -1;
+    }
+
+    if (_buffer == nullptr) {
+        if (_region_size - _bytes_written < count) {
+            _error = true;
+            return -1;
+        }
+        memcpy(_region + _bytes_written, chars, count);
+        _bytes_written += count;
+        return 0;
+    }
+
+    while (count > 0) {
+        if (_len == BUFFER_SIZE && big_int_stream_flush() != 0) {
+            return -1;
+        }
+        size_t take = std::min(count, BUFFER_SIZE - _len);
+        memcpy(_buffer.get() + _len, chars, take);
+        _len += take;
+        chars += take;
+        count -= take;
+    }
+    return 0;
+
+}
+
+int bi::big_int_stream_writer::big_int_stream_write(const big_int &op, bi_base base) {
+
+    big_int_view op_view(op);
+    const BI_BASE_TYPE *data = op_view.big_int_view_data();
+    int count = op_view.big_int_view_count();
+    bool is_zero = (count == 1 && data[0] == 0);
+
+    int ret_val = 0;
+    if (op_view.big_int_view_is_negetive() && is_zero == false) {
+        ret_val += big_int_stream_write_chars("-", 1);
+    }
+
+    switch (base) {
+        case bi_base::BI_HEX: {
+            char word_chars[BI_HEX_CHARS_PER_BASE_TYPE];
+            size_t top_chars = hex_codec_format_bi_base_type_trimmed(data[count - 1], word_chars);
+            ret_val += big_int_stream_write_chars(word_chars, top_chars);
+            for (int i = count - 2; i >= 0 && ret_val == 0; --i) {
+                hex_codec_format_bi_base_type(data[i], word_chars);
+                ret_val += big_int_stream_write_chars(word_chars, BI_HEX_CHARS_PER_BASE_TYPE);
+            }
+            break;
+        }
+        case bi_base::BI_BIN: {
+            char word_chars[BI_BASE_TYPE_TOTAL_BITS];
+            for (int i = count - 1; i >= 0 && ret_val == 0; --i) {
+                for (int b = 0; b < BI_BASE_TYPE_TOTAL_BITS; ++b) {
+                    word_chars[b] = ((data[i] >> (BI_BASE_TYPE_TOTAL_BITS - 1 - b)) & 1) ? '1' : '0';
+                }
+                size_t skip = 0;
+                if (i == count - 1) {
+                    while (skip + 1 < BI_BASE_TYPE_TOTAL_BITS && word_chars[skip] == '0') {
+                        ++skip;
+                    }
+                }
+                ret_val += big_int_stream_write_chars(word_chars + skip, BI_BASE_TYPE_TOTAL_BITS - skip);
+            }
+            break;
+        }
+        case bi_base::BI_DEC: {
+            radix_limbs limbs(data, data + count);
+            radix_normalize(limbs);
+            radix_limbs_to_dec(limbs, [this, &ret_val](const char *chars, size_t chars_count) {
+                if (ret_val == 0) {
+                    ret_val += big_int_stream_write_chars(chars, chars_count);
+                }
+            });
+            break;
+        }
+        default:
+            throw std::invalid_argument("Invalid base");
+    }
+
+    return (ret_val == 0) ? 0 : -1;
+
+}
+
+size_t bi::big_int_stream_writer::big_int_stream_bytes_written() const {
+
+    return _bytes_written;
+
+}
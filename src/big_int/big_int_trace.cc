@@ -0,0 +1,185 @@
+/**
+ *  @file   big_int_trace.cc
+ *  @brief  Chrome trace event export of the prime search and key generation
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <inttypes.h>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+#include "big_int.hpp"
+
+namespace bi {
+
+    /* Shared by the session and the spans still running when it ends, so a late span finds
+       the session closed instead of a dangling sink. */
+    class big_int_trace_state {
+
+        public:
+
+        std::mutex                                  sink_mutex;
+        big_int_trace_sink                          sink;
+        std::chrono::steady_clock::time_point       origin;
+        bool                                        first_event;
+        bool                                        closed;
+
+    };
+
+}
+
+namespace {
+
+    constexpr char TRACE_HEADER[] = "{\"traceEvents\":[\n";
+    constexpr char TRACE_FOOTER[] = "\n],\"displayTimeUnit\":\"ms\"}\n";
+    constexpr size_t TRACE_EVENT_MAX_CHARS = 512;
+
+    std::mutex                                      session_mutex;
+    std::atomic<bool>                               trace_active{false};
+    std::shared_ptr<bi::big_int_trace_state>        active_state;
+
+    /* Small per thread ids, trace viewers draw one lane per id. */
+    uint32_t trace_thread_id() {
+
+        static std::atomic<uint32_t> next_id{1};
+        thread_local uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+        return id;
+
+    }
+
+    double trace_micros(const bi::big_int_trace_state &state, std::chrono::steady_clock::time_point tp) {
+
+        return std::chrono::duration<double, std::micro>(tp - state.origin).count();
+
+    }
+
+    /* Appends the args object and the closing brace, event holds len chars so far. */
+    int trace_finish_event(char *event, int len, const char *const *keys, const int64_t *values, int count) {
+
+        len += snprintf(event + len, TRACE_EVENT_MAX_CHARS - static_cast<size_t>(len), ",\"args\":{");
+        for (int i = 0; i < count && len < static_cast<int>(TRACE_EVENT_MAX_CHARS); ++i) {
+            len += snprintf(event + len, TRACE_EVENT_MAX_CHARS - static_cast<size_t>(len), "%s\"%s\":%" PRId64, \
+                (i == 0) ? "" : ",", keys[i], values[i]);
+        }
+        if (len < static_cast<int>(TRACE_EVENT_MAX_CHARS)) {
+            len += snprintf(event + len, TRACE_EVENT_MAX_CHARS - static_cast<size_t>(len), "}}");
+        }
+        return std::min(len, static_cast<int>(TRACE_EVENT_MAX_CHARS) - 1);
+
+    }
+
+    void trace_write_event(bi::big_int_trace_state &state, const char *event, int len) {
+
+        std::lock_guard<std::mutex> sink_lock(state.sink_mutex);
+        if (state.closed) {
+            return;
+        }
+        if (state.first_event == false) {
+            state.sink(",\n", 2);
+        }
+        state.first_event = false;
+        state.sink(event, static_cast<size_t>(len));
+
+    }
+
+}
+
+bi::big_int_trace_session::big_int_trace_session(big_int_trace_sink sink) {
+
+    std::lock_guard<std::mutex> session_lock(session_mutex);
+    if (std::atomic_load(&active_state) != nullptr) {
+        throw std::logic_error("A trace session is already active");
+    }
+
+    _state = std::make_shared<big_int_trace_state>();
+    _state->sink = std::move(sink);
+    _state->origin = std::chrono::steady_clock::now();
+    _state->first_event = true;
+    _state->closed = false;
+    _state->sink(TRACE_HEADER, sizeof(TRACE_HEADER) - 1);
+
+    std::atomic_store(&active_state, _state);
+    trace_active.store(true, std::memory_order_release);
+
+}
+
+bi::big_int_trace_session::~big_int_trace_session() {
+
+    {
+        std::lock_guard<std::mutex> session_lock(session_mutex);
+        trace_active.store(false, std::memory_order_release);
+        std::atomic_store(&active_state, std::shared_ptr<big_int_trace_state>());
+    }
+
+    std::lock_guard<std::mutex> sink_lock(_state->sink_mutex);
+    _state->sink(TRACE_FOOTER, sizeof(TRACE_FOOTER) - 1);
+    _state->closed = true;
+
+}
+
+bool bi::big_int_trace_session::big_int_trace_enabled() {
+
+    return trace_active.load(std::memory_order_relaxed);
+
+}
+
+void bi::big_int_trace_session::big_int_trace_instant(const char *name, const char *category, const char *key, int64_t value) {
+
+    if (trace_active.load(std::memory_order_relaxed) == false) {
+        return;
+    }
+    std::shared_ptr<big_int_trace_state> state = std::atomic_load(&active_state);
+    if (state == nullptr) {
+        return;
+    }
+
+    char event[TRACE_EVENT_MAX_CHARS];
+    int len = snprintf(event, sizeof(event), "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%" PRIu32, \
+        name, category, trace_micros(*state, std::chrono::steady_clock::now()), trace_thread_id());
+    len = trace_finish_event(event, len, &key, &value, (key != nullptr) ? 1 : 0);
+    trace_write_event(*state, event, len);
+
+}
+
+bi::big_int_trace_span::big_int_trace_span(const char *name, const char *category)
+:   _name       {name},
+    _category   {category},
+    _arg_count  {0} {
+
+    if (trace_active.load(std::memory_order_relaxed)) {
+        _state = std::atomic_load(&active_state);
+        _start = std::chrono::steady_clock::now();
+    }
+
+}
+
+bi::big_int_trace_span::~big_int_trace_span() {
+
+    if (_state == nullptr) {
+        return;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    char event[TRACE_EVENT_MAX_CHARS];
+    int len = snprintf(event, sizeof(event), "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%" PRIu32, \
+        _name, _category, trace_micros(*_state, _start), std::chrono::duration<double, std::micro>(end - _start).count(), \
+        trace_thread_id());
+    len = trace_finish_event(event, len, _arg_keys, _arg_values, _arg_count);
+    trace_write_event(*_state, event, len);
+
+}
+
+void bi::big_int_trace_span::big_int_trace_span_arg(const char *key, int64_t value) {
+
+    if (_state == nullptr || _arg_count >= BI_TRACE_MAX_ARGS) {
+        return;
+    }
+    _arg_keys[_arg_count] = key;
+    _arg_values[_arg_count] = value;
+    ++_arg_count;
+
+}
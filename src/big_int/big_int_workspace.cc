@@ -0,0 +1,63 @@
+/**
+ *  @file   big_int_workspace.cc
+ *  @brief  Reusable scratch integers for the division, exponentiation, gcd and inverse routines
+ *
+ *  @author         Tony Josi   https://tonyjosi97.github.io/profile/
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include "big_int.hpp"
+
+bi::big_int_workspace::big_int_workspace()
+:   _used           {0},
+    _reserve_limbs  {0} {
+
+}
+
+bi::big_int_workspace::big_int_workspace(int reserve_bits)
+:   _used           {0},
+    _reserve_limbs  {0} {
+
+    if (reserve_bits > 0) {
+        /* Products are twice the operand size, plus the carry limb. */
+        _reserve_limbs = 2 * ((reserve_bits + BI_BASE_TYPE_TOTAL_BITS - 1) / BI_BASE_TYPE_TOTAL_BITS) + 1;
+    }
+
+}
+
+bi::big_int_workspace::~big_int_workspace() = default;
+
+size_t bi::big_int_workspace::big_int_workspace_size() const {
+
+    return _pool.size();
+
+}
+
+bi::big_int_workspace_frame::big_int_workspace_frame(big_int_workspace &workspace)
+:   _workspace  {workspace},
+    _start      {workspace._used} {
+
+}
+
+bi::big_int_workspace_frame::~big_int_workspace_frame() {
+
+    _workspace._used = _start;
+
+}
+
+bi::big_int& bi::big_int_workspace_frame::big_int_workspace_frame_get() {
+
+    if (_workspace._used == _workspace._pool.size()) {
+        _workspace._pool.push_back(std::unique_ptr<big_int>(new big_int));
+        big_int &fresh = *_workspace._pool.back();
+        if (_workspace._reserve_limbs >= fresh._total_data) {
+            fresh._big_int_expand(_workspace._reserve_limbs - fresh._total_data + 1);
+        }
+    }
+
+    big_int &scratch = *_workspace._pool[_workspace._used++];
+    scratch.big_int_set_zero();
+    return scratch;
+
+}
@@ -10,8 +10,15 @@
  */
 
 #include <stdint.h>
+#include <charconv>
 #include <string>
-#include <random>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <stddef.h>
+#include <stdio.h>
 
 #pragma once
 
@@ -33,6 +40,18 @@
 
 #define         DEFAULT_MEM_ALLOC_BYTES                     (128)
 
+/* Independent exponentiations interleaved by the multi buffer Montgomery kernel. */
+#define         BI_MONTGOMERY_LANES                         (4)
+
+/* Return codes of the cancellable APIs, other failures keep returning -1. */
+#define         BI_STATUS_CANCELLED                         (-2)
+#define         BI_STATUS_TIMED_OUT                         (-3)
+
+/* Operation counters, set by the ENABLE_BI_STATS CMake option. */
+#ifndef BI_STATS
+    #define     BI_STATS                                    (0)
+#endif
+
 namespace bi {
 
     enum class bi_base {
@@ -43,18 +62,294 @@ namespace bi {
     
     };
 
+    enum class bi_endian {
+
+        BI_BIG_ENDIAN,
+        BI_LITTLE_ENDIAN
+
+    };
+
+    class big_int_chacha20_rng;
+
+    /*  Source of the random limbs used for prime candidates and Miller-Rabin witnesses.
+
+        split() returns an independent generator for a numbered sub stream, the prime searches
+        hand one to every thread, or to every candidate when the source is deterministic.
+        Deterministic sources derive the sub stream from their own seed, so a fixed seed replays
+        the same candidates and finds the same prime at any thread count. split() may be called
+        from several threads at once, fill() only from one. */
+    class big_int_random_source {
+
+        public:
+
+        virtual ~big_int_random_source() = default;
+
+        virtual void                                        fill(BI_BASE_TYPE *data, size_t count) = 0;
+        virtual std::unique_ptr<big_int_random_source>      split(uint64_t stream_id) const = 0;
+        virtual bool                                        is_deterministic() const = 0;
+
+    };
+
+    /* Default source, the calling thread's ChaCha20 generator seeded from the OS (getrandom()). */
+    class big_int_system_random_source : public big_int_random_source {
+
+        public:
+
+        void                                                fill(BI_BASE_TYPE *data, size_t count) override;
+        std::unique_ptr<big_int_random_source>              split(uint64_t stream_id) const override;
+        bool                                                is_deterministic() const override;
+
+        static big_int_system_random_source                 &instance();
+
+    };
+
+    /* Deterministic ChaCha20 DRBG keyed by a fixed seed, for reproducible keygen benchmarks. 
+       Never use it for real keys. */
+    class big_int_seeded_drbg : public big_int_random_source {
+
+        public:
+
+        explicit big_int_seeded_drbg(uint64_t seed);
+        ~big_int_seeded_drbg() override;
+
+        void                                                fill(BI_BASE_TYPE *data, size_t count) override;
+        std::unique_ptr<big_int_random_source>              split(uint64_t stream_id) const override;
+        bool                                                is_deterministic() const override;
+
+        private:
+
+        std::unique_ptr<big_int_chacha20_rng>               _rng;
+
+    };
+
+    /*  Cancellation token for long running operations. 
+        
+        A token is cancelled explicitly with cancel(), when its deadline passes or when
+        its parent token is cancelled. Install it on a thread with big_int_cancel_scope
+        and big_int_div / big_int_fast_modular_exponentiation (and everything built on them)
+        poll it once per quotient digit / exponent bit, returning -1 once cancelled. */
+    class big_int_cancel_token {
+
+        public:
+
+        big_int_cancel_token();
+        explicit big_int_cancel_token(const big_int_cancel_token *parent);
+        explicit big_int_cancel_token(std::chrono::steady_clock::time_point deadline, const big_int_cancel_token *parent = nullptr);
+
+        big_int_cancel_token(const big_int_cancel_token &) = delete;
+        big_int_cancel_token& operator=(const big_int_cancel_token &) = delete;
+
+        void            cancel();
+        bool            is_cancelled() const;
+        bool            has_timed_out() const;
+
+        private:
+
+        mutable std::atomic<bool>                   _cancelled;
+        mutable std::atomic<bool>                   _timed_out;
+        bool                                        _has_deadline;
+        std::chrono::steady_clock::time_point       _deadline;
+        const big_int_cancel_token                  *_parent;
+
+    };
+
+    /* RAII helper making a token the one polled by big_int operations on the calling thread. */
+    class big_int_cancel_scope {
+
+        public:
+
+        explicit big_int_cancel_scope(const big_int_cancel_token &token);
+        ~big_int_cancel_scope();
+
+        big_int_cancel_scope(const big_int_cancel_scope &) = delete;
+        big_int_cancel_scope& operator=(const big_int_cancel_scope &) = delete;
+
+        /* True if the token installed on this thread (if any) got cancelled. */
+        static bool     cancellation_requested();
+
+        private:
+
+        const big_int_cancel_token                  *_prev_token;
+
+    };
+
+    enum class big_int_stat {
+
+        BI_STAT_LIMB_MULTIPLIES,
+        BI_STAT_DIVISIONS,
+        BI_STAT_MODULAR_EXPONENTIATIONS,
+        BI_STAT_RABIN_MILLER_ROUNDS,
+        BI_STAT_REJECTED_CANDIDATES,
+        BI_STAT_EXPAND_CALLS,
+        BI_STAT_BYTES_ALLOCATED,
+        BI_STAT_RSA_KEYGENS,
+        BI_STAT_RSA_ENCRYPTIONS,
+        BI_STAT_RSA_DECRYPTIONS,
+        BI_STAT_MONTGOMERY_CACHE_HITS,
+        BI_STAT_MONTGOMERY_CACHE_MISSES,
+        BI_STAT_COUNT
+
+    };
+
+    /*  Operation counters of big_int and rsa, compiled in with the ENABLE_BI_STATS CMake
+        option (BI_STATS). Each thread counts into its own slots with plain relaxed stores,
+        a snapshot adds up the slots of every thread, running or exited. Built without
+        BI_STATS, _BI_STAT_ADD expands to nothing and a snapshot is all zeroes. */
+    struct big_int_stats {
+
+        uint64_t        limb_multiplies;            /* 32 x 32 bit word products */
+        uint64_t        divisions;                  /* big_int_div calls, big_int_modulus included */
+        uint64_t        modular_exponentiations;    /* generic, Montgomery and each lane of the multi buffer one */
+        uint64_t        rabin_miller_rounds;
+        uint64_t        rejected_candidates;        /* prime candidates failing trial division or a Rabin Miller round */
+        uint64_t        expand_calls;               /* _big_int_expand */
+        uint64_t        bytes_allocated;            /* big_int limb arrays */
+        uint64_t        rsa_keygens;
+        uint64_t        rsa_encryptions;
+        uint64_t        rsa_decryptions;
+        uint64_t        montgomery_cache_hits;      /* big_int_montgomery_cache lookups */
+        uint64_t        montgomery_cache_misses;
+
+        /* Totals of all threads since the last reset, returns -1 (all zeroes) without BI_STATS. */
+        static int      big_int_stats_snapshot(big_int_stats &op_stats);
+        /* Counts from zero again, threads counting meanwhile are not disturbed. */
+        static void     big_int_stats_reset();
+        static void     big_int_stats_add(big_int_stat stat, uint64_t count);
+
+    };
+
+#if BI_STATS
+
+    #define         _BI_STAT_ADD(_STAT, _COUNT)     \
+        bi::big_int_stats::big_int_stats_add(bi::big_int_stat::_STAT, _COUNT)
+
+#else   /* BI_STATS */
+
+    #define         _BI_STAT_ADD(_STAT, _COUNT)     do {    \
+        /* No stats */                                      \
+        } while(0)
+
+#endif  /* BI_STATS */
+
+    /* Receives the trace JSON text piece by piece, see big_int_trace_session. */
+    typedef std::function<void(const char *data, size_t size)>   big_int_trace_sink;
+
+    class big_int_trace_state;
+
+    /*  Chrome trace event export (chrome://tracing, Perfetto) of key generation.
+
+        While a session is alive the prime searches and rsa key generation record timestamped
+        spans, candidate generation, sieve rejects (with the small prime), every Rabin Miller
+        round, the winning candidate, thread joins, the modular inverse and the CRT precompute,
+        each on the thread it ran on. The sink gets a single {"traceEvents": [...]} document,
+        the header on construction, one event per completed span and the footer when the
+        session is destroyed; calls into it are serialized.
+
+        Only one session can be active, a second one throws std::logic_error. Without a session
+        a span costs one relaxed atomic load. */
+    class big_int_trace_session {
+
+        public:
+
+        explicit big_int_trace_session(big_int_trace_sink sink);
+        ~big_int_trace_session();
+
+        big_int_trace_session(const big_int_trace_session &) = delete;
+        big_int_trace_session& operator=(const big_int_trace_session &) = delete;
+
+        static bool     big_int_trace_enabled();
+        /* Zero duration event, name / category / key have to be string literals (written unescaped). */
+        static void     big_int_trace_instant(const char *name, const char *category, const char *key = nullptr, int64_t value = 0);
+
+        private:
+
+        std::shared_ptr<big_int_trace_state>        _state;
+
+    };
+
+    /* RAII span, recorded as one complete event from construction to destruction. */
+    class big_int_trace_span {
+
+        public:
+
+        /* name and category have to be string literals (written unescaped). */
+        big_int_trace_span(const char *name, const char *category);
+        ~big_int_trace_span();
+
+        big_int_trace_span(const big_int_trace_span &) = delete;
+        big_int_trace_span& operator=(const big_int_trace_span &) = delete;
+
+        /* Integer argument shown with the event, at most BI_TRACE_MAX_ARGS are kept. */
+        void            big_int_trace_span_arg(const char *key, int64_t value);
+
+        static constexpr int    BI_TRACE_MAX_ARGS   = 4;
+
+        private:
+
+        std::shared_ptr<big_int_trace_state>        _state;
+        const char                                  *_name;
+        const char                                  *_category;
+        std::chrono::steady_clock::time_point       _start;
+        const char                                  *_arg_keys[BI_TRACE_MAX_ARGS];
+        int64_t                                     _arg_values[BI_TRACE_MAX_ARGS];
+        int                                         _arg_count;
+
+    };
+
+    class big_int_montgomery_ctx;
+    class big_int_workspace;
+    class big_int;
+
+    /*  Read only, non owning view of a number held in someone else's limb array 
+        (least significant limb first), e.g. a network buffer or a mapped key file.
+        
+        The const operand positions of compare, multiply, division and modular exponentiation
+        accept a view directly, so the limbs are used in place without being copied. The 
+        viewed memory has to outlive the call. */
+    class big_int_view {
+
+        public:
+
+        /* Throws std::invalid_argument if count is negetive or data is null with a non zero count. */
+        big_int_view(const BI_BASE_TYPE *data, int count, bool is_neg = false);
+        big_int_view(const big_int &src);
+
+        const BI_BASE_TYPE*     big_int_view_data() const;
+        int                     big_int_view_count() const;
+        bool                    big_int_view_is_negetive() const;
+
+        private:
+
+        const BI_BASE_TYPE      *_data;
+        int                     _count;
+        bool                    _neg;
+
+    };
+
+    /*  Const members never write the object, so any number of threads can read one big_int
+        (e.g. a shared modulus or exponent) while each writes only its own results. */
     class big_int {
 
+        friend class big_int_montgomery_ctx;
+        friend class big_int_montgomery_cache;
+        friend class big_int_view;
+        friend class big_int_workspace_frame;
+
         private:
 
         BI_BASE_TYPE    *_data;
         int             _total_data;
         int             _top;
         bool            _neg;
+        bool            _borrowed;          /* _data belongs to a big_int_view, never written or freed. */
+
+        struct borrow_tag {};
+        big_int(const big_int_view &view, borrow_tag);
 
         int             _big_int_expand(int req);
-        int             _big_int_from_string(const std::string &str_data);
-        std::string     _big_int_to_string();
+        int             _big_int_assign(const big_int &src);
+        int             _big_int_signed_add(const big_int &b, bool b_neg, big_int &res) const;
+        int             _big_int_multiply(const big_int &b, big_int &res, big_int &scratch) const;
         BI_BASE_TYPE    _big_int_sub_base_type(BI_BASE_TYPE *data_ptr, int min, big_int &res_ptr) const;
         void            _big_int_swap(big_int &src);
         int             _big_int_compare_bi_base_type_n_top(const big_int &other) const;
@@ -63,14 +358,24 @@ namespace bi {
         int             _big_int_right_shift_below_32bits(int bits);
         int             _big_int_remove_preceding_zeroes();
         int             _big_int_get_num_of_hex_chars() const;
-        int             _big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder);
+        int             _big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder) const;
+        int             _big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder, \
+            big_int &scratch) const;
         int             _big_int_push_back_hex_chars(const BI_BASE_TYPE &hex_char);
         int             _big_int_get_hex_char_from_lsb(int hex_indx_from_lsb, BI_BASE_TYPE &hex_char) const;
-        int             _big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result);
+        int             _big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result, \
+            big_int_workspace &workspace) const;
         int             _big_int_fast_divide_by_two(BI_BASE_TYPE &remainder);
-        int             _big_int_generate_random_unsigned(int bits, std::mt19937 &mt_arg, std::uniform_int_distribution<BI_BASE_TYPE> &uni_dist);
-        int             _big_int_get_random_unsigned_between(std::mt19937 &mt_arg, std::uniform_int_distribution<BI_BASE_TYPE> &uni_dist, \
-            std::uniform_int_distribution<int> &uni_dist_rand_bits, const big_int &low, const big_int &high);
+        int             _big_int_generate_random_unsigned(int bits, big_int_random_source &rng);
+        int             _big_int_get_random_unsigned_between(big_int_random_source &rng, const big_int &low, const big_int &high);
+        int             _big_int_rabin_miller_decompose(big_int &op_d, int &op_s) const;
+        int             _big_int_rabin_miller_square_chain(big_int &x, int s, bool &op_probable_prime, big_int_workspace &workspace) const;
+        /* cache_contexts false builds throwaway contexts for one-shot moduli such as prime candidates. */
+        static int      _big_int_multi_modular_exponentiation(const big_int *bases, const big_int *exponents, \
+            const big_int *moduli, big_int *results, size_t count, bool cache_contexts);
+        static int      _big_int_rabin_miller_test_multi(const big_int *candidates, size_t count, int reqd_rabin_miller_iterations, \
+            big_int_random_source *const *rngs, bool *op_probable_prime);
+        int             _big_int_rabin_miller_test(int reqd_rabin_miller_iterations, big_int_random_source &rng, bool &op_probable_prime) const;
 
         
         
@@ -84,48 +389,101 @@ namespace bi {
         ~big_int();
 
         int             big_int_from_string(const std::string &str_num, bi_base target_base = bi_base::BI_HEX);
+        /*  Hex text straight from / into caller buffers, following std::from_chars / std::to_chars.
+            from: optional '-' and "0x" / "0X" prefix then hex digits (either case), ptr stops at the
+            first non hex character, ec is std::errc::invalid_argument if there are no digits (the
+            value is left unchanged). to: upper case without leading zeroes and no terminating null,
+            ec is std::errc::value_too_large if the buffer is too small. */
+        std::from_chars_result  big_int_from_hex_chars(const char *first, const char *last);
+        std::to_chars_result    big_int_to_hex_chars(char *first, char *last) const;
+        /*  Same conventions for decimal (optional '-' then '0' - '9') and binary (optional '-' then
+            '0' / '1') text. Decimal conversion is divide and conquer over cached powers of 10^9,
+            binary maps bits to limbs directly. */
+        std::from_chars_result  big_int_from_dec_chars(const char *first, const char *last);
+        std::to_chars_result    big_int_to_dec_chars(char *first, char *last) const;
+        std::from_chars_result  big_int_from_bin_chars(const char *first, const char *last);
+        std::to_chars_result    big_int_to_bin_chars(char *first, char *last) const;
         int             big_int_from_base_type(const BI_BASE_TYPE &bt_val, const bool is_neg);
-        std::string     big_int_to_string(bi_base target_base = bi_base::BI_HEX);
+        /* Raw limb import / export, least significant limb first. */
+        int             big_int_from_base_type_array(const BI_BASE_TYPE *data, int count, const bool is_neg);
+        int             big_int_to_base_type_array(BI_BASE_TYPE *op_data, int op_data_count) const;
+        int             big_int_get_num_of_base_type() const;
+        /* Unsigned byte import / export straight to / from the limbs, no intermediate strings. 
+           to_bytes writes exactly op_data_size bytes, zero padded, and returns -1 if the number
+           is negetive or does not fit. */
+        int             big_int_from_bytes(const uint8_t *data, size_t data_size, bi_endian endian = bi_endian::BI_BIG_ENDIAN);
+        int             big_int_to_bytes(uint8_t *op_data, size_t op_data_size, bi_endian endian = bi_endian::BI_BIG_ENDIAN) const;
+        size_t          big_int_get_num_of_bytes() const;
+        std::string     big_int_to_string(bi_base target_base = bi_base::BI_HEX) const;
         int             big_int_compare(const big_int &other) const;
         int             big_int_unsigned_compare(const big_int &other) const;
+        int             big_int_compare(const big_int_view &other) const;
+        int             big_int_unsigned_compare(const big_int_view &other) const;
         int             big_int_unsigned_add(const big_int &b);
-        int             big_int_unsigned_add(const big_int &b, big_int &res);
+        int             big_int_unsigned_add(const big_int &b, big_int &res) const;
         int             big_int_signed_add(const big_int &b);
-        int             big_int_signed_add(const big_int &b, big_int &res);
+        int             big_int_signed_add(const big_int &b, big_int &res) const;
         int             big_int_set_negetive(bool set_unset);
         bool            big_int_is_negetive() const;
         bool            big_int_is_zero() const;
         int             big_int_set_zero();
         int             big_int_clear();
         int             big_int_signed_sub(const big_int &b);
-        int             big_int_signed_sub(const big_int &b, big_int &res);
-        int             big_int_multiply(const big_int &b, big_int &res);
+        int             big_int_signed_sub(const big_int &b, big_int &res) const;
+        int             big_int_multiply(const big_int &b, big_int &res) const;
+        int             big_int_multiply(const big_int_view &b, big_int &res) const;
         int             big_int_unsigned_multiply_base_type(const BI_BASE_TYPE &b, big_int &res) const;
         int             big_int_get_num_of_hex_chars() const;
         int             big_int_get_num_of_bits() const;
-        int             big_int_div(const big_int &divisor, big_int &quotient, big_int &remainder);
-        int             big_int_power_base_type(const BI_BASE_TYPE &exponent, big_int &result);
-        int             big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result);
-        int             big_int_modulus(const big_int &modulus, big_int &result);
-        int             big_int_gcd_euclidean_algorithm(const big_int &b, big_int &op_gcd);
-        int             big_int_modular_inverse_extended_euclidean_algorithm(const big_int &modulus, big_int &inverse);
+        int             big_int_div(const big_int &divisor, big_int &quotient, big_int &remainder) const;
+        int             big_int_div(const big_int_view &divisor, big_int &quotient, big_int &remainder) const;
+        int             big_int_power_base_type(const BI_BASE_TYPE &exponent, big_int &result) const;
+        int             big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result) const;
+        int             big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result, \
+            const big_int_cancel_token &cancel_token) const;
+        int             big_int_fast_modular_exponentiation(const big_int_view &exponent, const big_int_view &modulus, big_int &result) const;
+        /* Batch of independent exponentiations, results[i] = bases[i] ^ exponents[i] mod moduli[i].
+           Odd moduli go through the multi buffer Montgomery kernel, the rest one by one. */
+        static int      big_int_multi_modular_exponentiation(const big_int *bases, const big_int *exponents, \
+            const big_int *moduli, big_int *results, size_t count);
+        int             big_int_modulus(const big_int &modulus, big_int &result) const;
+        int             big_int_modulus(const big_int_view &modulus, big_int &result) const;
+        int             big_int_gcd_euclidean_algorithm(const big_int &b, big_int &op_gcd) const;
+        int             big_int_modular_inverse_extended_euclidean_algorithm(const big_int &modulus, big_int &inverse) const;
+        /*  Same results with every temporary taken from workspace, so a loop reusing one 
+            workspace stops allocating once its integers have grown to the operand size. */
+        int             big_int_div(const big_int &divisor, big_int &quotient, big_int &remainder, big_int_workspace &workspace) const;
+        int             big_int_modulus(const big_int &modulus, big_int &result, big_int_workspace &workspace) const;
+        int             big_int_fast_modular_exponentiation(const big_int &exponent, const big_int &modulus, big_int &result, \
+            big_int_workspace &workspace) const;
+        int             big_int_gcd_euclidean_algorithm(const big_int &b, big_int &op_gcd, big_int_workspace &workspace) const;
+        int             big_int_modular_inverse_extended_euclidean_algorithm(const big_int &modulus, big_int &inverse, \
+            big_int_workspace &workspace) const;
         bool            big_int_is_even() const;
         int             big_int_fast_divide_by_power_of_two(int power, big_int &remainder, big_int &coefficient) const;
         int             big_int_fast_multiply_by_power_of_two(int power, big_int &result) const;
         int             big_int_get_random_unsigned(int bits);
         int             big_int_get_random_unsigned_between(const big_int &low, const big_int &high);
         int             big_int_get_random_unsigned_prime_rabin_miller(int bits, int reqd_rabin_miller_iterations);
+        int             big_int_get_random_unsigned_prime_rabin_miller(int bits, int reqd_rabin_miller_iterations, \
+            big_int_random_source &random_source);
         int             big_int_get_random_unsigned_prime_rabin_miller_threaded(int bits, int reqd_rabin_miller_iterations, int no_of_threads);
+        int             big_int_get_random_unsigned_prime_rabin_miller_threaded(int bits, int reqd_rabin_miller_iterations, int no_of_threads, \
+            const big_int_cancel_token &cancel_token);
+        int             big_int_get_random_unsigned_prime_rabin_miller_threaded(int bits, int reqd_rabin_miller_iterations, int no_of_threads, \
+            const big_int_cancel_token &cancel_token, big_int_random_source &random_source);
+        int             big_int_get_random_unsigned_prime_rabin_miller_pipelined(int bits, int reqd_rabin_miller_iterations, \
+            int no_of_producer_threads, int no_of_consumer_threads);
 
         /* Logical shifts*/
         int             big_int_left_shift_word(int shift_words);
-        int             big_int_left_shift_word(int shift_words, big_int &res);
+        int             big_int_left_shift_word(int shift_words, big_int &res) const;
         int             big_int_left_shift(int bits);
-        int             big_int_left_shift(int bits, big_int &res);
+        int             big_int_left_shift(int bits, big_int &res) const;
         int             big_int_right_shift_word(int shift_words);
-        int             big_int_right_shift_word(int shift_words, big_int &res);
+        int             big_int_right_shift_word(int shift_words, big_int &res) const;
         int             big_int_right_shift(int bits);
-        int             big_int_right_shift(int bits, big_int &res);
+        int             big_int_right_shift(int bits, big_int &res) const;
 
         /* First param should be larger. */
         int             big_int_unsigned_sub(const big_int &b);
@@ -133,12 +491,224 @@ namespace bi {
 
         /* Temporary public func.s for testing */
         int             big_int_push_back_hex_chars(const BI_BASE_TYPE &hex_chars);
-        int             big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder);
+        int             big_int_divide_once(const big_int &divisor, BI_BASE_TYPE &op_quotient, big_int &op_remainder) const;
 
 
         /* TODO: make private */
-        int             _big_int_generate_random_probable_prime(int bits, std::mt19937 &mt_arg, std::uniform_int_distribution<BI_BASE_TYPE> &uni_dist, int max_lower_prime_check);
+        int             _big_int_generate_random_probable_prime(int bits, big_int_random_source &rng, int max_lower_prime_check);
+        
+    };
+
+    /*  Pool of scratch integers for the arithmetic overloads taking one, like OpenSSL's BN_CTX.
+
+        The integers keep their buffers between calls, so a hot loop passing the same workspace
+        to millions of exponentiations allocates only during the first few. Integers are handed
+        out through a big_int_workspace_frame and go back to the pool when the frame ends, frames
+        nest like the calls using them. Not thread safe, use one workspace per thread. */
+    class big_int_workspace {
+
+        friend class big_int_workspace_frame;
+
+        public:
+
+        big_int_workspace();
+        /* Integers are created with room for the product of two reserve_bits operands. */
+        explicit big_int_workspace(int reserve_bits);
+        ~big_int_workspace();
+
+        big_int_workspace(const big_int_workspace &) = delete;
+        big_int_workspace& operator=(const big_int_workspace &) = delete;
+
+        /* Integers created so far, the most the calls using it held at once. */
+        size_t          big_int_workspace_size() const;
+
+        private:
+
+        std::vector<std::unique_ptr<big_int>>   _pool;
+        size_t                                  _used;
+        int                                     _reserve_limbs;
+
+    };
+
+    class big_int_workspace_frame {
+
+        public:
+
+        explicit big_int_workspace_frame(big_int_workspace &workspace);
+        ~big_int_workspace_frame();
+
+        big_int_workspace_frame(const big_int_workspace_frame &) = delete;
+        big_int_workspace_frame& operator=(const big_int_workspace_frame &) = delete;
+
+        /* A zero from the pool, owned by this frame until it ends. */
+        big_int&        big_int_workspace_frame_get();
+
+        private:
+
+        big_int_workspace   &_workspace;
+        size_t              _start;
+
+    };
+
+    /*  Buffered text input of numbers from a FILE *, a file descriptor or a memory region
+        (e.g. a mapped parameter file), one number per big_int_stream_read.
+
+        Digits are consumed in fixed size chunks, decimal chunks are converted as they arrive
+        and merged pairwise, so apart from the result only a constant sized buffer and about 
+        one result worth of partial values are held. The FILE * / descriptor is not closed. */
+    class big_int_stream_reader {
+
+        public:
+
+        static constexpr size_t     BUFFER_SIZE             = 64 * 1024;
+
+        /* Throw std::invalid_argument for a null file, negetive descriptor or null region. */
+        explicit big_int_stream_reader(FILE *file);
+        explicit big_int_stream_reader(int fd);
+        big_int_stream_reader(const char *data, size_t size);
+
+        big_int_stream_reader(const big_int_stream_reader &) = delete;
+        big_int_stream_reader& operator=(const big_int_stream_reader &) = delete;
+
+        /* Skips leading white space, then reads an optional '-' and the digits (hex may have a 
+           "0x" prefix) and stops before the first character that is not a digit. Returns -1 
+           (op set to zero) if there are no digits or the read fails. */
+        int             big_int_stream_read(big_int &op, bi_base base = bi_base::BI_HEX);
+        /* True once the input is exhausted. */
+        bool            big_int_stream_eof();
+
+        private:
+
+        FILE                        *_file;
+        int                         _fd;
+        std::unique_ptr<char []>    _buffer_mem;
+        const char                  *_buffer;
+        size_t                      _pos;
+        size_t                      _len;
+        bool                        _error;
+
+        bool            _big_int_stream_fill();
+        int             _big_int_stream_peek();
+        int             _big_int_stream_read_pow2(big_int &op, bool is_neg, int bits_per_digit, bool seen_zero);
+        int             _big_int_stream_read_dec(big_int &op, bool is_neg);
+
+    };
+
+    /*  Buffered text output of numbers to a FILE *, a file descriptor or a caller supplied
+        memory region. Decimal output streams the digits out of the divide and conquer
+        conversion as they are produced, no string of the whole number is built. */
+    class big_int_stream_writer {
+
+        public:
+
+        static constexpr size_t     BUFFER_SIZE             = 64 * 1024;
+
+        /* Throw std::invalid_argument for a null file, negetive descriptor or null region. */
+        explicit big_int_stream_writer(FILE *file);
+        explicit big_int_stream_writer(int fd);
+        big_int_stream_writer(char *data, size_t size);
+        /* Flushes, errors at this point are lost, call big_int_stream_flush to see them. */
+        ~big_int_stream_writer();
+
+        big_int_stream_writer(const big_int_stream_writer &) = delete;
+        big_int_stream_writer& operator=(const big_int_stream_writer &) = delete;
+
+        /* Same text as big_int_to_string, no separator. Return -1 once a write has failed
+           (or the memory region is full), later calls keep failing. */
+        int             big_int_stream_write(const big_int &op, bi_base base = bi_base::BI_HEX);
+        int             big_int_stream_write_chars(const char *chars, size_t count);
+        int             big_int_stream_flush();
+        /* Bytes handed to the destination so far, excluding what is still buffered. */
+        size_t          big_int_stream_bytes_written() const;
+
+        private:
+
+        FILE                        *_file;
+        int                         _fd;
+        char                        *_region;
+        size_t                      _region_size;
+        std::unique_ptr<char []>    _buffer;
+        size_t                      _len;
+        size_t                      _bytes_written;
+        bool                        _error;
+
+    };
+
+    /*  Montgomery constants (-n^-1 mod 2^32, R^2 mod n) of an odd modulus n.
         
+        Immutable once built, so one context can be shared by any number of threads. 
+        Exponentiation through it replaces the division per step of
+        big_int_fast_modular_exponentiation with word level Montgomery reduction. */
+    class big_int_montgomery_ctx {
+
+        public:
+
+        /* Throws std::invalid_argument if modulus is not odd and greater than one. */
+        explicit big_int_montgomery_ctx(const big_int &modulus);
+        /* Restores a context from previously exported constants, throws std::invalid_argument 
+           if they do not belong to modulus. */
+        big_int_montgomery_ctx(const big_int &modulus, BI_BASE_TYPE n0_inv, const big_int &r_squared);
+
+        /* result = base ^ exponent mod n, exponent must be non negetive. Polls the
+           cancel scope of the calling thread like big_int_fast_modular_exponentiation. 
+           Exponents of one word (e.g. 65537) take a plain square and multiply path without
+           the window table. */
+        int             big_int_montgomery_modular_exponentiation(const big_int &base, const big_int &exponent, big_int &result) const;
+        /* results[i] = bases[i] ^ exponents[i] mod the modulus of ctxs[i] for count independent jobs.
+           Jobs whose moduli have the same number of limbs run BI_MONTGOMERY_LANES at a time, 
+           interleaved word by word through one multiplication loop so their carry chains overlap. 
+           Returns -1 if any exponent is negetive. */
+        static int      big_int_montgomery_multi_modular_exponentiation(const big_int_montgomery_ctx *const *ctxs, \
+            const big_int *bases, const big_int *exponents, big_int *results, size_t count);
+        /* result = a * b mod n for 0 <= a, b < n, two Montgomery multiplications and no division. */
+        int             big_int_montgomery_modular_multiply(const big_int &a, const big_int &b, big_int &result) const;
+        const big_int&  big_int_montgomery_get_modulus() const;
+        BI_BASE_TYPE    big_int_montgomery_get_n0_inv() const;
+        const big_int&  big_int_montgomery_get_r_squared() const;
+
+        private:
+
+        big_int         _modulus;
+        big_int         _r_squared;
+        BI_BASE_TYPE    _n0_inv;
+        int             _limbs;
+
+        void            _big_int_montgomery_multiply(const BI_BASE_TYPE *a, const BI_BASE_TYPE *b, BI_BASE_TYPE *res, \
+            BI_BASE_TYPE *scratch) const;
+        int             _big_int_montgomery_word_exponentiation(const big_int &reduced_base, BI_BASE_TYPE exponent, \
+            big_int &result) const;
+
+    };
+
+    /*  Process wide cache of Montgomery contexts by modulus, consulted by 
+        big_int_fast_modular_exponentiation, big_int_multi_modular_exponentiation and the rsa keys,
+        so a modulus used over and over pays for its setup (n0_inv, R^2) once.
+
+        Lookups never lock: a reader pins the current epoch, searches the immutable table 
+        published by the last writer and copies the context's shared_ptr. Inserts and evictions
+        copy the table under a mutex and free what they replaced once no reader pinned before 
+        the swap is left. Holding more than the capacity evicts the least recently used entry,
+        recency being counted in inserts. A context handed out stays valid while its
+        shared_ptr is held, evicted or not. */
+    class big_int_montgomery_cache {
+
+        public:
+
+        static constexpr size_t BI_MONTGOMERY_CACHE_DEFAULT_CAPACITY = 256;
+
+        /* The cached context of modulus, built and inserted on a miss. Throws 
+           std::invalid_argument like big_int_montgomery_ctx if modulus is not odd and greater than one. */
+        static std::shared_ptr<const big_int_montgomery_ctx>   big_int_montgomery_cache_get(const big_int &modulus);
+        /* Evicts down to max_entries right away, 0 disables caching (lookups build private contexts). */
+        static void     big_int_montgomery_cache_set_capacity(size_t max_entries);
+        static size_t   big_int_montgomery_cache_capacity();
+        static size_t   big_int_montgomery_cache_size();
+        static void     big_int_montgomery_cache_clear();
+
+        private:
+
+        static uint64_t _big_int_montgomery_cache_hash(const big_int &modulus);
+
     };
 
 }
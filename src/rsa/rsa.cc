@@ -9,13 +9,204 @@
  *  @bug            No known bugs.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <stdexcept>
 
 #include "rsa.hpp"
+#include "rsa_thread_pool.hpp"
 
 constexpr uint32_t DEFAULT_32_BIT_PUBLIC_KEY = 0x10001;
 
-rsa::rsa(size_t bit_size_arg, int miller_rabin_rounds, int max_number_of_threads_for_miller_rabin) {
+/* Key blob layout (all fields little endian):
+    u32 magic "RSAK", u16 version, u16 flags, u32 bit_size, then big ints as u32 limb count + u32 limbs:
+    n, e, n0_inv(n) (single u32), R^2 mod n and with RSA_KEY_BLOB_FLAG_PRIVATE also
+    p, q, d, dp, dq, q^-1 mod p, n0_inv(p), R^2 mod p, n0_inv(q), R^2 mod q. */
+constexpr uint32_t RSA_KEY_BLOB_MAGIC           = 0x4B415352;
+constexpr uint16_t RSA_KEY_BLOB_VERSION         = 1;
+constexpr uint16_t RSA_KEY_BLOB_FLAG_PRIVATE    = 0x1;
+
+namespace {
+
+    /* Ranges of about a quarter of the per thread share, so stragglers even out. */
+    void run_batch(rsa_thread_pool *pool, size_t count, const std::function<void(size_t, size_t)> &fn) {
+
+        rsa_thread_pool &batch_pool = (pool != nullptr) ? *pool : rsa_thread_pool::rsa_thread_pool_default();
+        size_t threads = batch_pool.rsa_thread_pool_size() + 1;
+        size_t grain = std::max<size_t>(1, count / (4 * threads));
+        batch_pool.rsa_thread_pool_parallel_for(count, grain, fn);
+
+    }
+
+    void blob_append_u32(std::vector<uint8_t> &blob, uint32_t val) {
+
+        for (int i = 0; i < 4; ++i) {
+            blob.push_back(static_cast<uint8_t>(val >> (8 * i)));
+        }
+
+    }
+
+    void blob_append_big_int(std::vector<uint8_t> &blob, const bi::big_int &val) {
+
+        int limbs = val.big_int_get_num_of_base_type();
+        std::vector<BI_BASE_TYPE> limb_data(static_cast<size_t>(limbs));
+        val.big_int_to_base_type_array(limb_data.data(), limbs);
+        blob_append_u32(blob, static_cast<uint32_t>(limbs));
+        for (auto limb : limb_data) {
+            blob_append_u32(blob, limb);
+        }
+
+    }
+
+    /* Bounds checked reader over a key blob. */
+    class blob_reader {
+
+        public:
+
+        blob_reader(const uint8_t *data, size_t size) 
+        :   _data   {data}, 
+            _size   {size}, 
+            _pos    {0} {
+
+        }
+
+        uint32_t read_u32() {
+
+            if (_size - _pos < 4) {
+                throw std::invalid_argument("Truncated RSA key blob");
+            }
+            uint32_t val = 0;
+            for (int i = 0; i < 4; ++i) {
+                val |= static_cast<uint32_t>(_data[_pos++]) << (8 * i);
+            }
+            return val;
+
+        }
+
+        void read_big_int(bi::big_int &op_val) {
+
+            uint32_t limbs = read_u32();
+            if (limbs == 0 || limbs > (_size - _pos) / 4) {
+                throw std::invalid_argument("Truncated RSA key blob");
+            }
+            std::vector<BI_BASE_TYPE> limb_data(limbs);
+            for (auto &limb : limb_data) {
+                limb = read_u32();
+            }
+            op_val.big_int_from_base_type_array(limb_data.data(), static_cast<int>(limbs), false);
+
+        }
+
+        bool at_end() const {
+            return _pos == _size;
+        }
+
+        private:
+
+        const uint8_t   *_data;
+        size_t          _size;
+        size_t          _pos;
+
+    };
+
+}
+
+rsa::rsa() 
+:   bit_size        {0},
+    has_private_key {false} {
+
+}
+
+rsa::rsa(size_t bit_size_arg, int miller_rabin_rounds, int max_number_of_threads_for_miller_rabin) 
+:   rsa() {
+
+    bi::big_int_cancel_token never_cancelled;
+
+    /* Throw if error. */
+    if (_rsa_generate_keys(bit_size_arg, miller_rabin_rounds, max_number_of_threads_for_miller_rabin, never_cancelled, \
+        bi::big_int_system_random_source::instance()) != 0) {
+        throw std::invalid_argument("Error initializing RSA");
+    }
+
+}
+
+rsa::rsa(size_t bit_size_arg, bi::big_int_random_source &random_source, int miller_rabin_rounds, int max_number_of_threads_for_miller_rabin) 
+:   rsa() {
+
+    bi::big_int_cancel_token never_cancelled;
+
+    /* Throw if error. */
+    if (_rsa_generate_keys(bit_size_arg, miller_rabin_rounds, max_number_of_threads_for_miller_rabin, never_cancelled, random_source) != 0) {
+        throw std::invalid_argument("Error initializing RSA");
+    }
+
+}
+
+rsa_keygen_status rsa::rsa_generate(
+    std::unique_ptr<rsa> &op_rsa, 
+    size_t bit_size_arg, 
+    std::chrono::milliseconds time_budget, 
+    int miller_rabin_rounds, 
+    int max_number_of_threads_for_miller_rabin) {
+
+    bi::big_int_cancel_token deadline_token(std::chrono::steady_clock::now() + time_budget);
+    return rsa_generate(op_rsa, bit_size_arg, deadline_token, miller_rabin_rounds, max_number_of_threads_for_miller_rabin);
+
+}
+
+rsa_keygen_status rsa::rsa_generate(
+    std::unique_ptr<rsa> &op_rsa, 
+    size_t bit_size_arg, 
+    const bi::big_int_cancel_token &cancel_token, 
+    int miller_rabin_rounds, 
+    int max_number_of_threads_for_miller_rabin) {
+
+    return rsa_generate(op_rsa, bit_size_arg, cancel_token, bi::big_int_system_random_source::instance(), \
+        miller_rabin_rounds, max_number_of_threads_for_miller_rabin);
+
+}
+
+rsa_keygen_status rsa::rsa_generate(
+    std::unique_ptr<rsa> &op_rsa, 
+    size_t bit_size_arg, 
+    const bi::big_int_cancel_token &cancel_token, 
+    bi::big_int_random_source &random_source, 
+    int miller_rabin_rounds, 
+    int max_number_of_threads_for_miller_rabin) {
+
+    op_rsa.reset();
+
+    std::unique_ptr<rsa> new_rsa(new rsa());
+    int ret_val;
+    try {
+        ret_val = new_rsa->_rsa_generate_keys(bit_size_arg, miller_rabin_rounds, max_number_of_threads_for_miller_rabin, \
+            cancel_token, random_source);
+    } catch (const std::invalid_argument &) {
+        /* Invalid bit size. */
+        ret_val = -1;
+    } catch (const std::range_error &) {
+        ret_val = -1;
+    }
+
+    if (ret_val == 0) {
+        op_rsa = std::move(new_rsa);
+        return rsa_keygen_status::RSA_KEYGEN_OK;
+    } else if (cancel_token.has_timed_out()) {
+        return rsa_keygen_status::RSA_KEYGEN_TIMED_OUT;
+    } else if (cancel_token.is_cancelled()) {
+        return rsa_keygen_status::RSA_KEYGEN_CANCELLED;
+    }
+    return rsa_keygen_status::RSA_KEYGEN_ERROR;
+
+}
+
+int rsa::_rsa_generate_keys(
+    size_t bit_size_arg, 
+    int miller_rabin_rounds, 
+    int max_number_of_threads_for_miller_rabin, 
+    const bi::big_int_cancel_token &cancel_token, 
+    bi::big_int_random_source &random_source) {
 
     int ret_val = 0;
     
@@ -24,16 +215,56 @@ rsa::rsa(size_t bit_size_arg, int miller_rabin_rounds, int max_number_of_threads
     }
     bit_size_arg /= 2;
     bit_size = bit_size_arg;
+    _BI_STAT_ADD(BI_STAT_RSA_KEYGENS, 1);
+    bi::big_int_trace_span trace_span("rsa_keygen", "rsa");
+    trace_span.big_int_trace_span_arg("bits", static_cast<int64_t>(2 * bit_size_arg));
+
+    /* Lets the modular inverse and reductions below notice the cancellation too. */
+    bi::big_int_cancel_scope keygen_cancel_scope(cancel_token);
     
-    /* Create 2 random primes with RSA bitsize bits. */
-    int pq_comp_res;
+    /* Initialise public key, [uses DEFAULT_32_BIT_PUBLIC_KEY as the default public key, hence the minimum 64 bits key size restrictions.] */
+    bi::big_int default_e, bi_1, p_minus_1_mod_e, q_minus_1_mod_e;
+    ret_val += default_e.big_int_from_base_type(DEFAULT_32_BIT_PUBLIC_KEY, false);
+    ret_val += bi_1.big_int_from_base_type(1, false);
+
+    /* Create 2 random primes with RSA bitsize bits, each from its own sub stream of the random source. 
+       e is prime, so it is invertible mod (p-1)(q-1) unless it divides p-1 or q-1, redraw both then. */
+    uint64_t prime_stream_id = 0;
     do {
+        std::unique_ptr<bi::big_int_random_source> p_random_source = random_source.split(prime_stream_id++);
+        std::unique_ptr<bi::big_int_random_source> q_random_source = random_source.split(prime_stream_id++);
         ret_val += p.big_int_get_random_unsigned_prime_rabin_miller_threaded(static_cast<int>(bit_size_arg), \
-        miller_rabin_rounds, max_number_of_threads_for_miller_rabin);
+        miller_rabin_rounds, max_number_of_threads_for_miller_rabin, cancel_token, *p_random_source);
+        if (ret_val != 0) {
+            return ret_val;
+        }
         ret_val += q.big_int_get_random_unsigned_prime_rabin_miller_threaded(static_cast<int>(bit_size_arg), \
-        miller_rabin_rounds, max_number_of_threads_for_miller_rabin);
-    } while((pq_comp_res = p.big_int_unsigned_compare(q)) == 0); /* Continue until we have distinct primes p, q. */
+        miller_rabin_rounds, max_number_of_threads_for_miller_rabin, cancel_token, *q_random_source);
+        if (ret_val != 0) {
+            return ret_val;
+        }
+        ret_val += p.big_int_unsigned_sub(bi_1, p_minus_1);
+        ret_val += q.big_int_unsigned_sub(bi_1, q_minus_1);
+        ret_val += p_minus_1.big_int_modulus(default_e, p_minus_1_mod_e);
+        ret_val += q_minus_1.big_int_modulus(default_e, q_minus_1_mod_e);
+        if (ret_val != 0) {
+            return ret_val;
+        }
+    } while(p.big_int_unsigned_compare(q) == 0 || p_minus_1_mod_e.big_int_is_zero() || q_minus_1_mod_e.big_int_is_zero());
+
+    ret_val += _rsa_init_from_primes(p, q, default_e);
+
+    return ret_val;
+
+}
+
+int rsa::_rsa_init_from_primes(const bi::big_int &p_arg, const bi::big_int &q_arg, const bi::big_int &e_arg) {
+
+    int ret_val = 0;
 
+    p = p_arg;
+    q = q_arg;
+    e = e_arg;
     ret_val += p.big_int_multiply(q, pq);
 
     bi::big_int bi_1;
@@ -44,82 +275,595 @@ rsa::rsa(size_t bit_size_arg, int miller_rabin_rounds, int max_number_of_threads
     ret_val += q.big_int_unsigned_sub(bi_1, q_minus_1);
     ret_val += p_minus_1.big_int_multiply(q_minus_1, p_minus_1q_minus_1);
 
-    /* Initialise public key, [uses DEFAULT_32_BIT_PUBLIC_KEY as the default public key, hence the minimum 64 bits key size restrictions.] */
-    ret_val += e.big_int_from_base_type(DEFAULT_32_BIT_PUBLIC_KEY, false);
-
     if (e.big_int_unsigned_compare(p_minus_1q_minus_1) >= 0) {
-        throw std::invalid_argument("Error initializing RSA");
+        return -1;
     }
 
     /* Calculate the private key as the modular inverse of the 
        public key in (p-1)(q-1). */
-    ret_val += e.big_int_modular_inverse_extended_euclidean_algorithm(p_minus_1q_minus_1, d);
+    {
+        bi::big_int_trace_span trace_span("modular_inverse", "rsa");
+        ret_val += e.big_int_modular_inverse_extended_euclidean_algorithm(p_minus_1q_minus_1, d);
+    }
+    ret_val += _rsa_init_crt_params();
 
-    /* Store the smaller prime among p & q and private key modulo smaller prime
-       for faster/efficient decryption. [Fermat's Little theorem]. */
-    if (pq_comp_res > 0) {
-        smaller_prime = q;
-        ret_val += d.big_int_modulus(q_minus_1, reduced_d);
-    } else {
-        smaller_prime = p;
-        ret_val += d.big_int_modulus(p_minus_1, reduced_d);
+    has_private_key = true;
+    if (ret_val == 0) {
+        _rsa_init_montgomery_ctxs();
     }
+    return ret_val;
 
-    /* Throw if error. */
+}
+
+int rsa::_rsa_init_crt_params() {
+
+    /* dp = d mod (p-1), dq = d mod (q-1) and q^-1 mod p, so that decryption needs 
+       two half size exponentiations instead of one full size one. [Chinese remainder theorem]. */
+    int ret_val = 0;
+    bi::big_int_trace_span trace_span("crt_precompute", "rsa");
+    ret_val += d.big_int_modulus(p_minus_1, d_mod_p_minus_1);
+    ret_val += d.big_int_modulus(q_minus_1, d_mod_q_minus_1);
+    ret_val += q.big_int_modular_inverse_extended_euclidean_algorithm(p, q_inverse_mod_p);
+    return ret_val;
+
+}
+
+std::shared_ptr<const rsa::rsa_montgomery_ctxs> rsa::_rsa_build_montgomery_ctxs() const {
+
+    /* Contexts come from the process wide cache, so keys imported again and again for the
+       same modulus skip the setup. */
+    std::shared_ptr<rsa_montgomery_ctxs> ctxs(new rsa_montgomery_ctxs{ \
+        bi::big_int_montgomery_cache::big_int_montgomery_cache_get(pq), nullptr, nullptr});
+    if (has_private_key) {
+        ctxs->p_ctx = bi::big_int_montgomery_cache::big_int_montgomery_cache_get(p);
+        ctxs->q_ctx = bi::big_int_montgomery_cache::big_int_montgomery_cache_get(q);
+    }
+    return ctxs;
+
+}
+
+void rsa::_rsa_init_montgomery_ctxs() {
+
+    montgomery_ctxs.ctxs = _rsa_build_montgomery_ctxs();
+
+}
+
+const rsa::rsa_montgomery_ctxs& rsa::_rsa_get_montgomery_ctxs() const {
+
+    std::shared_ptr<const rsa_montgomery_ctxs> ctxs = std::atomic_load(&montgomery_ctxs.ctxs);
+    if (ctxs) {
+        return *ctxs;
+    }
+
+    /* Threads racing here all build one, the first one stored is used by everyone. */
+    std::shared_ptr<const rsa_montgomery_ctxs> new_ctxs = _rsa_build_montgomery_ctxs();
+    std::shared_ptr<const rsa_montgomery_ctxs> expected_ctxs;
+    if (std::atomic_compare_exchange_strong(&montgomery_ctxs.ctxs, &expected_ctxs, new_ctxs)) {
+        return *new_ctxs;
+    }
+    return *expected_ctxs;
+
+}
+
+/*
+
+    Factoring n from a key pair (e, d)
+    ----------------------------------
+
+    [refer](https://www.di-mgt.com.au/rsa_factorize_n.html)
+
+    k = e * d - 1 is a multiple of lcm(p-1, q-1), write k = 2^t * r with r odd. For a random g, 
+    the sequence g^r, g^2r, ... g^k mod n ends in 1 and with probability of at least 1/2 reaches 1 
+    through a non trivial square root x of 1, then gcd(x - 1, n) is a prime factor.
+
+*/
+
+int rsa::_rsa_factor_modulus(
+    const bi::big_int &n, 
+    const bi::big_int &e_arg, 
+    const bi::big_int &d_arg, 
+    bi::big_int &op_p, 
+    bi::big_int &op_q) {
+
+    constexpr BI_BASE_TYPE max_factoring_attempts = 100;
+    int ret_val = 0;
+
+    bi::big_int bi_1, bi_2, k, r, n_minus_1;
+    ret_val += bi_1.big_int_from_base_type(1, false);
+    ret_val += bi_2.big_int_from_base_type(2, false);
+    bi::big_int e_copy(e_arg);
+    ret_val += e_copy.big_int_multiply(d_arg, r);
+    ret_val += r.big_int_unsigned_sub(bi_1, k);
+    ret_val += n.big_int_unsigned_sub(bi_1, n_minus_1);
+    if (ret_val != 0 || k.big_int_is_zero() || k.big_int_is_even() == false) {
+        return -1;
+    }
+
+    int t = 0;
+    r = k;
+    while (r.big_int_is_even()) {
+        ret_val += r.big_int_right_shift(1);
+        ++t;
+    }
+
+    bi::big_int_montgomery_ctx n_ctx(n);
+    bi::big_int g, x, y, x_minus_1, remainder;
+    for (BI_BASE_TYPE g_val = 2; g_val < max_factoring_attempts + 2; ++g_val) {
+        ret_val += g.big_int_from_base_type(g_val, false);
+        ret_val += n_ctx.big_int_montgomery_modular_exponentiation(g, r, x);
+        if (ret_val != 0) {
+            return ret_val;
+        }
+        if (x.big_int_compare(bi_1) == 0 || x.big_int_compare(n_minus_1) == 0) {
+            continue;
+        }
+        for (int i = 0; i < t; ++i) {
+            ret_val += n_ctx.big_int_montgomery_modular_exponentiation(x, bi_2, y);
+            if (y.big_int_compare(bi_1) == 0) {
+                /* x is a non trivial square root of 1 mod n. */
+                ret_val += x.big_int_unsigned_sub(bi_1, x_minus_1);
+                ret_val += x_minus_1.big_int_gcd_euclidean_algorithm(n, op_p);
+                bi::big_int n_copy(n);
+                ret_val += n_copy.big_int_div(op_p, op_q, remainder);
+                return ret_val;
+            }
+            if (y.big_int_compare(n_minus_1) == 0) {
+                break;
+            }
+            x = y;
+        }
+    }
+    return -1;
+
+}
+
+void rsa::_rsa_validate_public_key(const bi::big_int &modulus, const bi::big_int &public_key) {
+
+    bi::big_int bi_1;
+    bi_1.big_int_from_base_type(1, false);
+    if (modulus.big_int_is_negetive() || modulus.big_int_is_even() || public_key.big_int_is_negetive() || \
+        public_key.big_int_compare(bi_1) <= 0 || public_key.big_int_compare(modulus) >= 0) {
+        throw std::invalid_argument("Invalid RSA public key");
+    }
+
+}
+
+std::unique_ptr<rsa> rsa::rsa_import_public_key(const bi::big_int &modulus, const bi::big_int &public_key) {
+
+    _rsa_validate_public_key(modulus, public_key);
+
+    std::unique_ptr<rsa> new_rsa(new rsa());
+    new_rsa->pq = modulus;
+    new_rsa->e = public_key;
+    new_rsa->bit_size = static_cast<size_t>(modulus.big_int_get_num_of_bits() + 1) / 2;
+    /* The modulus context is looked up on first use, see _rsa_get_montgomery_ctxs. */
+    return new_rsa;
+
+}
+
+std::unique_ptr<rsa> rsa::rsa_import_private_key_from_primes(
+    const bi::big_int &prime_p, 
+    const bi::big_int &prime_q, 
+    const bi::big_int &public_key) {
+
+    bi::big_int bi_1;
+    bi_1.big_int_from_base_type(1, false);
+    if (prime_p.big_int_is_negetive() || prime_p.big_int_is_even() || prime_p.big_int_compare(bi_1) <= 0 || \
+        prime_q.big_int_is_negetive() || prime_q.big_int_is_even() || prime_q.big_int_compare(bi_1) <= 0 || \
+        prime_p.big_int_compare(prime_q) == 0 || public_key.big_int_is_negetive() || public_key.big_int_compare(bi_1) <= 0) {
+        throw std::invalid_argument("Invalid RSA primes or public key");
+    }
+
+    std::unique_ptr<rsa> new_rsa(new rsa());
+    int ret_val;
+    try {
+        ret_val = new_rsa->_rsa_init_from_primes(prime_p, prime_q, public_key);
+    } catch (const std::range_error &) {
+        /* e not invertible mod (p-1)(q-1). */
+        ret_val = -1;
+    }
     if (ret_val != 0) {
-        throw std::invalid_argument("Error initializing RSA");
+        throw std::invalid_argument("Invalid RSA primes or public key");
+    }
+    new_rsa->bit_size = static_cast<size_t>(new_rsa->pq.big_int_get_num_of_bits() + 1) / 2;
+    return new_rsa;
+
+}
+
+std::unique_ptr<rsa> rsa::rsa_import_private_key(
+    const bi::big_int &modulus, 
+    const bi::big_int &public_key, 
+    const bi::big_int &private_key) {
+
+    /* Checks only, building a public key here would put n in the Montgomery cache for nothing. */
+    _rsa_validate_public_key(modulus, public_key);
+
+    bi::big_int prime_p, prime_q;
+    if (private_key.big_int_is_negetive() || private_key.big_int_is_zero() || \
+        _rsa_factor_modulus(modulus, public_key, private_key, prime_p, prime_q) != 0) {
+        throw std::invalid_argument("Invalid RSA private key");
+    }
+
+    std::unique_ptr<rsa> new_rsa = rsa_import_private_key_from_primes(prime_p, prime_q, public_key);
+    /* Keep the given exponent, it may be reduced mod lcm(p-1, q-1) instead of (p-1)(q-1). */
+    new_rsa->d = private_key;
+    if (new_rsa->_rsa_init_crt_params() != 0) {
+        throw std::invalid_argument("Invalid RSA private key");
+    }
+    return new_rsa;
+
+}
+
+bool rsa::rsa_has_private_key() const {
+    return has_private_key;
+}
+
+int rsa::rsa_serialize(std::vector<uint8_t> &op_blob) const {
+
+    const rsa_montgomery_ctxs &ctxs = _rsa_get_montgomery_ctxs();
+
+    op_blob.clear();
+    blob_append_u32(op_blob, RSA_KEY_BLOB_MAGIC);
+    blob_append_u32(op_blob, static_cast<uint32_t>(RSA_KEY_BLOB_VERSION) | \
+        (static_cast<uint32_t>(has_private_key ? RSA_KEY_BLOB_FLAG_PRIVATE : 0) << 16));
+    blob_append_u32(op_blob, static_cast<uint32_t>(bit_size));
+
+    blob_append_big_int(op_blob, pq);
+    blob_append_big_int(op_blob, e);
+    blob_append_u32(op_blob, ctxs.modulus_ctx->big_int_montgomery_get_n0_inv());
+    blob_append_big_int(op_blob, ctxs.modulus_ctx->big_int_montgomery_get_r_squared());
+
+    if (has_private_key) {
+        blob_append_big_int(op_blob, p);
+        blob_append_big_int(op_blob, q);
+        blob_append_big_int(op_blob, d);
+        blob_append_big_int(op_blob, d_mod_p_minus_1);
+        blob_append_big_int(op_blob, d_mod_q_minus_1);
+        blob_append_big_int(op_blob, q_inverse_mod_p);
+        blob_append_u32(op_blob, ctxs.p_ctx->big_int_montgomery_get_n0_inv());
+        blob_append_big_int(op_blob, ctxs.p_ctx->big_int_montgomery_get_r_squared());
+        blob_append_u32(op_blob, ctxs.q_ctx->big_int_montgomery_get_n0_inv());
+        blob_append_big_int(op_blob, ctxs.q_ctx->big_int_montgomery_get_r_squared());
+    }
+
+    return 0;
+
+}
+
+std::unique_ptr<rsa> rsa::rsa_deserialize(const uint8_t *blob, size_t blob_size) {
+
+    blob_reader reader(blob, blob_size);
+    if (reader.read_u32() != RSA_KEY_BLOB_MAGIC) {
+        throw std::invalid_argument("Not an RSA key blob");
+    }
+    uint32_t version_flags = reader.read_u32();
+    if ((version_flags & 0xFFFF) != RSA_KEY_BLOB_VERSION) {
+        throw std::invalid_argument("Unsupported RSA key blob version");
+    }
+
+    std::unique_ptr<rsa> new_rsa(new rsa());
+    new_rsa->bit_size = reader.read_u32();
+    new_rsa->has_private_key = ((version_flags >> 16) & RSA_KEY_BLOB_FLAG_PRIVATE) != 0;
+
+    bi::big_int r_squared;
+    reader.read_big_int(new_rsa->pq);
+    reader.read_big_int(new_rsa->e);
+    BI_BASE_TYPE n0_inv = reader.read_u32();
+    reader.read_big_int(r_squared);
+
+    bi::big_int bi_1;
+    int e_ret_val = bi_1.big_int_from_base_type(1, false);
+    if (e_ret_val != 0 || new_rsa->e.big_int_compare(bi_1) <= 0 || new_rsa->e.big_int_compare(new_rsa->pq) >= 0) {
+        throw std::invalid_argument("RSA key blob public exponent out of range");
+    }
+
+    /* The Montgomery ctor throws std::invalid_argument on inconsistent constants. */
+    std::shared_ptr<rsa_montgomery_ctxs> ctxs(new rsa_montgomery_ctxs{ \
+        std::make_shared<const bi::big_int_montgomery_ctx>(new_rsa->pq, n0_inv, r_squared), nullptr, nullptr});
+
+    if (new_rsa->has_private_key) {
+        reader.read_big_int(new_rsa->p);
+        reader.read_big_int(new_rsa->q);
+        reader.read_big_int(new_rsa->d);
+        reader.read_big_int(new_rsa->d_mod_p_minus_1);
+        reader.read_big_int(new_rsa->d_mod_q_minus_1);
+        reader.read_big_int(new_rsa->q_inverse_mod_p);
+        n0_inv = reader.read_u32();
+        reader.read_big_int(r_squared);
+        ctxs->p_ctx = std::make_shared<const bi::big_int_montgomery_ctx>(new_rsa->p, n0_inv, r_squared);
+        n0_inv = reader.read_u32();
+        reader.read_big_int(r_squared);
+        ctxs->q_ctx = std::make_shared<const bi::big_int_montgomery_ctx>(new_rsa->q, n0_inv, r_squared);
+
+        /* p - 1, q - 1 and (p - 1)(q - 1) are cheap to redo. */
+        bi::big_int n_check;
+        int ret_val = new_rsa->p.big_int_unsigned_sub(bi_1, new_rsa->p_minus_1);
+        ret_val += new_rsa->q.big_int_unsigned_sub(bi_1, new_rsa->q_minus_1);
+        ret_val += new_rsa->p_minus_1.big_int_multiply(new_rsa->q_minus_1, new_rsa->p_minus_1q_minus_1);
+        ret_val += new_rsa->p.big_int_multiply(new_rsa->q, n_check);
+        if (ret_val != 0 || n_check.big_int_compare(new_rsa->pq) != 0) {
+            throw std::invalid_argument("RSA key blob primes do not match the modulus");
+        }
+
+        /* The CRT constants drive every decryption, a corrupted one gives wrong plain text silently. */
+        bi::big_int q_inverse_times_q, q_inverse_check, d_mod_p_minus_1_check, d_mod_q_minus_1_check;
+        ret_val += new_rsa->q_inverse_mod_p.big_int_multiply(new_rsa->q, q_inverse_times_q);
+        ret_val += q_inverse_times_q.big_int_modulus(new_rsa->p, q_inverse_check);
+        ret_val += new_rsa->d.big_int_modulus(new_rsa->p_minus_1, d_mod_p_minus_1_check);
+        ret_val += new_rsa->d.big_int_modulus(new_rsa->q_minus_1, d_mod_q_minus_1_check);
+        if (ret_val != 0 || q_inverse_check.big_int_compare(bi_1) != 0 || \
+            d_mod_p_minus_1_check.big_int_compare(new_rsa->d_mod_p_minus_1) != 0 || \
+            d_mod_q_minus_1_check.big_int_compare(new_rsa->d_mod_q_minus_1) != 0) {
+            throw std::invalid_argument("RSA key blob CRT constants do not match the key");
+        }
+
+        /* e * d = 1 mod (p - 1) and mod (q - 1), otherwise the private key does not undo the public one. */
+        bi::big_int e_times_dp, e_times_dq, e_dp_check, e_dq_check;
+        ret_val += new_rsa->e.big_int_multiply(new_rsa->d_mod_p_minus_1, e_times_dp);
+        ret_val += e_times_dp.big_int_modulus(new_rsa->p_minus_1, e_dp_check);
+        ret_val += new_rsa->e.big_int_multiply(new_rsa->d_mod_q_minus_1, e_times_dq);
+        ret_val += e_times_dq.big_int_modulus(new_rsa->q_minus_1, e_dq_check);
+        if (ret_val != 0 || e_dp_check.big_int_compare(bi_1) != 0 || e_dq_check.big_int_compare(bi_1) != 0) {
+            throw std::invalid_argument("RSA key blob exponents do not match each other");
+        }
     }
 
+    if (reader.at_end() == false) {
+        throw std::invalid_argument("Trailing data in RSA key blob");
+    }
+
+    new_rsa->montgomery_ctxs.ctxs = std::move(ctxs);
+    return new_rsa;
+
 }
 
-bi::big_int rsa::get_private_key() {
+bi::big_int rsa::get_private_key() const {
+    if (has_private_key == false) {
+        throw std::logic_error("RSA key has no private part");
+    }
     return d;
 }
 
-bi::big_int rsa::get_public_key() {
+bi::big_int rsa::get_public_key() const {
     return e;
 }
 
-bi::big_int rsa::get_modulus() {
+bi::big_int rsa::get_modulus() const {
     return pq;
 }
 
-int rsa::rsa_encrypt(bi::big_int &plain, bi::big_int &cipher) {
+int rsa::_rsa_encrypt(const bi::big_int &plain, bi::big_int &cipher, const rsa_montgomery_ctxs &ctxs) const {
 
-    if (plain.big_int_get_num_of_bits() > bit_size) {
+    if (plain.big_int_is_negetive() || plain.big_int_unsigned_compare(pq) >= 0) {
         throw std::invalid_argument("Plain text too long");
     }
 
-    /* c  = m ^ e mod pq = m ^ e mod p = m ^ e mod q     [Chinese remainder theorem].
-        refer ==> https://tony-josi.github.io/Articles/RSA_Proof/rsa_proof.html */
-    return plain.big_int_fast_modular_exponentiation(e, smaller_prime, cipher);
+    /* c  = m ^ e mod pq */
+    _BI_STAT_ADD(BI_STAT_RSA_ENCRYPTIONS, 1);
+    return ctxs.modulus_ctx->big_int_montgomery_modular_exponentiation(plain, e, cipher);
 }
 
-int rsa::rsa_decrypt_textbook_method(bi::big_int &cipher, bi::big_int &decipher) {
+int rsa::rsa_encrypt(const bi::big_int &plain, bi::big_int &cipher) const {
 
-    if (cipher.big_int_get_num_of_bits() > bit_size) {
+    return _rsa_encrypt(plain, cipher, _rsa_get_montgomery_ctxs());
+}
+
+int rsa::rsa_decrypt_textbook_method(const bi::big_int &cipher, bi::big_int &decipher) const {
+
+    if (has_private_key == false) {
+        throw std::logic_error("RSA key has no private part");
+    }
+    if (cipher.big_int_is_negetive() || cipher.big_int_unsigned_compare(pq) >= 0) {
         throw std::invalid_argument("Cipher text too long");
     }
 
-    /* m  = c ^ d mod pq = c ^ d mod p = c ^ d mod q     [Chinese remainder theorem].
-        refer ==> https://tony-josi.github.io/Articles/RSA_Proof/rsa_proof.html */
-    return cipher.big_int_fast_modular_exponentiation(d, smaller_prime, decipher);
+    /* m  = c ^ d mod pq */
+    return _rsa_get_montgomery_ctxs().modulus_ctx->big_int_montgomery_modular_exponentiation(cipher, d, decipher);
 }
 
-int rsa::rsa_decrypt(bi::big_int &cipher, bi::big_int &decipher) {
+int rsa::_rsa_decrypt(const bi::big_int &cipher, bi::big_int &decipher, const rsa_montgomery_ctxs &ctxs) const {
 
-    if (cipher.big_int_get_num_of_bits() > bit_size) {
+    if (has_private_key == false) {
+        throw std::logic_error("RSA key has no private part");
+    }
+    if (cipher.big_int_is_negetive() || cipher.big_int_unsigned_compare(pq) >= 0) {
         throw std::invalid_argument("Cipher text too long");
     }
 
-    /* Refer ==> RSA optimizing the decryption algorithm
-       from https://tony-josi.github.io/Articles/RSA_Proof/rsa_proof.html */
+    _BI_STAT_ADD(BI_STAT_RSA_DECRYPTIONS, 1);
+    return _rsa_crt_exponentiation(cipher, d_mod_p_minus_1, d_mod_q_minus_1, decipher, ctxs);
+
+}
+
+int rsa::_rsa_crt_exponentiation(const bi::big_int &base, const bi::big_int &exponent_mod_p_minus_1, \
+    const bi::big_int &exponent_mod_q_minus_1, bi::big_int &result, const rsa_montgomery_ctxs &ctxs) const {
+
+    /* Garner's recombination [Chinese remainder theorem]:
+        m1 = c ^ dp mod p, m2 = c ^ dq mod q
+        h  = q^-1 * (m1 - m2) mod p
+        m  = m2 + h * q                                                         */
+
+    int ret_val = 0;
+    bi::big_int m1, m2;
+    ret_val += ctxs.p_ctx->big_int_montgomery_modular_exponentiation(base, exponent_mod_p_minus_1, m1);
+    ret_val += ctxs.q_ctx->big_int_montgomery_modular_exponentiation(base, exponent_mod_q_minus_1, m2);
+    ret_val += _rsa_crt_recombine(m1, m2, result);
+    return ret_val;
+
+}
+
+int rsa::_rsa_crt_recombine(const bi::big_int &m1, const bi::big_int &m2, bi::big_int &result) const {
 
     int ret_val = 0;
-    bi::big_int reduced_cipher_text;
-    ret_val += cipher.big_int_modulus(smaller_prime, reduced_cipher_text);
+    bi::big_int m1_minus_m2, temp_h, h, h_q;
+    ret_val += m1.big_int_signed_sub(m2, m1_minus_m2);
+    ret_val += m1_minus_m2.big_int_multiply(q_inverse_mod_p, temp_h);
+    ret_val += temp_h.big_int_modulus(p, h);
+    ret_val += h.big_int_multiply(q, h_q);
+    ret_val += h_q.big_int_unsigned_add(m2, result);
+    return ret_val;
+
+}
+
+int rsa::rsa_decrypt(const bi::big_int &cipher, bi::big_int &decipher) const {
+
+    return _rsa_decrypt(cipher, decipher, _rsa_get_montgomery_ctxs());
+
+}
+
+int rsa::rsa_decrypt_parallel_crt(
+    const bi::big_int &cipher, 
+    bi::big_int &decipher, 
+    rsa_thread_pool *pool, 
+    size_t min_parallel_bits) const {
+
+    if (static_cast<size_t>(pq.big_int_get_num_of_bits()) < min_parallel_bits) {
+        return rsa_decrypt(cipher, decipher);
+    }
+    if (has_private_key == false) {
+        throw std::logic_error("RSA key has no private part");
+    }
+    if (cipher.big_int_is_negetive() || cipher.big_int_unsigned_compare(pq) >= 0) {
+        throw std::invalid_argument("Cipher text too long");
+    }
+    if (pool == nullptr) {
+        pool = &rsa_thread_pool::rsa_thread_pool_default();
+    }
+
+    _BI_STAT_ADD(BI_STAT_RSA_DECRYPTIONS, 1);
+    const rsa_montgomery_ctxs &ctxs = _rsa_get_montgomery_ctxs();
+    bi::big_int m1, m2;
+    int half_ret_val[2] = {0, 0};
+    /* Two single item ranges, the mod p half and the mod q half. */
+    pool->rsa_thread_pool_parallel_for(2, 1, [&](size_t begin, size_t) {
+        if (begin == 0) {
+            half_ret_val[0] = ctxs.p_ctx->big_int_montgomery_modular_exponentiation(cipher, d_mod_p_minus_1, m1);
+        } else {
+            half_ret_val[1] = ctxs.q_ctx->big_int_montgomery_modular_exponentiation(cipher, d_mod_q_minus_1, m2);
+        }
+    });
 
-    ret_val += reduced_cipher_text.big_int_fast_modular_exponentiation(reduced_d, smaller_prime, decipher);
+    int ret_val = half_ret_val[0] + half_ret_val[1];
+    ret_val += _rsa_crt_recombine(m1, m2, decipher);
     return ret_val;
 
-}
\ No newline at end of file
+}
+
+size_t rsa::rsa_get_modulus_bytes() const {
+
+    return pq.big_int_get_num_of_bytes();
+
+}
+
+int rsa::rsa_encrypt(const uint8_t *plain, size_t plain_size, uint8_t *op_cipher, size_t op_size) const {
+
+    size_t modulus_bytes = rsa_get_modulus_bytes();
+    if (op_size < modulus_bytes) {
+        return -1;
+    }
+
+    int ret_val = 0;
+    bi::big_int plain_num, cipher_num;
+    ret_val += plain_num.big_int_from_bytes(plain, plain_size);
+    ret_val += rsa_encrypt(plain_num, cipher_num);
+    ret_val += cipher_num.big_int_to_bytes(op_cipher, modulus_bytes);
+    return ret_val;
+
+}
+
+int rsa::rsa_decrypt(const uint8_t *cipher, size_t cipher_size, uint8_t *op_decipher, size_t op_size) const {
+
+    size_t modulus_bytes = rsa_get_modulus_bytes();
+    if (op_size < modulus_bytes) {
+        return -1;
+    }
+
+    int ret_val = 0;
+    bi::big_int cipher_num, decipher_num;
+    ret_val += cipher_num.big_int_from_bytes(cipher, cipher_size);
+    ret_val += rsa_decrypt(cipher_num, decipher_num);
+    ret_val += decipher_num.big_int_to_bytes(op_decipher, modulus_bytes);
+    return ret_val;
+
+}
+
+int rsa::rsa_encrypt_batch(const bi::big_int *plain, bi::big_int *op_cipher, size_t count, rsa_thread_pool *pool) const {
+
+    const rsa_montgomery_ctxs &ctxs = _rsa_get_montgomery_ctxs();
+    std::atomic<int> failures{0};
+    run_batch(pool, count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (_rsa_encrypt(plain[i], op_cipher[i], ctxs) != 0) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    return (failures.load() == 0) ? 0 : -1;
+
+}
+
+int rsa::rsa_decrypt_batch(const bi::big_int *cipher, bi::big_int *op_decipher, size_t count, rsa_thread_pool *pool) const {
+
+    if (has_private_key == false) {
+        throw std::logic_error("RSA key has no private part");
+    }
+
+    const rsa_montgomery_ctxs &ctxs = _rsa_get_montgomery_ctxs();
+    std::atomic<int> failures{0};
+    run_batch(pool, count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (_rsa_decrypt(cipher[i], op_decipher[i], ctxs) != 0) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    return (failures.load() == 0) ? 0 : -1;
+
+}
+
+int rsa::rsa_encrypt_batch(const uint8_t *plain, size_t in_stride, uint8_t *op_cipher, size_t count, rsa_thread_pool *pool) const {
+
+    const rsa_montgomery_ctxs &ctxs = _rsa_get_montgomery_ctxs();
+    size_t modulus_bytes = rsa_get_modulus_bytes();
+    std::atomic<int> failures{0};
+    run_batch(pool, count, [&](size_t begin, size_t end) {
+        /* Number buffers reused for the whole range. */
+        bi::big_int plain_num, cipher_num;
+        for (size_t i = begin; i < end; ++i) {
+            int ret_val = 0;
+            ret_val += plain_num.big_int_from_bytes(plain + i * in_stride, in_stride);
+            ret_val += _rsa_encrypt(plain_num, cipher_num, ctxs);
+            ret_val += cipher_num.big_int_to_bytes(op_cipher + i * modulus_bytes, modulus_bytes);
+            if (ret_val != 0) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    return (failures.load() == 0) ? 0 : -1;
+
+}
+
+int rsa::rsa_decrypt_batch(const uint8_t *cipher, size_t in_stride, uint8_t *op_decipher, size_t count, rsa_thread_pool *pool) const {
+
+    if (has_private_key == false) {
+        throw std::logic_error("RSA key has no private part");
+    }
+
+    const rsa_montgomery_ctxs &ctxs = _rsa_get_montgomery_ctxs();
+    size_t modulus_bytes = rsa_get_modulus_bytes();
+    std::atomic<int> failures{0};
+    run_batch(pool, count, [&](size_t begin, size_t end) {
+        bi::big_int cipher_num, decipher_num;
+        for (size_t i = begin; i < end; ++i) {
+            int ret_val = 0;
+            ret_val += cipher_num.big_int_from_bytes(cipher + i * in_stride, in_stride);
+            ret_val += _rsa_decrypt(cipher_num, decipher_num, ctxs);
+            ret_val += decipher_num.big_int_to_bytes(op_decipher + i * modulus_bytes, modulus_bytes);
+            if (ret_val != 0) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    return (failures.load() == 0) ? 0 : -1;
+
+}
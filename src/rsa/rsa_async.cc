@@ -0,0 +1,186 @@
+/**
+ *  @file   rsa_async.cc
+ *  @brief  Source file for the asynchronous RSA calls
+ *
+ *  Queues the synchronous calls on the worker pool with a per call cancel token
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include "rsa_async.hpp"
+
+rsa_async_handle::rsa_async_handle(std::shared_ptr<bi::big_int_cancel_token> token)
+:   cancel_token    {std::move(token)} {
+
+}
+
+void rsa_async_handle::rsa_async_cancel() const {
+
+    cancel_token->cancel();
+
+}
+
+bool rsa_async_handle::rsa_async_cancelled() const {
+
+    return cancel_token->is_cancelled();
+
+}
+
+template <typename T>
+rsa_async_handle rsa_async::_rsa_async_post(
+    rsa_thread_pool *pool,
+    std::function<int(T &value, const bi::big_int_cancel_token &token)> op,
+    completion<T> on_done) {
+
+    if (pool == nullptr) {
+        pool = &rsa_thread_pool::rsa_thread_pool_default();
+    }
+
+    rsa_async_handle handle(std::make_shared<bi::big_int_cancel_token>());
+    std::shared_ptr<bi::big_int_cancel_token> token = handle.cancel_token;
+    pool->rsa_thread_pool_post([token, op, on_done] {
+        rsa_async_result<T> result{BI_STATUS_CANCELLED, T(), nullptr};
+        if (token->is_cancelled() == false) {
+            try {
+                bi::big_int_cancel_scope op_cancel_scope(*token);
+                result.status = op(result.value, *token);
+            } catch (...) {
+                result.status = -1;
+                result.error = std::current_exception();
+            }
+            /* A cancelled call fails somewhere inside, report why rather than where. */
+            if (result.status != 0 && result.error == nullptr && token->is_cancelled()) {
+                result.status = token->has_timed_out() ? BI_STATUS_TIMED_OUT : BI_STATUS_CANCELLED;
+            }
+        }
+        on_done(std::move(result));
+    });
+    return handle;
+
+}
+
+template <typename T>
+rsa_async_future<T> rsa_async::_rsa_async_to_future(const std::function<rsa_async_handle(completion<T>)> &start) {
+
+    /* std::function needs a copyable callback, so the promise is shared. */
+    auto promise = std::make_shared<std::promise<rsa_async_result<T>>>();
+    std::future<rsa_async_result<T>> result = promise->get_future();
+    rsa_async_handle handle = start([promise](rsa_async_result<T> &&op_result) {
+        promise->set_value(std::move(op_result));
+    });
+    return rsa_async_future<T>{std::move(result), std::move(handle)};
+
+}
+
+rsa_async_handle rsa_async::rsa_async_generate(
+    size_t bit_size,
+    completion<std::unique_ptr<rsa>> on_done,
+    rsa_thread_pool *pool,
+    int miller_rabin_rounds,
+    int max_number_of_threads_for_miller_rabin) {
+
+    return _rsa_async_post<std::unique_ptr<rsa>>(pool, \
+        [bit_size, miller_rabin_rounds, max_number_of_threads_for_miller_rabin]
+        (std::unique_ptr<rsa> &op_rsa, const bi::big_int_cancel_token &token) {
+            switch (rsa::rsa_generate(op_rsa, bit_size, token, miller_rabin_rounds, max_number_of_threads_for_miller_rabin)) {
+            case rsa_keygen_status::RSA_KEYGEN_OK:
+                return 0;
+            case rsa_keygen_status::RSA_KEYGEN_TIMED_OUT:
+                return BI_STATUS_TIMED_OUT;
+            case rsa_keygen_status::RSA_KEYGEN_CANCELLED:
+                return BI_STATUS_CANCELLED;
+            default:
+                return -1;
+            }
+        }, std::move(on_done));
+
+}
+
+rsa_async_future<std::unique_ptr<rsa>> rsa_async::rsa_async_generate(
+    size_t bit_size,
+    rsa_thread_pool *pool,
+    int miller_rabin_rounds,
+    int max_number_of_threads_for_miller_rabin) {
+
+    return _rsa_async_to_future<std::unique_ptr<rsa>>([=](completion<std::unique_ptr<rsa>> on_done) {
+        return rsa_async_generate(bit_size, std::move(on_done), pool, miller_rabin_rounds, max_number_of_threads_for_miller_rabin);
+    });
+
+}
+
+rsa_async_handle rsa_async::rsa_async_generate_prime(
+    int bits,
+    completion<bi::big_int> on_done,
+    rsa_thread_pool *pool,
+    int miller_rabin_rounds,
+    int no_of_threads) {
+
+    return _rsa_async_post<bi::big_int>(pool, \
+        [bits, miller_rabin_rounds, no_of_threads](bi::big_int &op_prime, const bi::big_int_cancel_token &token) {
+            return op_prime.big_int_get_random_unsigned_prime_rabin_miller_threaded(bits, miller_rabin_rounds, \
+                no_of_threads, token);
+        }, std::move(on_done));
+
+}
+
+rsa_async_future<bi::big_int> rsa_async::rsa_async_generate_prime(
+    int bits,
+    rsa_thread_pool *pool,
+    int miller_rabin_rounds,
+    int no_of_threads) {
+
+    return _rsa_async_to_future<bi::big_int>([=](completion<bi::big_int> on_done) {
+        return rsa_async_generate_prime(bits, std::move(on_done), pool, miller_rabin_rounds, no_of_threads);
+    });
+
+}
+
+rsa_async_handle rsa_async::rsa_async_encrypt(
+    std::shared_ptr<const rsa> key,
+    const bi::big_int &plain,
+    completion<bi::big_int> on_done,
+    rsa_thread_pool *pool) {
+
+    return _rsa_async_post<bi::big_int>(pool, \
+        [key, plain](bi::big_int &op_cipher, const bi::big_int_cancel_token &) {
+            return key->rsa_encrypt(plain, op_cipher);
+        }, std::move(on_done));
+
+}
+
+rsa_async_future<bi::big_int> rsa_async::rsa_async_encrypt(
+    std::shared_ptr<const rsa> key,
+    const bi::big_int &plain,
+    rsa_thread_pool *pool) {
+
+    return _rsa_async_to_future<bi::big_int>([&key, &plain, pool](completion<bi::big_int> on_done) {
+        return rsa_async_encrypt(key, plain, std::move(on_done), pool);
+    });
+
+}
+
+rsa_async_handle rsa_async::rsa_async_decrypt(
+    std::shared_ptr<const rsa> key,
+    const bi::big_int &cipher,
+    completion<bi::big_int> on_done,
+    rsa_thread_pool *pool) {
+
+    return _rsa_async_post<bi::big_int>(pool, \
+        [key, cipher](bi::big_int &op_decipher, const bi::big_int_cancel_token &) {
+            return key->rsa_decrypt(cipher, op_decipher);
+        }, std::move(on_done));
+
+}
+
+rsa_async_future<bi::big_int> rsa_async::rsa_async_decrypt(
+    std::shared_ptr<const rsa> key,
+    const bi::big_int &cipher,
+    rsa_thread_pool *pool) {
+
+    return _rsa_async_to_future<bi::big_int>([&key, &cipher, pool](completion<bi::big_int> on_done) {
+        return rsa_async_decrypt(key, cipher, std::move(on_done), pool);
+    });
+
+}
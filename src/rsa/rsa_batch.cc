@@ -0,0 +1,297 @@
+/**
+ *  @file   rsa_batch.cc
+ *  @brief  Source file for Fiat batch RSA decryption
+ *
+ *  Slot exponent selection, the product tree and the batch decryption
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <stdexcept>
+
+#include "rsa_batch.hpp"
+
+rsa_batch::rsa_batch(const rsa &private_key, size_t batch_size)
+:   key     {private_key} {
+
+    if (key.has_private_key == false) {
+        throw std::logic_error("RSA key has no private part");
+    }
+    if (batch_size < 2 || batch_size > RSA_BATCH_MAX_SIZE) {
+        throw std::invalid_argument("Batch size out of range");
+    }
+
+    /* Odd primes from 3 upwards, skipping the ones dividing p - 1 or q - 1 as those have
+       no inverse in Z(p - 1)(q - 1). Trial division is enough at these sizes. */
+    bi::big_int e_i, rem;
+    for (BI_BASE_TYPE candidate = 3; public_exponents.size() < batch_size; candidate += 2) {
+        bool is_prime = true;
+        for (BI_BASE_TYPE div = 3; div * div <= candidate; div += 2) {
+            if (candidate % div == 0) {
+                is_prime = false;
+                break;
+            }
+        }
+        if (is_prime == false) {
+            continue;
+        }
+
+        e_i.big_int_from_base_type(candidate, false);
+        key.p_minus_1.big_int_modulus(e_i, rem);
+        if (rem.big_int_is_zero()) {
+            continue;
+        }
+        key.q_minus_1.big_int_modulus(e_i, rem);
+        if (rem.big_int_is_zero()) {
+            continue;
+        }
+        public_exponents.push_back(e_i);
+    }
+
+    /* Per slot CRT exponents for the partial batch fallback. */
+    slot_d_mod_p_minus_1.resize(batch_size);
+    slot_d_mod_q_minus_1.resize(batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+        public_exponents[i].big_int_modular_inverse_extended_euclidean_algorithm(key.p_minus_1, slot_d_mod_p_minus_1[i]);
+        public_exponents[i].big_int_modular_inverse_extended_euclidean_algorithm(key.q_minus_1, slot_d_mod_q_minus_1[i]);
+    }
+
+    nodes.reserve(2 * batch_size - 1);
+    size_t root = _rsa_batch_build_tree(0, batch_size);
+    nodes[root].exponent.big_int_modular_inverse_extended_euclidean_algorithm(key.p_minus_1, root_d_mod_p_minus_1);
+    nodes[root].exponent.big_int_modular_inverse_extended_euclidean_algorithm(key.q_minus_1, root_d_mod_q_minus_1);
+
+}
+
+size_t rsa_batch::_rsa_batch_build_tree(size_t lo, size_t hi) {
+
+    /* Children are pushed after their parent, so the root is always node 0. */
+    size_t node_idx = nodes.size();
+    nodes.emplace_back();
+    nodes[node_idx].lo = lo;
+    nodes[node_idx].hi = hi;
+
+    if (hi - lo == 1) {
+        nodes[node_idx].exponent = public_exponents[lo];
+        return node_idx;
+    }
+
+    size_t mid = lo + (hi - lo) / 2;
+    size_t left = _rsa_batch_build_tree(lo, mid);
+    size_t right = _rsa_batch_build_tree(mid, hi);
+
+    /* t = E_L * u, with u = E_L ^ -1 mod E_R, gives t = 0 mod E_L and t = 1 mod E_R. */
+    batch_node &node = nodes[node_idx];
+    const bi::big_int &e_left = nodes[left].exponent, &e_right = nodes[right].exponent;
+    bi::big_int bi_1, t, rem;
+    bi_1.big_int_from_base_type(1, false);
+    node.left = left;
+    node.right = right;
+    e_left.big_int_multiply(e_right, node.exponent);
+    e_left.big_int_modular_inverse_extended_euclidean_algorithm(e_right, node.u);
+    e_left.big_int_multiply(node.u, t);
+    t.big_int_unsigned_sub(bi_1, node.t_minus_1);
+    node.t_minus_1.big_int_div(e_right, node.w, rem);
+    return node_idx;
+
+}
+
+int rsa_batch::_rsa_batch_up(
+    size_t node_idx,
+    const bi::big_int *ciphers,
+    std::vector<bi::big_int> &node_values,
+    const bi::big_int_montgomery_ctx &modulus_ctx) const {
+
+    const batch_node &node = nodes[node_idx];
+    if (node.hi - node.lo == 1) {
+        node_values[node_idx] = ciphers[node.lo];
+        return 0;
+    }
+
+    /* v = v_L ^ E_R * v_R ^ E_L = (x_L * x_R) ^ (E_L * E_R) */
+    int ret_val = 0;
+    ret_val += _rsa_batch_up(node.left, ciphers, node_values, modulus_ctx);
+    ret_val += _rsa_batch_up(node.right, ciphers, node_values, modulus_ctx);
+
+    bi::big_int left_pow, right_pow;
+    ret_val += modulus_ctx.big_int_montgomery_modular_exponentiation(node_values[node.left], nodes[node.right].exponent, left_pow);
+    ret_val += modulus_ctx.big_int_montgomery_modular_exponentiation(node_values[node.right], nodes[node.left].exponent, right_pow);
+    ret_val += modulus_ctx.big_int_montgomery_modular_multiply(left_pow, right_pow, node_values[node_idx]);
+    return ret_val;
+
+}
+
+int rsa_batch::_rsa_batch_down(
+    const bi::big_int &root_x,
+    const std::vector<bi::big_int> &node_values,
+    bi::big_int *op_plains,
+    const bi::big_int_montgomery_ctx &modulus_ctx) const {
+
+    /*  At a node with x = x_L * x_R:
+            x ^ t = x_L ^ (E_L * u) * x_R ^ (1 + E_R * w) = v_L ^ u * v_R ^ w * x_R
+        so with A = x ^ (t - 1), D = v_L ^ u * v_R ^ w and I = (A * D) ^ -1:
+            x_R = A * x / D = A ^ 2 * x * I
+            x_L = x / x_R   = D / A = D ^ 2 * I
+        The nodes are split a tree level at a time, the A * D of a level are inverted together
+        (Montgomery's trick: one inverse and 3 (k - 1) products for k values), so a batch costs
+        about log2(b) inverses. Throws std::range_error if some A * D is not invertible. */
+    int ret_val = 0;
+    std::vector<size_t> level{0}, next_level;
+    std::vector<bi::big_int> level_x{root_x}, next_level_x;
+    std::vector<bi::big_int> a(nodes.size()), d(nodes.size()), a_d(nodes.size()), prefix;
+    bi::big_int v_left_pow, v_right_pow, inv, level_inv, temp_1, temp_2;
+
+    while (level.empty() == false) {
+        next_level.clear();
+        next_level_x.clear();
+        prefix.clear();
+
+        for (size_t i = 0; i < level.size(); ++i) {
+            const batch_node &node = nodes[level[i]];
+            if (node.hi - node.lo == 1) {
+                op_plains[node.lo] = level_x[i];
+                continue;
+            }
+            ret_val += modulus_ctx.big_int_montgomery_modular_exponentiation(level_x[i], node.t_minus_1, a[level[i]]);
+            ret_val += modulus_ctx.big_int_montgomery_modular_exponentiation(node_values[node.left], node.u, v_left_pow);
+            ret_val += modulus_ctx.big_int_montgomery_modular_exponentiation(node_values[node.right], node.w, v_right_pow);
+            ret_val += modulus_ctx.big_int_montgomery_modular_multiply(v_left_pow, v_right_pow, d[level[i]]);
+            ret_val += modulus_ctx.big_int_montgomery_modular_multiply(a[level[i]], d[level[i]], a_d[level[i]]);
+
+            /* prefix[k] = product of the first k + 1 values of A * D in the level */
+            if (prefix.empty()) {
+                prefix.push_back(a_d[level[i]]);
+            } else {
+                prefix.emplace_back();
+                ret_val += modulus_ctx.big_int_montgomery_modular_multiply(prefix[prefix.size() - 2], a_d[level[i]], prefix.back());
+            }
+        }
+
+        if (prefix.empty() == false) {
+            ret_val += prefix.back().big_int_modular_inverse_extended_euclidean_algorithm(key.pq, level_inv);
+        }
+
+        /* Walk the level backwards peeling one A * D at a time off the running inverse. */
+        size_t k = prefix.size();
+        for (size_t i = level.size(); i-- > 0;) {
+            const batch_node &node = nodes[level[i]];
+            if (node.hi - node.lo == 1) {
+                continue;
+            }
+            --k;
+            if (k == 0) {
+                inv = level_inv;
+            } else {
+                ret_val += modulus_ctx.big_int_montgomery_modular_multiply(level_inv, prefix[k - 1], inv);
+                ret_val += modulus_ctx.big_int_montgomery_modular_multiply(level_inv, a_d[level[i]], temp_1);
+                level_inv = temp_1;
+            }
+
+            const bi::big_int &node_a = a[level[i]], &node_d = d[level[i]];
+            next_level.push_back(node.right);
+            next_level_x.emplace_back();
+            ret_val += modulus_ctx.big_int_montgomery_modular_multiply(node_a, node_a, temp_1);
+            ret_val += modulus_ctx.big_int_montgomery_modular_multiply(temp_1, level_x[i], temp_2);
+            ret_val += modulus_ctx.big_int_montgomery_modular_multiply(temp_2, inv, next_level_x.back());
+
+            next_level.push_back(node.left);
+            next_level_x.emplace_back();
+            ret_val += modulus_ctx.big_int_montgomery_modular_multiply(node_d, node_d, temp_1);
+            ret_val += modulus_ctx.big_int_montgomery_modular_multiply(temp_1, inv, next_level_x.back());
+        }
+
+        level.swap(next_level);
+        level_x.swap(next_level_x);
+    }
+    return ret_val;
+
+}
+
+int rsa_batch::_rsa_batch_decrypt_slot(size_t slot, const bi::big_int &cipher, bi::big_int &op_plain) const {
+
+    return key._rsa_crt_exponentiation(cipher, slot_d_mod_p_minus_1[slot], slot_d_mod_q_minus_1[slot], \
+        op_plain, key._rsa_get_montgomery_ctxs());
+
+}
+
+size_t rsa_batch::rsa_batch_size() const {
+
+    return public_exponents.size();
+
+}
+
+const bi::big_int& rsa_batch::rsa_batch_get_public_key(size_t slot) const {
+
+    if (slot >= public_exponents.size()) {
+        throw std::invalid_argument("Batch slot out of range");
+    }
+    return public_exponents[slot];
+
+}
+
+bi::big_int rsa_batch::rsa_batch_get_modulus() const {
+
+    return key.pq;
+
+}
+
+int rsa_batch::rsa_batch_encrypt(size_t slot, const bi::big_int &plain, bi::big_int &op_cipher) const {
+
+    if (slot >= public_exponents.size()) {
+        throw std::invalid_argument("Batch slot out of range");
+    }
+    if (plain.big_int_is_negetive() || plain.big_int_unsigned_compare(key.pq) >= 0) {
+        throw std::invalid_argument("Plain text too long");
+    }
+
+    /* c  = m ^ e_i mod pq */
+    return key._rsa_get_montgomery_ctxs().modulus_ctx->big_int_montgomery_modular_exponentiation(plain, \
+        public_exponents[slot], op_cipher);
+
+}
+
+int rsa_batch::rsa_batch_decrypt(const bi::big_int *ciphers, bi::big_int *op_plains, size_t count) const {
+
+    if (count > public_exponents.size()) {
+        throw std::invalid_argument("More ciphers than batch slots");
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (ciphers[i].big_int_is_negetive() || ciphers[i].big_int_unsigned_compare(key.pq) >= 0) {
+            throw std::invalid_argument("Cipher text too long");
+        }
+    }
+
+    int ret_val = 0;
+    const rsa::rsa_montgomery_ctxs &ctxs = key._rsa_get_montgomery_ctxs();
+    if (count == public_exponents.size()) {
+        /* Results go to a local copy first, ciphers and op_plains may overlap and a failed
+           split must leave the ciphers intact for the fallback. */
+        std::vector<bi::big_int> node_values(nodes.size()), plains(count);
+        bi::big_int root_x;
+        try {
+            ret_val += _rsa_batch_up(0, ciphers, node_values, *ctxs.modulus_ctx);
+            ret_val += key._rsa_crt_exponentiation(node_values[0], root_d_mod_p_minus_1, root_d_mod_q_minus_1, \
+                root_x, ctxs);
+            ret_val += _rsa_batch_down(root_x, node_values, plains.data(), *ctxs.modulus_ctx);
+        } catch (const std::range_error &) {
+            /* Some cipher is 0 or shares a factor with n, no tree split exists. */
+            plains.clear();
+        }
+
+        if (plains.empty() == false) {
+            for (size_t i = 0; i < count; ++i) {
+                op_plains[i] = std::move(plains[i]);
+            }
+            return ret_val;
+        }
+        ret_val = 0;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        ret_val += _rsa_batch_decrypt_slot(i, ciphers[i], op_plains[i]);
+    }
+    return ret_val;
+
+}
@@ -0,0 +1,229 @@
+/**
+ *  @file   rsa_key_pool.cc
+ *  @brief  Source file for the RSA key pool
+ *
+ *  Background generation and hand out of precomputed RSA key pairs
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "rsa_key_pool.hpp"
+
+namespace {
+
+    /* Wait after a failed generation, doubled per consecutive failure up to the max. */
+    constexpr std::chrono::milliseconds KEY_POOL_ERROR_BACKOFF{100};
+    constexpr std::chrono::milliseconds KEY_POOL_ERROR_BACKOFF_MAX{5000};
+
+    void lower_current_thread_priority() {
+
+#if defined(__linux__)
+        /* Linux applies nice values per thread, threads spawned by the prime search inherit it. */
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+
+    }
+
+}
+
+rsa_key_pool::rsa_key_pool(
+    const std::vector<rsa_key_pool_config> &configs,
+    int no_of_worker_threads,
+    int miller_rabin_rounds_arg,
+    int max_number_of_threads_for_miller_rabin_arg)
+:   miller_rabin_rounds                     {miller_rabin_rounds_arg},
+    max_number_of_threads_for_miller_rabin  {max_number_of_threads_for_miller_rabin_arg},
+    stop_workers                            {false} {
+
+    if (configs.empty() || no_of_worker_threads <= 0) {
+        throw std::invalid_argument("Key pool needs at least one bit size and one worker thread");
+    }
+
+    for (const auto &config : configs) {
+        if (config.high_watermark == 0 || config.low_watermark > config.high_watermark) {
+            throw std::invalid_argument("Invalid key pool watermarks");
+        }
+        if (config.bit_size < 64 || config.bit_size % 2 != 0) {
+            throw std::invalid_argument("Invalid key pool bit size, must be greater than or equal to 64 and even");
+        }
+        for (const auto &entry : entries) {
+            if (entry.config.bit_size == config.bit_size) {
+                throw std::invalid_argument("Duplicate key pool bit size");
+            }
+        }
+        /* Start every pool filling up to its high watermark. */
+        entries.push_back(pool_entry{config, {}, 0, true, 0, 0, 0, 0.0});
+    }
+
+    workers.reserve(static_cast<size_t>(no_of_worker_threads));
+    for (int i = 0; i < no_of_worker_threads; ++i) {
+        workers.emplace_back(&rsa_key_pool::_rsa_key_pool_worker, this);
+    }
+
+}
+
+rsa_key_pool::~rsa_key_pool() {
+
+    {
+        std::lock_guard<std::mutex> pool_lock(pool_mutex);
+        stop_workers = true;
+    }
+    /* Abort the key generations in progress instead of waiting for them. */
+    stop_token.cancel();
+    refill_cv.notify_all();
+    key_ready_cv.notify_all();
+
+    for (auto &t : workers) {
+        t.join();
+    }
+
+}
+
+rsa_key_pool::pool_entry& rsa_key_pool::_rsa_key_pool_get_entry(size_t bit_size) {
+
+    for (auto &entry : entries) {
+        if (entry.config.bit_size == bit_size) {
+            return entry;
+        }
+    }
+    throw std::invalid_argument("No key pool for the given bit size");
+
+}
+
+rsa_key_pool::pool_entry* rsa_key_pool::_rsa_key_pool_next_refill() {
+
+    /* Pick the refilling pool with the fewest keys ready or on the way. */
+    pool_entry *next_entry = nullptr;
+    for (auto &entry : entries) {
+        size_t pending = entry.keys.size() + entry.in_flight;
+        if (entry.refilling == false || pending >= entry.config.high_watermark) {
+            continue;
+        }
+        if (next_entry == nullptr || pending < next_entry->keys.size() + next_entry->in_flight) {
+            next_entry = &entry;
+        }
+    }
+    return next_entry;
+
+}
+
+std::unique_ptr<rsa> rsa_key_pool::_rsa_key_pool_pop(pool_entry &entry) {
+
+    std::unique_ptr<rsa> key;
+    if (entry.keys.empty() == false) {
+        key = std::move(entry.keys.front());
+        entry.keys.pop_front();
+        ++entry.total_acquired;
+    } else {
+        ++entry.acquire_misses;
+    }
+
+    if (entry.refilling == false && entry.keys.size() < entry.config.low_watermark) {
+        entry.refilling = true;
+        refill_cv.notify_all();
+    }
+    return key;
+
+}
+
+void rsa_key_pool::_rsa_key_pool_worker() {
+
+    lower_current_thread_priority();
+
+    std::chrono::milliseconds error_backoff = KEY_POOL_ERROR_BACKOFF;
+    std::unique_lock<std::mutex> pool_lock(pool_mutex);
+    while (stop_workers == false) {
+
+        pool_entry *entry = _rsa_key_pool_next_refill();
+        if (entry == nullptr) {
+            refill_cv.wait(pool_lock);
+            continue;
+        }
+
+        ++entry->in_flight;
+        size_t bit_size = entry->config.bit_size;
+        pool_lock.unlock();
+
+        std::unique_ptr<rsa> new_key;
+        auto gen_start = std::chrono::steady_clock::now();
+        rsa_keygen_status status;
+        try {
+            status = rsa::rsa_generate(new_key, bit_size, stop_token, miller_rabin_rounds, \
+                max_number_of_threads_for_miller_rabin);
+        } catch (...) {
+            /* Nothing may escape the worker thread, count it as a failed generation. */
+            status = rsa_keygen_status::RSA_KEYGEN_ERROR;
+        }
+        std::chrono::duration<double> gen_time = std::chrono::steady_clock::now() - gen_start;
+
+        pool_lock.lock();
+        --entry->in_flight;
+        if (status == rsa_keygen_status::RSA_KEYGEN_OK) {
+            entry->keys.push_back(std::move(new_key));
+            ++entry->total_generated;
+            entry->generation_seconds += gen_time.count();
+            if (entry->keys.size() >= entry->config.high_watermark) {
+                entry->refilling = false;
+            }
+            key_ready_cv.notify_all();
+            error_backoff = KEY_POOL_ERROR_BACKOFF;
+        } else if (status == rsa_keygen_status::RSA_KEYGEN_ERROR) {
+            /* Whatever failed will likely fail again, do not spin on it. */
+            refill_cv.wait_for(pool_lock, error_backoff, [this] { return stop_workers; });
+            error_backoff = std::min(2 * error_backoff, KEY_POOL_ERROR_BACKOFF_MAX);
+        }
+
+    }
+
+}
+
+std::unique_ptr<rsa> rsa_key_pool::rsa_key_pool_try_acquire(size_t bit_size) {
+
+    std::lock_guard<std::mutex> pool_lock(pool_mutex);
+    return _rsa_key_pool_pop(_rsa_key_pool_get_entry(bit_size));
+
+}
+
+std::unique_ptr<rsa> rsa_key_pool::rsa_key_pool_acquire(size_t bit_size, std::chrono::milliseconds timeout) {
+
+    std::unique_lock<std::mutex> pool_lock(pool_mutex);
+    pool_entry &entry = _rsa_key_pool_get_entry(bit_size);
+
+    if (entry.keys.empty() == true) {
+        /* Make sure someone is working on it before waiting. */
+        entry.refilling = true;
+        refill_cv.notify_all();
+        key_ready_cv.wait_for(pool_lock, timeout, [&] { return stop_workers || entry.keys.empty() == false; });
+    }
+    return _rsa_key_pool_pop(entry);
+
+}
+
+std::vector<rsa_key_pool_stats> rsa_key_pool::rsa_key_pool_get_stats() const {
+
+    std::lock_guard<std::mutex> pool_lock(pool_mutex);
+
+    std::vector<rsa_key_pool_stats> stats;
+    stats.reserve(entries.size());
+    for (const auto &entry : entries) {
+        double refill_rate = 0.0;
+        if (entry.generation_seconds > 0.0) {
+            refill_rate = static_cast<double>(entry.total_generated) / entry.generation_seconds;
+        }
+        stats.push_back(rsa_key_pool_stats{entry.config.bit_size, entry.keys.size(), entry.in_flight, entry.refilling, \
+            entry.total_generated, entry.total_acquired, entry.acquire_misses, refill_rate});
+    }
+    return stats;
+
+}
@@ -0,0 +1,228 @@
+/**
+ *  @file   rsa_key_store.cc
+ *  @brief  Source file for the RSA key store
+ *
+ *  Store layout (all fields little endian):
+ *      u32 magic "RSKS", u32 version, u64 key count,
+ *      key count * {u64 key id, u64 blob offset, u64 blob length} sorted by key id,
+ *      key blobs as written by rsa::rsa_serialize.
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RSA_KEY_STORE_USE_MMAP      (1)
+#endif
+
+#include "rsa_key_store.hpp"
+
+namespace {
+
+    constexpr uint32_t  KEY_STORE_MAGIC             = 0x534B5352;
+    constexpr uint32_t  KEY_STORE_VERSION           = 1;
+    constexpr size_t    KEY_STORE_HEADER_SIZE       = 16;
+    constexpr size_t    KEY_STORE_INDEX_ENTRY_SIZE  = 24;
+
+    uint64_t load_u64(const uint8_t *src) {
+
+        uint64_t val = 0;
+        for (int i = 0; i < 8; ++i) {
+            val |= static_cast<uint64_t>(src[i]) << (8 * i);
+        }
+        return val;
+
+    }
+
+    void store_u64(uint8_t *dst, uint64_t val) {
+
+        for (int i = 0; i < 8; ++i) {
+            dst[i] = static_cast<uint8_t>(val >> (8 * i));
+        }
+
+    }
+
+}
+
+rsa_key_store::rsa_key_store(const std::string &path)
+:   file_data       {nullptr},
+    file_size       {0},
+    key_count       {0},
+    file_mapped     {false} {
+
+#if defined(RSA_KEY_STORE_USE_MMAP)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open RSA key store");
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+        close(fd);
+        throw std::runtime_error("Cannot open RSA key store");
+    }
+    file_size = static_cast<size_t>(file_stat.st_size);
+    void *mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map RSA key store");
+    }
+    /* Lookups jump around the file, read ahead would only pull in keys nobody asked for. */
+    madvise(mapping, file_size, MADV_RANDOM);
+    file_data = static_cast<const uint8_t *>(mapping);
+    file_mapped = true;
+#else
+    FILE *store_file = fopen(path.c_str(), "rb");
+    if (store_file == nullptr) {
+        throw std::runtime_error("Cannot open RSA key store");
+    }
+    uint8_t read_buff[4096];
+    size_t read_len;
+    while ((read_len = fread(read_buff, 1, sizeof(read_buff), store_file)) > 0) {
+        file_copy.insert(file_copy.end(), read_buff, read_buff + read_len);
+    }
+    fclose(store_file);
+    file_data = file_copy.data();
+    file_size = file_copy.size();
+#endif
+
+    /* Only the header is checked here, index entries are validated when looked up. */
+    if (file_size < KEY_STORE_HEADER_SIZE || load_u64(file_data) != (KEY_STORE_MAGIC | (static_cast<uint64_t>(KEY_STORE_VERSION) << 32))) {
+        _rsa_key_store_unmap();
+        throw std::invalid_argument("Not an RSA key store");
+    }
+    key_count = load_u64(file_data + 8);
+    if (key_count > (file_size - KEY_STORE_HEADER_SIZE) / KEY_STORE_INDEX_ENTRY_SIZE) {
+        _rsa_key_store_unmap();
+        throw std::invalid_argument("Truncated RSA key store index");
+    }
+
+}
+
+rsa_key_store::~rsa_key_store() {
+
+    _rsa_key_store_unmap();
+
+}
+
+void rsa_key_store::_rsa_key_store_unmap() {
+
+#if defined(RSA_KEY_STORE_USE_MMAP)
+    if (file_mapped) {
+        munmap(const_cast<uint8_t *>(file_data), file_size);
+        file_mapped = false;
+    }
+#endif
+
+}
+
+int rsa_key_store::rsa_key_store_write(const std::string &path, const std::vector<rsa_key_store_entry> &keys) {
+
+    std::vector<rsa_key_store_entry> sorted_keys(keys);
+    std::sort(sorted_keys.begin(), sorted_keys.end(), \
+        [](const rsa_key_store_entry &a, const rsa_key_store_entry &b) { return a.key_id < b.key_id; });
+    for (size_t i = 0; i < sorted_keys.size(); ++i) {
+        if (sorted_keys[i].key == nullptr || (i > 0 && sorted_keys[i].key_id == sorted_keys[i - 1].key_id)) {
+            return -1;
+        }
+    }
+
+    size_t blobs_offset = KEY_STORE_HEADER_SIZE + sorted_keys.size() * KEY_STORE_INDEX_ENTRY_SIZE;
+    std::vector<uint8_t> header_n_index(blobs_offset);
+    store_u64(header_n_index.data(), KEY_STORE_MAGIC | (static_cast<uint64_t>(KEY_STORE_VERSION) << 32));
+    store_u64(header_n_index.data() + 8, sorted_keys.size());
+
+    std::vector<uint8_t> blobs, key_blob;
+    for (size_t i = 0; i < sorted_keys.size(); ++i) {
+        if (sorted_keys[i].key->rsa_serialize(key_blob) != 0) {
+            return -1;
+        }
+        uint8_t *index_entry = header_n_index.data() + KEY_STORE_HEADER_SIZE + i * KEY_STORE_INDEX_ENTRY_SIZE;
+        store_u64(index_entry, sorted_keys[i].key_id);
+        store_u64(index_entry + 8, blobs_offset + blobs.size());
+        store_u64(index_entry + 16, key_blob.size());
+        blobs.insert(blobs.end(), key_blob.begin(), key_blob.end());
+    }
+
+    /* Write a temporary file and rename it, readers never see a half written store. */
+    std::string tmp_path = path + ".tmp";
+    FILE *store_file = fopen(tmp_path.c_str(), "wb");
+    if (store_file == nullptr) {
+        return -1;
+    }
+    bool write_ok = fwrite(header_n_index.data(), 1, header_n_index.size(), store_file) == header_n_index.size();
+    write_ok = write_ok && (blobs.empty() || fwrite(blobs.data(), 1, blobs.size(), store_file) == blobs.size());
+    write_ok = (fclose(store_file) == 0) && write_ok;
+    if (write_ok == false || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return -1;
+    }
+    return 0;
+
+}
+
+bool rsa_key_store::_rsa_key_store_find(uint64_t key_id, uint64_t &op_offset, uint64_t &op_length) const {
+
+    /* Binary search straight on the mapped index. */
+    const uint8_t *index = file_data + KEY_STORE_HEADER_SIZE;
+    uint64_t low = 0, high = key_count;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        const uint8_t *index_entry = index + mid * KEY_STORE_INDEX_ENTRY_SIZE;
+        uint64_t mid_id = load_u64(index_entry);
+        if (mid_id == key_id) {
+            op_offset = load_u64(index_entry + 8);
+            op_length = load_u64(index_entry + 16);
+            if (op_offset > file_size || op_length > file_size - op_offset) {
+                throw std::invalid_argument("RSA key store index points outside the file");
+            }
+            return true;
+        } else if (mid_id < key_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return false;
+
+}
+
+std::shared_ptr<rsa> rsa_key_store::rsa_key_store_get(uint64_t key_id) {
+
+    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+
+    auto loaded_key = loaded_keys.find(key_id);
+    if (loaded_key != loaded_keys.end()) {
+        return loaded_key->second;
+    }
+
+    uint64_t offset, length;
+    if (_rsa_key_store_find(key_id, offset, length) == false) {
+        return nullptr;
+    }
+    std::shared_ptr<rsa> key(rsa::rsa_deserialize(file_data + offset, length));
+    loaded_keys.emplace(key_id, key);
+    return key;
+
+}
+
+bool rsa_key_store::rsa_key_store_contains(uint64_t key_id) const {
+
+    uint64_t offset, length;
+    return _rsa_key_store_find(key_id, offset, length);
+
+}
+
+size_t rsa_key_store::rsa_key_store_size() const {
+
+    return static_cast<size_t>(key_count);
+
+}
@@ -0,0 +1,170 @@
+/**
+ *  @file   rsa_thread_pool.cc
+ *  @brief  Source file for the RSA worker thread pool
+ *
+ *  Task queue, workers and the range splitting used by the batch calls
+ *
+ *  @author         Tony Josi   https://github.com/tony-josi/rsa
+ *  @copyright      Copyright (C) 2021 Tony Josi
+ *  @bug            No known bugs.
+ */
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+#include "rsa_thread_pool.hpp"
+
+namespace {
+
+    /* State shared by the caller and the helper tasks of one parallel_for. Helpers that
+       only get to run after everything is done find no range left and never touch fn. */
+    struct parallel_for_state {
+        size_t                                              count;
+        size_t                                              grain;
+        const std::function<void(size_t, size_t)>           *fn;
+        std::mutex                                          state_mutex;
+        std::condition_variable                             done_cv;
+        size_t                                              next_begin;
+        size_t                                              in_progress;
+        std::exception_ptr                                  error;
+    };
+
+    void run_ranges(parallel_for_state &state) {
+
+        for (;;) {
+            size_t begin;
+            {
+                std::lock_guard<std::mutex> state_lock(state.state_mutex);
+                if (state.error != nullptr || state.next_begin >= state.count) {
+                    return;
+                }
+                begin = state.next_begin;
+                state.next_begin += state.grain;
+                ++state.in_progress;
+            }
+
+            std::exception_ptr error;
+            try {
+                (*state.fn)(begin, std::min(state.count, begin + state.grain));
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> state_lock(state.state_mutex);
+            if (error != nullptr && state.error == nullptr) {
+                state.error = error;
+            }
+            if (--state.in_progress == 0) {
+                state.done_cv.notify_all();
+            }
+        }
+
+    }
+
+}
+
+rsa_thread_pool::rsa_thread_pool(size_t no_of_threads)
+:   stop_workers    {false} {
+
+    if (no_of_threads == 0) {
+        no_of_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(no_of_threads);
+    for (size_t i = 0; i < no_of_threads; ++i) {
+        workers.emplace_back(&rsa_thread_pool::_rsa_thread_pool_worker, this);
+    }
+
+}
+
+rsa_thread_pool::~rsa_thread_pool() {
+
+    {
+        std::lock_guard<std::mutex> pool_lock(pool_mutex);
+        stop_workers = true;
+    }
+    task_cv.notify_all();
+
+    for (auto &t : workers) {
+        t.join();
+    }
+
+}
+
+void rsa_thread_pool::_rsa_thread_pool_worker() {
+
+    std::unique_lock<std::mutex> pool_lock(pool_mutex);
+    for (;;) {
+        task_cv.wait(pool_lock, [this] { return stop_workers || tasks.empty() == false; });
+        if (tasks.empty()) {
+            return;
+        }
+
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        pool_lock.unlock();
+        task();
+        pool_lock.lock();
+    }
+
+}
+
+size_t rsa_thread_pool::rsa_thread_pool_size() const {
+
+    return workers.size();
+
+}
+
+void rsa_thread_pool::rsa_thread_pool_post(std::function<void()> task) {
+
+    {
+        std::lock_guard<std::mutex> pool_lock(pool_mutex);
+        tasks.push_back(std::move(task));
+    }
+    task_cv.notify_one();
+
+}
+
+void rsa_thread_pool::rsa_thread_pool_parallel_for(
+    size_t count,
+    size_t grain,
+    const std::function<void(size_t begin, size_t end)> &fn) {
+
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    auto state = std::make_shared<parallel_for_state>();
+    state->count = count;
+    state->grain = grain;
+    state->fn = &fn;
+    state->next_begin = 0;
+    state->in_progress = 0;
+
+    /* No more helpers than there are ranges beyond the one the caller takes itself. */
+    size_t ranges = (count + grain - 1) / grain;
+    size_t helpers = std::min(workers.size(), ranges - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        rsa_thread_pool_post([state] { run_ranges(*state); });
+    }
+
+    /* The caller works too and only waits for ranges that are actually running, so a
+       parallel_for from inside a pool task can not dead lock on a busy pool. */
+    run_ranges(*state);
+
+    std::unique_lock<std::mutex> state_lock(state->state_mutex);
+    state->done_cv.wait(state_lock, [&state] { return state->in_progress == 0; });
+    if (state->error != nullptr) {
+        std::rethrow_exception(state->error);
+    }
+
+}
+
+rsa_thread_pool& rsa_thread_pool::rsa_thread_pool_default() {
+
+    static rsa_thread_pool default_pool;
+    return default_pool;
+
+}
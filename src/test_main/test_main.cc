@@ -9,9 +9,18 @@
  *  @bug            No known bugs.
  */
 
+#include <stdio.h>
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "rsa.hpp"
+#include "rsa_async.hpp"
+#include "rsa_batch.hpp"
+#include "rsa_key_store.hpp"
 
 int main () {
 
@@ -35,6 +44,138 @@ int main () {
     rsa_128.rsa_decrypt_textbook_method(cipher, decipher_tb);
     std::cout << "DECIPHER TB: " << decipher_tb.big_int_to_string() << "\n";
 
-    return 0;
+    /* One key shared by several threads without any locking. */
+    const rsa &shared_key = rsa_128;
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&shared_key, &mismatches, t] {
+            bi::big_int thread_plain, thread_cipher, thread_decipher;
+            for (int i = 0; i < 8; ++i) {
+                thread_plain.big_int_from_base_type(static_cast<BI_BASE_TYPE>(0x1000 * (t + 1) + i), false);
+                shared_key.rsa_encrypt(thread_plain, thread_cipher);
+                shared_key.rsa_decrypt(thread_cipher, thread_decipher);
+                if (thread_decipher.big_int_compare(thread_plain) != 0) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    std::cout << "SHARED KEY MISMATCHES: " << mismatches << "\n";
+
+    /* The same round trip without blocking the calling thread, and a key generation cancelled right away. */
+    std::shared_ptr<const rsa> async_key = std::make_shared<const rsa>(rsa_128);
+    rsa_async_result<bi::big_int> async_cipher = rsa_async::rsa_async_encrypt(async_key, plain).result.get();
+    rsa_async_result<bi::big_int> async_decipher = rsa_async::rsa_async_decrypt(async_key, async_cipher.value).result.get();
+    std::cout << "ASYNC DECIPHER: " << async_decipher.value.big_int_to_string() << "\n";
+
+    rsa_async_future<std::unique_ptr<rsa>> async_keygen = rsa_async::rsa_async_generate(4096);
+    async_keygen.handle.rsa_async_cancel();
+    int keygen_status = async_keygen.result.get().status;
+    std::cout << "ASYNC KEYGEN CANCELLED: " << (keygen_status == BI_STATUS_CANCELLED ? "yes" : "no") << "\n";
+
+    bool async_ok = async_decipher.status == 0 && async_decipher.value.big_int_compare(plain) == 0 && \
+        keygen_status == BI_STATUS_CANCELLED;
+
+    /* Prime search with sieving and Rabin-Miller on separate threads, checked with Fermat tests to bases 2 and 3. */
+    bi::big_int pipelined_prime, prime_minus_1, bi_1, fermat_base, fermat_res;
+    int pipelined_status = pipelined_prime.big_int_get_random_unsigned_prime_rabin_miller_pipelined(512, 20, 2, 2);
+    bool pipelined_ok = pipelined_status == 0;
+    bi_1.big_int_from_base_type(1, false);
+    pipelined_prime.big_int_unsigned_sub(bi_1, prime_minus_1);
+    for (BI_BASE_TYPE base = 2; base <= 3; ++base) {
+        fermat_base.big_int_from_base_type(base, false);
+        pipelined_ok = pipelined_ok && fermat_base.big_int_fast_modular_exponentiation(prime_minus_1, pipelined_prime, fermat_res) == 0 && \
+            fermat_res.big_int_compare(bi_1) == 0;
+    }
+    std::cout << "PIPELINED PRIME: " << pipelined_prime.big_int_to_string() << (pipelined_ok ? "" : " (FAILED)") << "\n";
+
+    /* Fiat batch decryption, a full batch through the product tree, a partial one slot by slot,
+       a full one decrypted in place and a full one holding a zero cipher. */
+    const size_t batch_size = 4;
+    rsa_batch batch(rsa_128, batch_size);
+    std::vector<bi::big_int> batch_plain(batch_size), batch_cipher(batch_size), batch_decipher(batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+        batch_plain[i].big_int_get_random_unsigned(modulus.big_int_get_num_of_bits() - 4);
+        batch.rsa_batch_encrypt(i, batch_plain[i], batch_cipher[i]);
+    }
+    auto batch_matches = [&batch_plain](const std::vector<bi::big_int> &op_plains, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (op_plains[i].big_int_compare(batch_plain[i]) != 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool batch_ok = batch.rsa_batch_decrypt(batch_cipher.data(), batch_decipher.data(), batch_size) == 0 && \
+        batch_matches(batch_decipher, batch_size);
+    batch_decipher.assign(batch_size, bi::big_int());
+    batch_ok = batch_ok && batch.rsa_batch_decrypt(batch_cipher.data(), batch_decipher.data(), batch_size - 1) == 0 && \
+        batch_matches(batch_decipher, batch_size - 1);
+    std::vector<bi::big_int> batch_in_place = batch_cipher;
+    batch_ok = batch_ok && batch.rsa_batch_decrypt(batch_in_place.data(), batch_in_place.data(), batch_size) == 0 && \
+        batch_matches(batch_in_place, batch_size);
+    batch_plain[1].big_int_set_zero();
+    batch_cipher[1].big_int_set_zero();
+    batch_ok = batch_ok && batch.rsa_batch_decrypt(batch_cipher.data(), batch_decipher.data(), batch_size) == 0 && \
+        batch_matches(batch_decipher, batch_size);
+    std::cout << "BATCH DECRYPT: " << (batch_ok ? "ok" : "FAILED") << "\n";
+
+    /* Key blob and key store round trips, corrupted or truncated data must be rejected. */
+    auto rejects_blob = [](const std::vector<uint8_t> &blob) {
+        try {
+            rsa::rsa_deserialize(blob.data(), blob.size());
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+        return false;
+    };
+    std::vector<uint8_t> key_blob;
+    bool store_ok = rsa_128.rsa_serialize(key_blob) == 0;
+    std::unique_ptr<rsa> blob_key = rsa::rsa_deserialize(key_blob.data(), key_blob.size());
+    bi::big_int blob_decipher;
+    store_ok = store_ok && blob_key->rsa_decrypt(cipher, blob_decipher) == 0 && blob_decipher.big_int_compare(plain) == 0;
+    std::vector<uint8_t> bad_blob = key_blob;
+    bad_blob[bad_blob.size() / 2] ^= 0x01;
+    store_ok = store_ok && rejects_blob(bad_blob);
+    bad_blob.assign(key_blob.begin(), key_blob.end() - 1);
+    store_ok = store_ok && rejects_blob(bad_blob);
+
+    const std::string store_path = "rsa_test_key_store.bin";
+    std::unique_ptr<rsa> public_only = rsa::rsa_import_public_key(modulus, pub_key);
+    store_ok = store_ok && rsa_key_store::rsa_key_store_write(store_path, {{7, &rsa_128}, {3, public_only.get()}}) == 0;
+    if (store_ok) {
+        rsa_key_store store(store_path);
+        std::shared_ptr<rsa> stored_key = store.rsa_key_store_get(7);
+        bi::big_int stored_decipher;
+        store_ok = store.rsa_key_store_size() == 2 && store.rsa_key_store_contains(3) && \
+            store.rsa_key_store_get(5) == nullptr && stored_key != nullptr && \
+            stored_key->rsa_decrypt(cipher, stored_decipher) == 0 && stored_decipher.big_int_compare(plain) == 0 && \
+            store.rsa_key_store_get(3)->rsa_has_private_key() == false;
+    }
+    std::vector<char> store_file;
+    {
+        std::ifstream store_in(store_path, std::ios::binary);
+        store_file.assign(std::istreambuf_iterator<char>(store_in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream store_out(store_path, std::ios::binary | std::ios::trunc);
+        store_out.write(store_file.data(), static_cast<std::streamsize>(store_file.size() / 2));
+    }
+    bool truncated_rejected = false;
+    try {
+        rsa_key_store truncated_store(store_path);
+        truncated_store.rsa_key_store_get(7);
+    } catch (const std::invalid_argument &) {
+        truncated_rejected = true;
+    }
+    store_ok = store_ok && truncated_rejected;
+    remove(store_path.c_str());
+    std::cout << "KEY STORE: " << (store_ok ? "ok" : "FAILED") << "\n";
+
+    return (mismatches == 0 && async_ok && pipelined_ok && batch_ok && store_ok) ? 0 : 1;
 
 }
\ No newline at end of file